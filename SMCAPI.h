@@ -8,6 +8,8 @@ The following are prohibited: changing and distributing the program code, sellin
 #include <vector>
 #include <memory>
 #include <algorithm>
+#include <iterator>
+#include <atomic>
 
 #ifndef SMCMODULEDEFINITIONPROVIDER_SMCAPI_H
 #define SMCMODULEDEFINITIONPROVIDER_SMCAPI_H
@@ -30,15 +32,42 @@ namespace SMCApi {
      */
     class CLASS_DECLSPEC ModuleException : public std::exception {
     private:
-        const std::wstring message;
+        const wchar_t* staticMessage;
+        std::wstring message;
 
     public:
         explicit ModuleException(const std::wstring& msg);
 
         explicit ModuleException(const std::wstring* pMsg);
 
+        /**
+         * exception without allocation, only for string literal (pointer is kept)
+         * getMessage of it gives string, which is kept once for each text until end of process
+         *
+         * @param msg                   string literal
+         */
+        template<size_t N>
+        explicit ModuleException(const wchar_t (&msg)[N]) : staticMessage(msg) {
+        }
+
+        /**
+         * not constant array (buffer) is copied
+         *
+         * @param msg                   null terminated string
+         */
+        template<size_t N>
+        explicit ModuleException(wchar_t (&msg)[N]) : ModuleException(std::wstring(msg)) {
+        }
+
         const std::wstring* getMessage() const;
 
+        /**
+         * message without allocation
+         *
+         * @return null terminated string
+         */
+        const wchar_t* getMessageText() const;
+
         ~ModuleException() override;
     };
 
@@ -80,9 +109,23 @@ namespace SMCApi {
      */
     class CLASS_DECLSPEC Number {
     private:
-        void* pValue;
+        /**
+         * primitive values are kept inline, BigInteger and BigDecimal - as string
+         */
+        union NumberValue {
+            signed char byteValue;
+            short shortValue;
+            long intValue;
+            long long int longValue;
+            float floatValue;
+            double doubleValue;
+            char* stringValue;
+        } value;
         NumberType type;
 
+        template<typename R>
+        R cast() const;
+
     public:
         explicit Number(signed char value);
 
@@ -100,6 +143,10 @@ namespace SMCApi {
 
         explicit Number(const Number* pNumber);
 
+        Number(const Number& number);
+
+        Number& operator=(const Number& number);
+
         ~Number();
 
         signed char byteValue();
@@ -117,6 +164,216 @@ namespace SMCApi {
         std::string toString();
 
         NumberType getType();
+
+        /**
+         * approximate size in memory with value, allocator overhead is not counted
+         *
+         * @return size in bytes
+         */
+        size_t getMemorySize() const;
+    };
+
+    /**
+     * shared read only bytes, value of OT_BYTES
+     * copy of buffer and slice do not copy bytes, only add reference (thread safe)
+     * bytes must not be changed after buffer is shared
+     *
+     * @version 1.0.0
+     */
+    class CLASS_DECLSPEC ByteBuffer {
+    private:
+        struct Block;
+
+        Block* block;
+        const signed char* data;
+        size_t size;
+
+        ByteBuffer(Block* block, const signed char* data, size_t size);
+
+    public:
+        /**
+         * empty buffer
+         */
+        ByteBuffer();
+
+        /**
+         * new buffer with zero bytes, fill it by getWritableData before share
+         *
+         * @param size                  size
+         */
+        explicit ByteBuffer(size_t size);
+
+        /**
+         * new buffer with copy of bytes
+         *
+         * @param data                  bytes
+         * @param size                  size
+         */
+        ByteBuffer(const signed char* data, size_t size);
+
+        /**
+         * buffer, which owns vector, without copy
+         *
+         * @param data                  bytes
+         */
+        explicit ByteBuffer(std::vector<signed char>&& data);
+
+        ByteBuffer(const ByteBuffer& buffer);
+
+        ByteBuffer(ByteBuffer&& buffer) noexcept;
+
+        ByteBuffer& operator=(const ByteBuffer& buffer);
+
+        ByteBuffer& operator=(ByteBuffer&& buffer) noexcept;
+
+        /**
+         * buffer, which owns array, without copy
+         *
+         * @param data                  array created by new[]
+         * @param size                  size
+         * @return ByteBuffer
+         */
+        static ByteBuffer adopt(signed char* data, size_t size);
+
+        const signed char* getData() const;
+
+        /**
+         * bytes for write, only for not shared buffer
+         *
+         * @return bytes
+         */
+        signed char* getWritableData();
+
+        size_t getSize() const;
+
+        bool isEmpty() const;
+
+        /**
+         * part of buffer without copy
+         *
+         * @param offset                start
+         * @param length                size of part
+         * @return ByteBuffer, shares bytes with this
+         */
+        ByteBuffer slice(size_t offset, size_t length) const;
+
+        /**
+         * count of buffers, which share bytes
+         *
+         * @return count, 0 for empty buffer
+         */
+        long countReferences() const;
+
+        /**
+         * approximate size in memory, shared bytes are counted in each buffer
+         *
+         * @return size in bytes
+         */
+        size_t getMemorySize() const;
+
+        ~ByteBuffer();
+    };
+
+    /**
+     * compact string, value of OT_STRING
+     * text is kept in UTF-8, wide string for std::wstring accessors is created on first request and kept until string is changed
+     * creation of wide string is thread safe, copy keeps only UTF-8
+     *
+     * @version 1.0.0
+     */
+    class CLASS_DECLSPEC Utf8String {
+    private:
+        std::string value;
+        mutable std::atomic<std::wstring*> wide;
+
+    public:
+        Utf8String();
+
+        /**
+         * @param value                 UTF-8 string
+         */
+        explicit Utf8String(const std::string& value);
+
+        /**
+         * @param value                 UTF-8 string, moved without copy
+         */
+        explicit Utf8String(std::string&& value);
+
+        /**
+         * @param data                  UTF-8 bytes
+         * @param size                  count of bytes
+         */
+        Utf8String(const char* data, size_t size);
+
+        /**
+         * @param value                 string, converted to UTF-8
+         */
+        explicit Utf8String(const std::wstring& value);
+
+        Utf8String(const Utf8String& value);
+
+        Utf8String(Utf8String&& value) noexcept;
+
+        Utf8String& operator=(const Utf8String& value);
+
+        Utf8String& operator=(Utf8String&& value) noexcept;
+
+        /**
+         * string, which owns wide string, pointer stays valid while string exists
+         * used for ObjectArray::add(const std::wstring*) and ObjectField::setValue(const std::wstring*)
+         *
+         * @param value                 string created by new
+         * @return Utf8String
+         */
+        static Utf8String adopt(std::wstring* value);
+
+        /**
+         * @return UTF-8 string
+         */
+        const std::string& getValue() const;
+
+        const char* getData() const;
+
+        /**
+         * @return count of bytes
+         */
+        size_t getSize() const;
+
+        bool isEmpty() const;
+
+        /**
+         * wide string, created on first call
+         *
+         * @return string, valid while this is not changed or deleted
+         */
+        const std::wstring* getWide() const;
+
+        /**
+         * detach wide string without delete
+         *
+         * @return wide string or null if it is not created, caller owns it
+         */
+        std::wstring* releaseWide();
+
+        /**
+         * free wide string, pointers returned by getWide become invalid
+         */
+        void compact();
+
+        bool operator==(const Utf8String& value) const;
+
+        bool operator!=(const Utf8String& value) const;
+
+        bool operator<(const Utf8String& value) const;
+
+        /**
+         * approximate size in memory, with wide string if it is created
+         *
+         * @return size in bytes
+         */
+        size_t getMemorySize() const;
+
+        ~Utf8String();
     };
 
     /**
@@ -151,10 +408,188 @@ namespace SMCApi {
 
     ValueType convertToValue(ObjectType type);
 
+    /**
+     * convert string to UTF-8
+     *
+     * @param value                 string
+     * @return UTF-8 string
+     */
+    CLASS_DECLSPEC std::string toUtf8(const std::wstring& value);
+
+    /**
+     * convert UTF-8 string to wide string
+     * wrong sequences are converted char by char
+     *
+     * @param value                 UTF-8 string
+     * @return string
+     */
+    CLASS_DECLSPEC std::wstring fromUtf8(const std::string& value);
+
+    /**
+     * convert part of string to UTF-8, ASCII is converted by blocks of 16 chars
+     *
+     * @param data                  chars
+     * @param size                  count of chars
+     * @param result                result, converted text is appended
+     */
+    CLASS_DECLSPEC void toUtf8(const wchar_t* data, size_t size, std::string& result);
+
+    /**
+     * convert UTF-8 bytes to wide string, ASCII is converted by blocks of 16 bytes
+     *
+     * @param data                  UTF-8 bytes
+     * @param size                  count of bytes
+     * @param result                result, converted text is appended
+     */
+    CLASS_DECLSPEC void fromUtf8(const char* data, size_t size, std::wstring& result);
+
     class CLASS_DECLSPEC ObjectElement;
 
     class CLASS_DECLSPEC ObjectArray;
 
+    class CLASS_DECLSPEC MemoryBudget;
+
+    /**
+     * C++ type of value of ObjectType (OT_VALUE_ANY - none)
+     *
+     * @version 1.0.0
+     */
+    template<ObjectType type>
+    struct ObjectTypeTraits;
+
+    template<>
+    struct ObjectTypeTraits<OT_OBJECT_ARRAY> {
+        typedef ObjectArray Type;
+    };
+
+    template<>
+    struct ObjectTypeTraits<OT_OBJECT_ELEMENT> {
+        typedef ObjectElement Type;
+    };
+
+    template<>
+    struct ObjectTypeTraits<OT_STRING> {
+        typedef Utf8String Type;
+    };
+
+    template<>
+    struct ObjectTypeTraits<OT_BYTE> {
+        typedef Number Type;
+    };
+
+    template<>
+    struct ObjectTypeTraits<OT_SHORT> {
+        typedef Number Type;
+    };
+
+    template<>
+    struct ObjectTypeTraits<OT_INTEGER> {
+        typedef Number Type;
+    };
+
+    template<>
+    struct ObjectTypeTraits<OT_LONG> {
+        typedef Number Type;
+    };
+
+    template<>
+    struct ObjectTypeTraits<OT_FLOAT> {
+        typedef Number Type;
+    };
+
+    template<>
+    struct ObjectTypeTraits<OT_DOUBLE> {
+        typedef Number Type;
+    };
+
+    template<>
+    struct ObjectTypeTraits<OT_BIG_INTEGER> {
+        typedef Number Type;
+    };
+
+    template<>
+    struct ObjectTypeTraits<OT_BIG_DECIMAL> {
+        typedef Number Type;
+    };
+
+    template<>
+    struct ObjectTypeTraits<OT_BYTES> {
+        typedef ByteBuffer Type;
+    };
+
+    template<>
+    struct ObjectTypeTraits<OT_BOOLEAN> {
+        typedef bool Type;
+    };
+
+    /**
+     * ObjectType as C++ type, given to functions of dispatchObjectType
+     *
+     * @version 1.0.0
+     */
+    template<ObjectType type>
+    struct ObjectTypeTag {
+        typedef typename ObjectTypeTraits<type>::Type Type;
+
+        static constexpr ObjectType value() {
+            return type;
+        }
+    };
+
+    /**
+     * call function with ObjectTypeTag of type, the only switch by ObjectType
+     * for OT_VALUE_ANY function is not called
+     *
+     * @param type                  ObjectType
+     * @param function              function (example: [&](auto tag) { typedef typename decltype(tag)::Type T; ... })
+     */
+    template<typename Function>
+    void dispatchObjectType(ObjectType type, Function&& function) {
+        switch (type) {
+        case OT_OBJECT_ARRAY:
+            function(ObjectTypeTag<OT_OBJECT_ARRAY>());
+            break;
+        case OT_OBJECT_ELEMENT:
+            function(ObjectTypeTag<OT_OBJECT_ELEMENT>());
+            break;
+        case OT_STRING:
+            function(ObjectTypeTag<OT_STRING>());
+            break;
+        case OT_BYTE:
+            function(ObjectTypeTag<OT_BYTE>());
+            break;
+        case OT_SHORT:
+            function(ObjectTypeTag<OT_SHORT>());
+            break;
+        case OT_INTEGER:
+            function(ObjectTypeTag<OT_INTEGER>());
+            break;
+        case OT_LONG:
+            function(ObjectTypeTag<OT_LONG>());
+            break;
+        case OT_FLOAT:
+            function(ObjectTypeTag<OT_FLOAT>());
+            break;
+        case OT_DOUBLE:
+            function(ObjectTypeTag<OT_DOUBLE>());
+            break;
+        case OT_BIG_INTEGER:
+            function(ObjectTypeTag<OT_BIG_INTEGER>());
+            break;
+        case OT_BIG_DECIMAL:
+            function(ObjectTypeTag<OT_BIG_DECIMAL>());
+            break;
+        case OT_BYTES:
+            function(ObjectTypeTag<OT_BYTES>());
+            break;
+        case OT_BOOLEAN:
+            function(ObjectTypeTag<OT_BOOLEAN>());
+            break;
+        case OT_VALUE_ANY:
+            break;
+        }
+    }
+
     /**
      * Interface for value objects
      *
@@ -220,19 +655,70 @@ namespace SMCApi {
         //    virtual ~IValue(){};
     };
 
+    /**
+     * process wide table of field names
+     * each name is stored once and is given by id, ids are never freed
+     * thread safe, getName is lock free
+     *
+     * @version 1.0.0
+     */
+    class CLASS_DECLSPEC SymbolTable {
+    public:
+        /**
+         * id of not existing name
+         */
+        static const unsigned int NOT_FOUND = 0xFFFFFFFF;
+
+        /**
+         * find id of name, add name if it is new
+         *
+         * @param name                  name
+         * @return id
+         */
+        static unsigned int intern(const std::wstring& name);
+
+        /**
+         * find id of name without adding
+         *
+         * @param name                  name
+         * @return id or NOT_FOUND
+         */
+        static unsigned int find(const std::wstring& name);
+
+        /**
+         * @param id                    id from intern
+         * @return name, valid until end of process
+         */
+        static const std::wstring& getName(unsigned int id);
+
+        /**
+         * @return count of names
+         */
+        static size_t size();
+    };
+
     /**
      * Field for Object
      * the value can be one of the following types: ObjectArray, ObjectElement, String, Byte, Short, Integer, Long, Float, Double, BigInteger, BigDecimal, byte[], bool.
      * value may be null
+     * bool and numbers (except BigInteger and BigDecimal), which are not set by pointer, are kept inline without allocation
      *
      * @version 1.0.0
      */
     class CLASS_DECLSPEC ObjectField {
     private:
-        std::wstring name;
-        void* pValue;
+        unsigned int nameId;
         ObjectType type;
+        void* pValue;
         size_t valueBytesLength;
+        alignas(Number) unsigned char inlineValue[sizeof(Number)];
+
+        bool isInline() const;
+
+        /**
+         * copy bool or number in inline storage, type should be set
+         */
+        void setInline(const void* value);
 
     public:
         ObjectField(const std::wstring& name);
@@ -243,20 +729,47 @@ namespace SMCApi {
 
         ObjectField(const std::wstring& name, const Number* value);
 
+        ObjectField(const std::wstring& name, const Number& value);
+
         ObjectField(const std::wstring& name, const signed char* value, size_t size);
 
+        ObjectField(const std::wstring& name, const ByteBuffer& value);
+
+        ObjectField(const std::wstring& name, const Utf8String& value);
+
         ObjectField(const std::wstring& name, bool value);
 
         ObjectField(const std::wstring& name, const ObjectArray* value);
 
         ObjectField(const std::wstring& name, const ObjectElement* value);
 
+        /**
+         * @param nameId                name id from SymbolTable
+         * @param type                  type, value is null
+         */
+        ObjectField(unsigned int nameId, ObjectType type);
+
         explicit ObjectField(const ObjectField* objectField);
 
+        ObjectField(const ObjectField& objectField);
+
+        ObjectField(ObjectField&& objectField) noexcept;
+
+        ObjectField& operator=(const ObjectField& objectField);
+
+        ObjectField& operator=(ObjectField&& objectField) noexcept;
+
         const std::wstring& getName() const;
 
         void setName(const std::wstring& name);
 
+        /**
+         * @return name id from SymbolTable
+         */
+        unsigned int getNameId() const;
+
+        void setNameId(unsigned int nameId);
+
         bool isNull();
 
         void setValueNull(ObjectType type);
@@ -265,8 +778,31 @@ namespace SMCApi {
 
         void setValue(const Number* value);
 
+        /**
+         * set copy of number, inline if possible
+         *
+         * @param value                 Number
+         */
+        void setValue(const Number& value);
+
         void setValue(const signed char* value, size_t size);
 
+        /**
+         * set bytes without copy
+         *
+         * @param value                 ByteBuffer
+         */
+        void setValue(const ByteBuffer& value);
+
+        /**
+         * set string in UTF-8 storage
+         *
+         * @param value                 Utf8String
+         */
+        void setValue(const Utf8String& value);
+
+        void setValue(Utf8String&& value);
+
         void setValue(bool value);
 
         void setValue(const ObjectArray* value);
@@ -277,59 +813,221 @@ namespace SMCApi {
 
         void setValue(IValue* value);
 
+        /**
+         * string as std::wstring, for UTF-8 storage it is converted on first call
+         *
+         * @return string
+         */
         const std::wstring* getValueString() const;
 
+        /**
+         * string without conversion
+         *
+         * @return Utf8String or null if value is null
+         */
+        const Utf8String* getValueUtf8() const;
+
         const Number* getValueNumber() const;
 
         const signed char* getValueBytes() const;
 
         size_t getBytesCount() const;
 
-        bool getValueBoolean() const;
+        /**
+         * bytes as shared buffer, copy of it does not copy bytes
+         *
+         * @return ByteBuffer or null if value is null
+         */
+        const ByteBuffer* getValueByteBuffer() const;
+
+        bool getValueBoolean() const;
+
+        const ObjectArray* getValueObjectArray() const;
+
+        const ObjectElement* getValueObjectElement() const;
+
+        /**
+         * get value without exception
+         *
+         * @return value or null if type is different or value is null
+         */
+        const std::wstring* tryGetValueString() const;
+
+        const Utf8String* tryGetValueUtf8() const;
+
+        const Number* tryGetValueNumber() const;
+
+        const signed char* tryGetValueBytes() const;
+
+        const bool* tryGetValueBoolean() const;
+
+        const ObjectArray* tryGetValueObjectArray() const;
 
-        const ObjectArray* getValueObjectArray() const;
+        const ObjectElement* tryGetValueObjectElement() const;
 
-        const ObjectElement* getValueObjectElement() const;
+        /**
+         * call visitor with value of real type, type is checked once
+         * visitor(const T* value, size_t size), T - ObjectTypeTraits<type>::Type, size - count of bytes for OT_BYTES, value is null for null
+         *
+         * @param visitor               visitor (example: generic lambda or struct with overloaded operator())
+         */
+        template<typename Visitor>
+        void visit(Visitor&& visitor) const {
+            dispatchObjectType(type, [&](auto tag) {
+                typedef typename decltype(tag)::Type T;
+                visitor((const T*)pValue, valueBytesLength);
+            });
+        }
 
+        /**
+         * value in form of previous versions: std::wstring for OT_STRING (created on first call), array of bytes (signed char) for OT_BYTES,
+         * for other types as getStoredValue
+         *
+         * @return value or null
+         */
         const void* getValue() const;
 
+        /**
+         * value as it is stored: Utf8String for OT_STRING, ByteBuffer for OT_BYTES, ObjectTypeTraits<type>::Type for other types
+         *
+         * @return value or null
+         */
+        const void* getStoredValue() const;
+
         ObjectType getType() const;
 
         bool isSimple();
 
         void deleteValue();
 
+        /**
+         * approximate size in memory with value (name is shared in SymbolTable), allocator overhead is not counted
+         *
+         * @return size in bytes
+         */
+        size_t getMemorySize() const;
+
         ~ObjectField();
     };
 
     /**
      * Object in ObjectArray
      * contain list of fields (ObjectField)
+     * fields are kept by value in one block (add, getField), getFields gives vector of pointers for compatibility
      *
      * @version 1.0.0
      */
     class CLASS_DECLSPEC ObjectElement {
     private:
-        std::vector<ObjectField*> fields;
+        std::vector<ObjectField> values;
+        std::vector<ObjectField*>* pFields;
 
     public:
+        /**
+         * element with separate fields, element owns them
+         *
+         * @param fields                fields
+         */
         explicit ObjectElement(const std::vector<ObjectField*>& fields);
 
         explicit ObjectElement(const ObjectElement* objectElement);
 
         explicit ObjectElement();
 
+        /**
+         * fields as vector of pointers, vector may be changed, element owns fields in it
+         * on first call fields are moved from block to separate objects and element works with vector after it,
+         * so pointers to fields returned before (getField, findField, add) become invalid, get them again after first call
+         *
+         * @return vector of fields
+         */
         std::vector<ObjectField*>* getFields();
 
+        size_t size() const;
+
+        ObjectField* getField(int id);
+
+        const ObjectField* getField(int id) const;
+
+        /**
+         * add field, pointers to fields of element are valid until next add or remove
+         *
+         * @param field                 field
+         * @return added field
+         */
+        ObjectField* add(ObjectField&& field);
+
+        /**
+         * reserve place for fields
+         *
+         * @param count                 count of fields
+         */
+        void reserve(size_t count);
+
+        void remove(int id);
+
+        void clear();
+
         ObjectField* findField(const std::wstring& name);
 
+        /**
+         * find field by name id, without string comparison
+         *
+         * @param nameId                name id from SymbolTable
+         * @return ObjectField or null
+         */
+        ObjectField* findField(unsigned int nameId);
+
         ObjectField* findFieldIgnoreCase(const std::wstring& name);
 
         bool isSimple();
 
+        /**
+         * approximate size in memory with all fields, allocator overhead is not counted
+         *
+         * @return size in bytes
+         */
+        size_t getMemorySize() const;
+
         ~ObjectElement();
     };
 
+    /**
+     * receiver of changes of ObjectArray (example: index), called in thread which changes array
+     *
+     * @version 1.0.0
+     */
+    class CLASS_DECLSPEC ObjectArrayObserver {
+    public:
+        /**
+         * item is added
+         *
+         * @param type                  type of item
+         * @param value                 value
+         */
+        virtual void added(ObjectType type, const void* value) = 0;
+
+        /**
+         * item will be removed, value is still valid
+         *
+         * @param type                  type of item
+         * @param value                 value
+         */
+        virtual void removed(ObjectType type, const void* value) = 0;
+
+        /**
+         * all items will be removed
+         */
+        virtual void cleared() = 0;
+
+        /**
+         * array is deleted, observer is not called after it
+         */
+        virtual void detached() = 0;
+
+        virtual ~ObjectArrayObserver() = default;
+    };
+
     /**
      * array of objects
      * main class
@@ -344,13 +1042,49 @@ namespace SMCApi {
         std::vector<ObjectType>* types;
         std::vector<size_t>* sizes;
         ObjectType type;
+        size_t itemsMemorySize;
+        size_t chargedMemorySize;
+        MemoryBudget* pMemoryBudget;
+        std::vector<ObjectArrayObserver*>* observers;
 
         void add(void* pValue, ObjectType type, int id = -1, size_t size = 0);
 
+        /**
+         * add value, memory budget is checked before, value is owned by array after call (also on exception)
+         */
+        void addChecked(void* pValue, ObjectType type, int id, size_t size, size_t itemSize);
+
         void addCopy(void* pValue, ObjectType type, size_t size = 0);
 
+        void addRange(void* const* values, size_t count, ObjectType type, const ObjectType* valueTypes, const size_t* valueSizes, int id);
+
+        /**
+         * add values, memory budget is checked before, values are owned by array after call (also on exception)
+         */
+        void addRangeChecked(void* const* values, size_t count, ObjectType type, const ObjectType* valueTypes, const size_t* valueSizes, int id,
+                             size_t itemsSize);
+
+        void deleteValue(int id);
+
         void deleteItem(int id);
 
+        ObjectType getItemType(int id) const;
+
+        size_t getItemMemorySize(int id) const;
+
+        void updateMemoryBudget();
+
+        void notifyAdded(size_t from, size_t count) const;
+
+        void notifyRemoved(size_t from, size_t count) const;
+
+        template<typename Tag, typename Visitor>
+        void visitItems(Tag, Visitor& visitor) const {
+            typedef typename Tag::Type T;
+            for (size_t i = 0; i < objects.size(); i++)
+                visitor((int)i, (const T*)objects[i], sizes && sizes->size() > i ? (*sizes)[i] : 0);
+        }
+
     public:
         explicit ObjectArray(ObjectType type);
 
@@ -364,34 +1098,246 @@ namespace SMCApi {
 
         void add(const signed char* value, size_t size, int id = -1);
 
+        /**
+         * add bytes without copy
+         *
+         * @param value                 ByteBuffer
+         * @param id                    position or -1 for end
+         */
+        void add(const ByteBuffer& value, int id = -1);
+
+        /**
+         * add string in UTF-8 storage
+         *
+         * @param value                 Utf8String
+         * @param id                    position or -1 for end
+         */
+        void add(const Utf8String& value, int id = -1);
+
+        void add(Utf8String&& value, int id = -1);
+
         void add(const bool value, int id = -1);
 
         void add(const ObjectArray* value, int id = -1);
 
         void add(const ObjectElement* value, int id = -1);
 
+        /**
+         * add many values in one pass, array owns values (like single add)
+         *
+         * @param values                values
+         * @param count                 count of values
+         * @param id                    position of first value or -1 for end
+         */
+        void add(const std::wstring* const* values, size_t count, int id = -1);
+
+        void add(const Number* const* values, size_t count, int id = -1);
+
+        /**
+         * arrays (created by new[]) are owned by array after call, if memory budget is exceeded (exception) they are still owned by caller
+         *
+         * @param values                values
+         * @param valueSizes            size of each value
+         * @param count                 count of values
+         * @param id                    position of first value or -1 for end
+         */
+        void add(const signed char* const* values, const size_t* valueSizes, size_t count, int id = -1);
+
+        void add(const bool* values, size_t count, int id = -1);
+
+        /**
+         * add copies of strings in UTF-8 storage
+         *
+         * @param values                values
+         * @param count                 count of values
+         * @param id                    position of first value or -1 for end
+         */
+        void add(const Utf8String* values, size_t count, int id = -1);
+
+        void add(const ObjectArray* const* values, size_t count, int id = -1);
+
+        void add(const ObjectElement* const* values, size_t count, int id = -1);
+
+        /**
+         * add values from forward iterators in one pass (pointers or bool), array owns values
+         *
+         * @param begin                 first value
+         * @param end                   end
+         * @param id                    position of first value or -1 for end
+         */
+        template<typename Iterator>
+        void addAll(Iterator begin, Iterator end, int id = -1) {
+            typedef typename std::iterator_traits<Iterator>::value_type Item;
+            size_t count = (size_t)std::distance(begin, end);
+            std::unique_ptr<Item[]> values(new Item[count]);
+            std::copy(begin, end, values.get());
+            add(values.get(), count, id);
+        }
+
+        /**
+         * reserve place for items
+         *
+         * @param count                 count of items
+         */
+        void reserve(size_t count);
+
+        /**
+         * string as std::wstring, for UTF-8 storage it is converted on first call
+         *
+         * @param id                    id
+         * @return string
+         */
         const std::wstring* getString(int id) const;
 
+        /**
+         * string without conversion
+         *
+         * @param id                    id
+         * @return Utf8String or null if value is null
+         */
+        const Utf8String* getUtf8(int id) const;
+
         const Number* getNumber(int id) const;
 
         const signed char* getBytes(int id) const;
 
         const size_t getBytesCount(int id) const;
 
+        /**
+         * bytes as shared buffer, copy of it does not copy bytes
+         *
+         * @param id                    id
+         * @return ByteBuffer or null if value is null
+         */
+        const ByteBuffer* getByteBuffer(int id) const;
+
         bool getBoolean(int id) const;
 
         const ObjectArray* getObjectArray(int id) const;
 
         const ObjectElement* getObjectElement(int id) const;
 
+        /**
+         * value in form of previous versions: std::wstring for OT_STRING (created on first call), array of bytes (signed char) for OT_BYTES,
+         * for other types as getStored
+         *
+         * @param id                    id
+         * @return value or null
+         */
         const void* get(int id) const;
 
+        /**
+         * value as it is stored: Utf8String for OT_STRING, ByteBuffer for OT_BYTES, ObjectTypeTraits<type>::Type for other types
+         *
+         * @param id                    id
+         * @return value or null
+         */
+        const void* getStored(int id) const;
+
+        /**
+         * get value without exception
+         *
+         * @param id                    id
+         * @return value or null if id is wrong, type is different or value is null
+         */
+        const std::wstring* tryGetString(int id) const;
+
+        const Utf8String* tryGetUtf8(int id) const;
+
+        const Number* tryGetNumber(int id) const;
+
+        const signed char* tryGetBytes(int id) const;
+
+        const bool* tryGetBoolean(int id) const;
+
+        const ObjectArray* tryGetObjectArray(int id) const;
+
+        const ObjectElement* tryGetObjectElement(int id) const;
+
+        /**
+         * call visitor for each item with value of real type
+         * type of array is resolved once, for OT_VALUE_ANY type is resolved for each item
+         * visitor(int id, const T* value, size_t size), T - ObjectTypeTraits<type>::Type, size - count of bytes for OT_BYTES
+         *
+         * @param visitor               visitor (example: generic lambda or struct with overloaded operator())
+         */
+        template<typename Visitor>
+        void visit(Visitor&& visitor) const {
+            if (types == nullptr) {
+                dispatchObjectType(type, [&](auto tag) {
+                    visitItems(tag, visitor);
+                });
+                return;
+            }
+            for (size_t i = 0; i < objects.size(); i++) {
+                dispatchObjectType((*types)[i], [&](auto tag) {
+                    typedef typename decltype(tag)::Type T;
+                    visitor((int)i, (const T*)objects[i], sizes && sizes->size() > i ? (*sizes)[i] : 0);
+                });
+            }
+        }
+
         void remove(int id);
 
+        /**
+         * remove items in one pass
+         *
+         * @param from                  first id
+         * @param to                    end id (not removed)
+         */
+        void remove(int from, int to);
+
+        /**
+         * remove all items
+         */
+        void clear();
+
+        /**
+         * change order of items, values are not copied, items which are not in order are removed
+         *
+         * @param order                 ids of items in new order, each id not more than once
+         */
+        void reorder(const std::vector<size_t>& order);
+
         ObjectType getType(int id = -1);
 
         bool isSimple();
 
+        /**
+         * approximate size in memory with all items, allocator overhead is not counted
+         * size is kept on add and remove, changes of nested elements and arrays after add are not counted (see recalculateMemorySize)
+         *
+         * @return size in bytes
+         */
+        size_t getMemorySize() const;
+
+        /**
+         * calculate size by walk of all items, sizes of nested arrays (items and fields of elements on any level) are calculated too
+         *
+         * @return size in bytes
+         */
+        size_t recalculateMemorySize();
+
+        /**
+         * count size of array in budget, on add and remove budget is updated
+         * budget should live longer than array or be replaced by null
+         *
+         * @param budget                MemoryBudget or null
+         */
+        void setMemoryBudget(MemoryBudget* budget);
+
+        MemoryBudget* getMemoryBudget() const;
+
+        /**
+         * add receiver of changes, observer should live longer than array or be removed
+         * observers are not copied with array
+         *
+         * @param observer              ObjectArrayObserver
+         */
+        void addObserver(ObjectArrayObserver* observer);
+
+        void removeObserver(ObjectArrayObserver* observer);
+
         ~ObjectArray();
     };
 
@@ -1517,6 +2463,113 @@ namespace SMCApi {
         virtual void removeFilter(long) = 0;
     };
 
+    class CLASS_DECLSPEC IFileTool;
+
+    /**
+     * sequential reader of file data
+     * after work need call close
+     *
+     * @version 1.0.0
+     */
+    class CLASS_DECLSPEC IFileReader {
+    public:
+        /**
+         * read next part of file
+         *
+         * @param buffer                buffer for data
+         * @param size                  buffer size
+         * @return count of read bytes, 0 if end of file
+         */
+        virtual size_t read(char*, size_t) = 0;
+
+        /**
+         * skip part of file
+         *
+         * @param size                  count bytes for skip
+         * @return count of skipped bytes
+         */
+        virtual size_t skip(size_t) = 0;
+
+        /**
+         * current position in file
+         *
+         * @return size_t
+         */
+        virtual size_t position() = 0;
+
+        /**
+         * release reader
+         * object is invalid after call
+         */
+        virtual void close() = 0;
+    };
+
+    /**
+     * memory mapped view of part of file
+     * data is valid until close
+     *
+     * @version 1.0.0
+     */
+    class CLASS_DECLSPEC IFileMapping {
+    public:
+        /**
+         * mapped data
+         *
+         * @return pointer to first byte of the view
+         */
+        virtual const char* getData() = 0;
+
+        /**
+         * view size
+         *
+         * @return size_t
+         */
+        virtual size_t length() = 0;
+
+        /**
+         * offset of view in file
+         *
+         * @return size_t
+         */
+        virtual size_t offset() = 0;
+
+        /**
+         * unmap view
+         * object is invalid after call
+         */
+        virtual void close() = 0;
+    };
+
+    /**
+     * lazy iterator over files in folder
+     * after work need call close
+     *
+     * @version 1.0.0
+     */
+    class CLASS_DECLSPEC IFileIterator {
+    public:
+        /**
+         * is has next file
+         *
+         * @return true if next return file
+         */
+        virtual bool hasNext() = 0;
+
+        /**
+         * get next file
+         * file is valid until next call or close
+         *
+         * @return IFileTool or null
+         */
+        virtual IFileTool* next() = 0;
+
+        /**
+         * release iterator
+         * object is invalid after call
+         */
+        virtual void close() = 0;
+    };
+
     /**
  * tool for work with unmodifiable files
  *
@@ -1575,6 +2628,44 @@ namespace SMCApi {
         virtual void* loadAsLibrary() = 0;
 
         //    virtual ~IFileTool() {};
+
+        /**
+         * read part of file
+         * not load all file in memory
+         *
+         * @param offset                start position in file
+         * @param buffer                buffer for data
+         * @param size                  buffer size
+         * @return count of read bytes, 0 if offset out of file
+         */
+        virtual size_t read(size_t, char*, size_t) = 0;
+
+        /**
+         * open sequential reader from begin of file
+         *
+         * @return IFileReader
+         * @throws ModuleException if file not exist or it is directory
+         */
+        virtual IFileReader* getReader() = 0;
+
+        /**
+         * map part of file in memory (read only)
+         * pages are loaded on access, so resident memory depends only on really used data
+         *
+         * @param offset                start position in file
+         * @param size                  view size, if 0 - to end of file
+         * @return IFileMapping
+         * @throws ModuleException if file not exist, it is directory or range out of file
+         */
+        virtual IFileMapping* map(size_t, size_t) = 0;
+
+        /**
+         * get files in folder
+         * files are read on demand, without creating list of all files
+         *
+         * @return IFileIterator
+         */
+        virtual IFileIterator* getChildrensIterator() = 0;
     };
 
     /**
@@ -5,323 +5,698 @@ The following are prohibited: changing and distributing the program code, sellin
 */
 
 #include "SMCApi.h"
+#include "SMCApiMemory.h"
+#include "SMCApiValue.h"
+#include <atomic>
 #include <cstring>
-
-SMCApi::Number::Number(const signed char value) {
-    type = NumberType::NT_BYTE;
-    auto* valueInternal = new signed char;
-    *valueInternal = value;
-    pValue = valueInternal;
+#include <cwchar>
+#include <functional>
+#include <mutex>
+#include <unordered_set>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SMCAPI_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace {
+    template<typename String>
+    size_t stringMemorySize(const String& value) {
+        auto begin = (const char*)&value;
+        auto data = (const char*)value.data();
+        if (data >= begin && data < begin + sizeof(value))
+            return sizeof(String);
+        return sizeof(String) + (value.capacity() + 1) * sizeof(typename String::value_type);
+    }
+
+#ifdef SMCAPI_SSE2
+    /**
+     * convert 16 chars to bytes if all are ASCII
+     */
+    bool packAscii(const wchar_t* data, char* result) {
+#if WCHAR_MAX > 0xFFFF
+        __m128i a = _mm_loadu_si128((const __m128i*)data);
+        __m128i b = _mm_loadu_si128((const __m128i*)(data + 4));
+        __m128i c = _mm_loadu_si128((const __m128i*)(data + 8));
+        __m128i d = _mm_loadu_si128((const __m128i*)(data + 12));
+        __m128i high = _mm_and_si128(_mm_or_si128(_mm_or_si128(a, b), _mm_or_si128(c, d)), _mm_set1_epi32(~0x7F));
+        if (_mm_movemask_epi8(_mm_cmpeq_epi32(high, _mm_setzero_si128())) != 0xFFFF)
+            return false;
+        _mm_storeu_si128((__m128i*)result, _mm_packus_epi16(_mm_packs_epi32(a, b), _mm_packs_epi32(c, d)));
+#else
+        __m128i a = _mm_loadu_si128((const __m128i*)data);
+        __m128i b = _mm_loadu_si128((const __m128i*)(data + 8));
+        __m128i high = _mm_and_si128(_mm_or_si128(a, b), _mm_set1_epi16((short)0xFF80));
+        if (_mm_movemask_epi8(_mm_cmpeq_epi16(high, _mm_setzero_si128())) != 0xFFFF)
+            return false;
+        _mm_storeu_si128((__m128i*)result, _mm_packus_epi16(a, b));
+#endif
+        return true;
+    }
+
+    /**
+     * convert 16 bytes to chars if all are ASCII
+     */
+    bool widenAscii(const unsigned char* data, wchar_t* result) {
+        __m128i value = _mm_loadu_si128((const __m128i*)data);
+        if (_mm_movemask_epi8(value) != 0)
+            return false;
+        __m128i zero = _mm_setzero_si128();
+        __m128i low = _mm_unpacklo_epi8(value, zero);
+        __m128i high = _mm_unpackhi_epi8(value, zero);
+#if WCHAR_MAX > 0xFFFF
+        _mm_storeu_si128((__m128i*)result, _mm_unpacklo_epi16(low, zero));
+        _mm_storeu_si128((__m128i*)(result + 4), _mm_unpackhi_epi16(low, zero));
+        _mm_storeu_si128((__m128i*)(result + 8), _mm_unpacklo_epi16(high, zero));
+        _mm_storeu_si128((__m128i*)(result + 12), _mm_unpackhi_epi16(high, zero));
+#else
+        _mm_storeu_si128((__m128i*)result, low);
+        _mm_storeu_si128((__m128i*)(result + 8), high);
+#endif
+        return true;
+    }
+#endif
+
+    bool isNumber(SMCApi::ObjectType type) {
+        return type >= SMCApi::ObjectType::OT_BYTE && type <= SMCApi::ObjectType::OT_BIG_DECIMAL;
+    }
+
+    /**
+     * value is kept in ObjectField without allocation
+     */
+    bool isInlineType(SMCApi::ObjectType type) {
+        return type == SMCApi::ObjectType::OT_BOOLEAN || (isNumber(type) && type != SMCApi::ObjectType::OT_BIG_INTEGER &&
+                                                          type != SMCApi::ObjectType::OT_BIG_DECIMAL);
+    }
+
+    template<typename T>
+    size_t memorySize(const T* value, size_t) {
+        return value->getMemorySize();
+    }
+
+    template<>
+    size_t memorySize<bool>(const bool*, size_t) {
+        return sizeof(bool);
+    }
+
+    template<typename T>
+    void* copyValue(const T* value, size_t) {
+        return new T(value);
+    }
+
+    template<>
+    void* copyValue<SMCApi::Utf8String>(const SMCApi::Utf8String* value, size_t) {
+        return new SMCApi::Utf8String(*value);
+    }
+
+    template<>
+    void* copyValue<SMCApi::ByteBuffer>(const SMCApi::ByteBuffer* value, size_t) {
+        return new SMCApi::ByteBuffer(*value);
+    }
+
+    template<>
+    void* copyValue<bool>(const bool* value, size_t) {
+        return new bool(*value);
+    }
+
+    template<typename T>
+    void destroyValue(T* value) {
+        delete value;
+    }
+
+    size_t valueMemorySize(const void* pValue, SMCApi::ObjectType type, size_t size) {
+        size_t result = 0;
+        if (pValue != nullptr) {
+            SMCApi::dispatchObjectType(type, [&](auto tag) {
+                result = memorySize((const typename decltype(tag)::Type*)pValue, size);
+            });
+        }
+        return result;
+    }
+
+    /**
+     * deep copy of value, bytes are shared (ByteBuffer is immutable after creation), strings keep only UTF-8
+     */
+    void* copyValue(const void* pValue, SMCApi::ObjectType type, size_t size) {
+        void* result = nullptr;
+        if (pValue != nullptr) {
+            SMCApi::dispatchObjectType(type, [&](auto tag) {
+                result = copyValue((const typename decltype(tag)::Type*)pValue, size);
+            });
+        }
+        return result;
+    }
+
+    void destroyValue(void* pValue, SMCApi::ObjectType type) {
+        if (pValue == nullptr)
+            return;
+        SMCApi::dispatchObjectType(type, [&](auto tag) {
+            destroyValue((typename decltype(tag)::Type*)pValue);
+        });
+    }
+
+    /**
+     * recalculate sizes of arrays in fields of element and of its nested elements
+     */
+    void recalculateElement(const SMCApi::ObjectElement* element) {
+        size_t count = element->size();
+        for (size_t i = 0; i < count; i++) {
+            const SMCApi::ObjectField* field = element->getField((int)i);
+            if (const SMCApi::ObjectArray* array = field->tryGetValueObjectArray())
+                const_cast<SMCApi::ObjectArray*>(array)->recalculateMemorySize();
+            else if (const SMCApi::ObjectElement* nested = field->tryGetValueObjectElement())
+                recalculateElement(nested);
+        }
+    }
 }
 
-SMCApi::Number::Number(const short value) {
-    type = NumberType::NT_SHORT;
-    auto* valueInternal = new short;
-    *valueInternal = value;
-    pValue = valueInternal;
-}
+namespace {
+    const unsigned int SYMBOL_CHUNK_BITS = 10;
+    const unsigned int SYMBOL_CHUNK_SIZE = 1u << SYMBOL_CHUNK_BITS;
+    const unsigned int SYMBOL_CHUNKS = 4096;
+    const size_t SYMBOL_SHARDS = 16;
 
-SMCApi::Number::Number(const long value) {
-    type = NumberType::NT_INTEGER;
-    auto* valueInternal = new long;
-    *valueInternal = value;
-    pValue = valueInternal;
-}
+    /**
+     * open addressing table of ids (id + 1, 0 - empty slot), names are read from chunks
+     */
+    struct SymbolShard {
+        std::mutex mutex;
+        std::vector<unsigned int> slots;
+        size_t count;
 
-SMCApi::Number::Number(const long long int value) {
-    type = NumberType::NT_LONG;
-    auto* valueInternal = new long long int;
-    *valueInternal = value;
-    pValue = valueInternal;
-}
+        SymbolShard() : slots(64, 0), count(0) {
+        }
+    };
+
+    /**
+     * names are kept in chunks which are never moved, so getName does not lock
+     */
+    struct SymbolStorage {
+        std::atomic<std::wstring*> chunks[SYMBOL_CHUNKS];
+        std::atomic<unsigned int> count;
+        std::mutex chunksMutex;
+        SymbolShard shards[SYMBOL_SHARDS];
+
+        SymbolStorage() : count(0) {
+            for (auto& chunk : chunks)
+                chunk.store(nullptr, std::memory_order_relaxed);
+        }
 
-SMCApi::Number::Number(const float value) {
-    type = NumberType::NT_FLOAT;
-    auto* valueInternal = new float;
-    *valueInternal = value;
-    pValue = valueInternal;
-}
+        const std::wstring& get(unsigned int id) const {
+            return chunks[id >> SYMBOL_CHUNK_BITS].load(std::memory_order_acquire)[id & (SYMBOL_CHUNK_SIZE - 1)];
+        }
 
-SMCApi::Number::Number(const double value) {
-    type = NumberType::NT_DOUBLE;
-    auto* valueInternal = new double;
-    *valueInternal = value;
-    pValue = valueInternal;
-}
+        std::wstring* getSlot(unsigned int id) {
+            std::atomic<std::wstring*>& chunk = chunks[id >> SYMBOL_CHUNK_BITS];
+            std::wstring* result = chunk.load(std::memory_order_acquire);
+            if (result == nullptr) {
+                std::lock_guard<std::mutex> lock(chunksMutex);
+                result = chunk.load(std::memory_order_relaxed);
+                if (result == nullptr) {
+                    result = new std::wstring[SYMBOL_CHUNK_SIZE];
+                    chunk.store(result, std::memory_order_release);
+                }
+            }
+            return result + (id & (SYMBOL_CHUNK_SIZE - 1));
+        }
 
-SMCApi::Number::Number(const SMCApi::NumberType type, char* valueString) {
-    Number::type = type;
-    pValue = valueString;
-}
+        /**
+         * position of name in shard slots, slot is empty if name is not found
+         */
+        size_t findSlot(const SymbolShard& shard, const std::wstring& name, size_t hash) const {
+            size_t mask = shard.slots.size() - 1;
+            size_t position = (hash / SYMBOL_SHARDS) & mask;
+            while (shard.slots[position] != 0 && get(shard.slots[position] - 1) != name)
+                position = (position + 1) & mask;
+            return position;
+        }
 
-SMCApi::Number::Number(const SMCApi::Number* pNumber) {
-    type = pNumber->type;
-    switch (type) {
-    case NumberType::NT_BYTE: {
-        auto* valueInternal = new signed char;
-        *valueInternal = *((signed char*)pNumber->pValue);
-        pValue = valueInternal;
-        break;
-    }
-    case NumberType::NT_SHORT: {
-        auto* valueInternal = new short;
-        *valueInternal = *((short*)pNumber->pValue);
-        pValue = valueInternal;
-        break;
-    }
-    case NumberType::NT_INTEGER: {
-        auto* valueInternal = new long;
-        *valueInternal = *((long*)pNumber->pValue);
-        pValue = valueInternal;
-        break;
-    }
-    case NumberType::NT_LONG: {
-        auto* valueInternal = new long long int;
-        *valueInternal = *((long long int*)pNumber->pValue);
-        pValue = valueInternal;
-        break;
-    }
-    case NumberType::NT_BIG_INTEGER: {
-        size_t size = strlen((char*)pNumber->pValue);
-        pValue = new char[size + 1];
-        ((char*)pValue)[size] = 0;
-        memcpy(pValue, pNumber->pValue, size);
-        break;
-    }
-    case NumberType::NT_FLOAT: {
-        auto* valueInternal = new float;
-        *valueInternal = *((float*)pNumber->pValue);
-        pValue = valueInternal;
-        break;
+        void grow(SymbolShard& shard) {
+            std::vector<unsigned int> slots(shard.slots.size() * 2, 0);
+            size_t mask = slots.size() - 1;
+            for (unsigned int slot : shard.slots) {
+                if (slot == 0)
+                    continue;
+                size_t position = (std::hash<std::wstring>()(get(slot - 1)) / SYMBOL_SHARDS) & mask;
+                while (slots[position] != 0)
+                    position = (position + 1) & mask;
+                slots[position] = slot;
+            }
+            shard.slots.swap(slots);
+        }
+    };
+
+    /**
+     * last found names of thread, checked without lock
+     */
+    struct SymbolCacheEntry {
+        size_t hash;
+        unsigned int slot;
+    };
+
+    const size_t SYMBOL_CACHE_SIZE = 256;
+
+    thread_local SymbolCacheEntry symbolCache[SYMBOL_CACHE_SIZE] = {};
+
+    SymbolStorage& getSymbolStorage() {
+        // not deleted, names may be used by static objects until end of process
+        static SymbolStorage* storage = new SymbolStorage();
+        return *storage;
     }
-    case NumberType::NT_DOUBLE: {
-        auto* valueInternal = new double;
-        *valueInternal = *((double*)pNumber->pValue);
-        pValue = valueInternal;
-        break;
+
+    /**
+     * messages of ModuleException created from literals, each text is kept once
+     */
+    struct LiteralMessages {
+        std::mutex mutex;
+        std::unordered_set<std::wstring> messages;
+    };
+
+    LiteralMessages& getLiteralMessages() {
+        // not deleted, messages may be used by static objects until end of process
+        static LiteralMessages* literalMessages = new LiteralMessages();
+        return *literalMessages;
+    }
+}
+
+unsigned int SMCApi::SymbolTable::intern(const std::wstring& name) {
+    SymbolStorage& storage = getSymbolStorage();
+    size_t hash = std::hash<std::wstring>()(name);
+    SymbolCacheEntry& cached = symbolCache[hash % SYMBOL_CACHE_SIZE];
+    if (cached.slot != 0 && cached.hash == hash && storage.get(cached.slot - 1) == name)
+        return cached.slot - 1;
+    SymbolShard& shard = storage.shards[hash % SYMBOL_SHARDS];
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    size_t position = storage.findSlot(shard, name, hash);
+    if (shard.slots[position] != 0) {
+        cached = {hash, shard.slots[position]};
+        return shard.slots[position] - 1;
+    }
+    unsigned int id = storage.count.fetch_add(1, std::memory_order_relaxed);
+    if (id >= SYMBOL_CHUNKS * SYMBOL_CHUNK_SIZE) {
+        storage.count.fetch_sub(1, std::memory_order_relaxed);
+        throw ModuleException(L"too many symbols");
+    }
+    storage.getSlot(id)->assign(name);
+    shard.slots[position] = id + 1;
+    cached = {hash, id + 1};
+    if (++shard.count * 2 > shard.slots.size())
+        storage.grow(shard);
+    return id;
+}
+
+unsigned int SMCApi::SymbolTable::find(const std::wstring& name) {
+    SymbolStorage& storage = getSymbolStorage();
+    size_t hash = std::hash<std::wstring>()(name);
+    SymbolCacheEntry& cached = symbolCache[hash % SYMBOL_CACHE_SIZE];
+    if (cached.slot != 0 && cached.hash == hash && storage.get(cached.slot - 1) == name)
+        return cached.slot - 1;
+    SymbolShard& shard = storage.shards[hash % SYMBOL_SHARDS];
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    unsigned int slot = shard.slots[storage.findSlot(shard, name, hash)];
+    if (slot == 0)
+        return NOT_FOUND;
+    cached = {hash, slot};
+    return slot - 1;
+}
+
+const std::wstring& SMCApi::SymbolTable::getName(unsigned int id) {
+    if (id >= getSymbolStorage().count.load(std::memory_order_acquire))
+        throw ModuleException(L"wrong symbol");
+    return getSymbolStorage().get(id);
+}
+
+size_t SMCApi::SymbolTable::size() {
+    return getSymbolStorage().count.load(std::memory_order_relaxed);
+}
+
+SMCApi::Number::Number(const signed char value) : type(NumberType::NT_BYTE) {
+    Number::value.byteValue = value;
+}
+
+SMCApi::Number::Number(const short value) : type(NumberType::NT_SHORT) {
+    Number::value.shortValue = value;
+}
+
+SMCApi::Number::Number(const long value) : type(NumberType::NT_INTEGER) {
+    Number::value.intValue = value;
+}
+
+SMCApi::Number::Number(const long long int value) : type(NumberType::NT_LONG) {
+    Number::value.longValue = value;
+}
+
+SMCApi::Number::Number(const float value) : type(NumberType::NT_FLOAT) {
+    Number::value.floatValue = value;
+}
+
+SMCApi::Number::Number(const double value) : type(NumberType::NT_DOUBLE) {
+    Number::value.doubleValue = value;
+}
+
+SMCApi::Number::Number(const SMCApi::NumberType type, char* valueString) : type(type) {
+    value.stringValue = valueString;
+    if (type != NumberType::NT_BIG_INTEGER && type != NumberType::NT_BIG_DECIMAL) {
+        // primitive type given as string is parsed, string is deleted
+        value.longValue = 0;
+        if (valueString == nullptr)
+            return;
+        Number number(type == NumberType::NT_FLOAT || type == NumberType::NT_DOUBLE ? NumberType::NT_BIG_DECIMAL : NumberType::NT_BIG_INTEGER,
+                      valueString);
+        switch (type) {
+        case NumberType::NT_BYTE:
+            value.byteValue = number.byteValue();
+            break;
+        case NumberType::NT_SHORT:
+            value.shortValue = number.shortValue();
+            break;
+        case NumberType::NT_INTEGER:
+            value.intValue = number.intValue();
+            break;
+        case NumberType::NT_LONG:
+            value.longValue = number.longValue();
+            break;
+        case NumberType::NT_FLOAT:
+            value.floatValue = number.floatValue();
+            break;
+        default:
+            value.doubleValue = number.doubleValue();
+            break;
+        }
     }
-    case NumberType::NT_BIG_DECIMAL: {
-        size_t size = strlen((char*)pNumber->pValue);
-        pValue = new char[size + 1];
-        ((char*)pValue)[size] = 0;
-        memcpy(pValue, pNumber->pValue, size);
-        break;
+}
+
+SMCApi::Number::Number(const SMCApi::Number* pNumber) : value(pNumber->value), type(pNumber->type) {
+    if ((type == NumberType::NT_BIG_INTEGER || type == NumberType::NT_BIG_DECIMAL) && pNumber->value.stringValue) {
+        size_t size = strlen(pNumber->value.stringValue);
+        value.stringValue = new char[size + 1];
+        memcpy(value.stringValue, pNumber->value.stringValue, size + 1);
     }
+}
+
+SMCApi::Number::Number(const SMCApi::Number& number) : Number(&number) {
+}
+
+SMCApi::Number& SMCApi::Number::operator=(const SMCApi::Number& number) {
+    if (this != &number) {
+        Number copy(&number);
+        std::swap(value, copy.value);
+        std::swap(type, copy.type);
     }
+    return *this;
 }
 
 SMCApi::Number::~Number() {
+    if (type == NumberType::NT_BIG_INTEGER || type == NumberType::NT_BIG_DECIMAL)
+        delete[] value.stringValue;
+    value.stringValue = nullptr;
+}
+
+template<typename R>
+R SMCApi::Number::cast() const {
     switch (type) {
     case NumberType::NT_BYTE:
-        delete (signed char*)pValue;
-        break;
+        return static_cast<R>(value.byteValue);
     case NumberType::NT_SHORT:
-        delete (short*)pValue;
-        break;
+        return static_cast<R>(value.shortValue);
     case NumberType::NT_INTEGER:
-        delete (long*)pValue;
-        break;
+        return static_cast<R>(value.intValue);
     case NumberType::NT_LONG:
-        delete (long long int*)pValue;
-        break;
+        return static_cast<R>(value.longValue);
+    case NumberType::NT_BIG_INTEGER:
+        return static_cast<R>(std::stoll(std::string(value.stringValue)));
     case NumberType::NT_FLOAT:
-        delete (float*)pValue;
-        break;
+        return static_cast<R>(value.floatValue);
     case NumberType::NT_DOUBLE:
-        delete (double*)pValue;
-        break;
-    case NumberType::NT_BIG_INTEGER:
+        return static_cast<R>(value.doubleValue);
     case NumberType::NT_BIG_DECIMAL:
-        delete[] (char*)pValue;
-        break;
+        return static_cast<R>(std::stod(std::string(value.stringValue)));
     }
-    pValue = nullptr;
+    return 0;
 }
 
 signed char SMCApi::Number::byteValue() {
-    switch (type) {
-    case NumberType::NT_BYTE:
-        return *((signed char*)pValue);
-    case NumberType::NT_SHORT:
-        return static_cast<signed char>(*((short*)pValue));
-    case NumberType::NT_INTEGER:
-        return static_cast<signed char>(*((long*)pValue));
-    case NumberType::NT_LONG:
-        return static_cast<signed char>(*((int long long*)pValue));
-    case NumberType::NT_BIG_INTEGER: {
-        std::string str((char*)pValue);
-        return static_cast<signed char>(std::stoll(str));
-    }
-    case NumberType::NT_FLOAT:
-        return static_cast<signed char>(*((float*)pValue));
-    case NumberType::NT_DOUBLE:
-        return static_cast<signed char>(*((double*)pValue));
-    case NumberType::NT_BIG_DECIMAL: {
-        std::string str((char*)pValue);
-        return static_cast<signed char>(std::stod(str));
-    }
-    }
-    return 0;
+    return cast<signed char>();
 }
 
 short SMCApi::Number::shortValue() {
-    switch (type) {
-    case NumberType::NT_BYTE:
-        return static_cast<short>(*((signed char*)pValue));
-    case NumberType::NT_SHORT:
-        return *((short*)pValue);
-    case NumberType::NT_INTEGER:
-        return static_cast<short>(*((long*)pValue));
-    case NumberType::NT_LONG:
-        return static_cast<short>(*((int long long*)pValue));
-    case NumberType::NT_BIG_INTEGER: {
-        std::string str((char*)pValue);
-        return static_cast<short>(std::stoll(str));
-    }
-    case NumberType::NT_FLOAT:
-        return static_cast<short>(*((float*)pValue));
-    case NumberType::NT_DOUBLE:
-        return static_cast<short>(*((double*)pValue));
-    case NumberType::NT_BIG_DECIMAL: {
-        std::string str((char*)pValue);
-        return static_cast<short>(std::stod(str));
-    }
-    }
-    return 0;
+    return cast<short>();
 }
 
 long SMCApi::Number::intValue() {
-    switch (type) {
-    case NumberType::NT_BYTE:
-        return static_cast<long>(*((signed char*)pValue));
-    case NumberType::NT_SHORT:
-        return static_cast<long>(*((short*)pValue));
-    case NumberType::NT_INTEGER:
-        return *((long*)pValue);
-    case NumberType::NT_LONG:
-        return static_cast<long>(*((int long long*)pValue));
-    case NumberType::NT_BIG_INTEGER: {
-        std::string str((char*)pValue);
-        return static_cast<long>(std::stoll(str));
-    }
-    case NumberType::NT_FLOAT:
-        return static_cast<long>(*((float*)pValue));
-    case NumberType::NT_DOUBLE:
-        return static_cast<long>(*((double*)pValue));
-    case NumberType::NT_BIG_DECIMAL: {
-        std::string str((char*)pValue);
-        return static_cast<long>(std::stod(str));
-    }
-    }
-    return 0;
+    return cast<long>();
 }
 
 long long int SMCApi::Number::longValue() {
-    switch (type) {
-    case NumberType::NT_BYTE:
-        return static_cast<int long long>(*((signed char*)pValue));
-    case NumberType::NT_SHORT:
-        return static_cast<int long long>(*((short*)pValue));
-    case NumberType::NT_INTEGER:
-        return static_cast<int long long>(*((long*)pValue));
-    case NumberType::NT_LONG:
-        return *((int long long*)pValue);
-    case NumberType::NT_BIG_INTEGER: {
-        std::string str((char*)pValue);
-        return static_cast<int long long>(std::stoll(str));
-    }
-    case NumberType::NT_FLOAT:
-        return static_cast<int long long>(*((float*)pValue));
-    case NumberType::NT_DOUBLE:
-        return static_cast<int long long>(*((double*)pValue));
-    case NumberType::NT_BIG_DECIMAL: {
-        std::string str((char*)pValue);
-        return static_cast<int long long>(std::stod(str));
-    }
-    }
-    return 0;
+    return cast<long long int>();
 }
 
 float SMCApi::Number::floatValue() {
+    return cast<float>();
+}
+
+double SMCApi::Number::doubleValue() {
+    return cast<double>();
+}
+
+std::string SMCApi::Number::toString() {
     switch (type) {
     case NumberType::NT_BYTE:
-        return static_cast<float>(*((signed char*)pValue));
+        return std::to_string(value.byteValue);
     case NumberType::NT_SHORT:
-        return static_cast<float>(*((short*)pValue));
+        return std::to_string(value.shortValue);
     case NumberType::NT_INTEGER:
-        return static_cast<float>(*((long*)pValue));
+        return std::to_string(value.intValue);
     case NumberType::NT_LONG:
-        return static_cast<float>(*((int long long*)pValue));
-    case NumberType::NT_BIG_INTEGER: {
-        std::string str((char*)pValue);
-        return static_cast<float>(std::stoll(str));
-    }
+        return std::to_string(value.longValue);
     case NumberType::NT_FLOAT:
-        return *((float*)pValue);
+        return std::to_string(value.floatValue);
     case NumberType::NT_DOUBLE:
-        return static_cast<float>(*((double*)pValue));
-    case NumberType::NT_BIG_DECIMAL: {
-        std::string str((char*)pValue);
-        return static_cast<float>(std::stod(str));
-    }
+        return std::to_string(value.doubleValue);
+    case NumberType::NT_BIG_INTEGER:
+    case NumberType::NT_BIG_DECIMAL:
+        return std::string(value.stringValue);
     }
-    return 0;
+    return "";
 }
 
-double SMCApi::Number::doubleValue() {
-    switch (type) {
-    case NumberType::NT_BYTE:
-        return static_cast<double>(*((signed char*)pValue));
-    case NumberType::NT_SHORT:
-        return static_cast<double>(*((short*)pValue));
-    case NumberType::NT_INTEGER:
-        return static_cast<double>(*((long*)pValue));
-    case NumberType::NT_LONG:
-        return static_cast<double>(*((int long long*)pValue));
-    case NumberType::NT_BIG_INTEGER: {
-        std::string str((char*)pValue);
-        return static_cast<double>(std::stoll(str));
+size_t SMCApi::Number::getMemorySize() const {
+    if ((type == NumberType::NT_BIG_INTEGER || type == NumberType::NT_BIG_DECIMAL) && value.stringValue)
+        return sizeof(Number) + strlen(value.stringValue) + 1;
+    return sizeof(Number);
+}
+
+SMCApi::NumberType SMCApi::Number::getType() {
+    return type;
+}
+
+struct SMCApi::ByteBuffer::Block {
+    std::atomic<long> references;
+    signed char* array;
+    std::vector<signed char> vector;
+
+    Block(signed char* array) : references(1), array(array) {
     }
-    case NumberType::NT_FLOAT:
-        return static_cast<double>(*((float*)pValue));
-    case NumberType::NT_DOUBLE:
-        return *((double*)pValue);
-    case NumberType::NT_BIG_DECIMAL: {
-        std::string str((char*)pValue);
-        return static_cast<double>(std::stod(str));
+
+    ~Block() {
+        delete[] array;
     }
+};
+
+SMCApi::ByteBuffer::ByteBuffer(SMCApi::ByteBuffer::Block* block, const signed char* data, size_t size) : block(block), data(data), size(size) {
+}
+
+SMCApi::ByteBuffer::ByteBuffer() : block(nullptr), data(nullptr), size(0) {
+}
+
+SMCApi::ByteBuffer::ByteBuffer(size_t size) : block(new Block(new signed char[size]())), size(size) {
+    data = block->array;
+}
+
+SMCApi::ByteBuffer::ByteBuffer(const signed char* data, size_t size) : block(new Block(new signed char[size])), size(size) {
+    if (size > 0)
+        memcpy(block->array, data, size);
+    ByteBuffer::data = block->array;
+}
+
+SMCApi::ByteBuffer::ByteBuffer(std::vector<signed char>&& data) : block(new Block(nullptr)), size(data.size()) {
+    block->vector.swap(data);
+    ByteBuffer::data = block->vector.data();
+}
+
+SMCApi::ByteBuffer::ByteBuffer(const SMCApi::ByteBuffer& buffer) : block(buffer.block), data(buffer.data), size(buffer.size) {
+    if (block)
+        block->references.fetch_add(1, std::memory_order_relaxed);
+}
+
+SMCApi::ByteBuffer::ByteBuffer(SMCApi::ByteBuffer&& buffer) noexcept : block(buffer.block), data(buffer.data), size(buffer.size) {
+    buffer.block = nullptr;
+    buffer.data = nullptr;
+    buffer.size = 0;
+}
+
+SMCApi::ByteBuffer& SMCApi::ByteBuffer::operator=(const SMCApi::ByteBuffer& buffer) {
+    if (this != &buffer) {
+        ByteBuffer copy(buffer);
+        *this = std::move(copy);
     }
-    return 0;
+    return *this;
 }
 
-std::string SMCApi::Number::toString() {
-    switch (type) {
-    case NumberType::NT_BYTE:
-        return std::to_string(*((signed char*)pValue));
-    case NumberType::NT_SHORT:
-        return std::to_string(*((float*)pValue));
-    case NumberType::NT_INTEGER:
-        return std::to_string(*((long*)pValue));
-    case NumberType::NT_LONG:
-        return std::to_string(*((int long long*)pValue));
-    case NumberType::NT_BIG_INTEGER: {
-        std::string str((char*)pValue);
-        return str;
+SMCApi::ByteBuffer& SMCApi::ByteBuffer::operator=(SMCApi::ByteBuffer&& buffer) noexcept {
+    if (this != &buffer) {
+        if (block && block->references.fetch_sub(1, std::memory_order_acq_rel) == 1)
+            delete block;
+        block = buffer.block;
+        data = buffer.data;
+        size = buffer.size;
+        buffer.block = nullptr;
+        buffer.data = nullptr;
+        buffer.size = 0;
     }
-    case NumberType::NT_FLOAT:
-        return std::to_string(*((float*)pValue));
-    case NumberType::NT_DOUBLE:
-        return std::to_string(*((double*)pValue));
-    case NumberType::NT_BIG_DECIMAL: {
-        std::string str((char*)pValue);
-        return str;
+    return *this;
+}
+
+SMCApi::ByteBuffer SMCApi::ByteBuffer::adopt(signed char* data, size_t size) {
+    return ByteBuffer(new Block(data), data, size);
+}
+
+const signed char* SMCApi::ByteBuffer::getData() const {
+    return data;
+}
+
+signed char* SMCApi::ByteBuffer::getWritableData() {
+    return (signed char*)data;
+}
+
+size_t SMCApi::ByteBuffer::getSize() const {
+    return size;
+}
+
+bool SMCApi::ByteBuffer::isEmpty() const {
+    return size == 0;
+}
+
+SMCApi::ByteBuffer SMCApi::ByteBuffer::slice(size_t offset, size_t length) const {
+    if (offset > size || length > size - offset)
+        throw ModuleException(L"wrong range");
+    if (block)
+        block->references.fetch_add(1, std::memory_order_relaxed);
+    return ByteBuffer(block, data + offset, length);
+}
+
+long SMCApi::ByteBuffer::countReferences() const {
+    return block ? block->references.load(std::memory_order_relaxed) : 0;
+}
+
+size_t SMCApi::ByteBuffer::getMemorySize() const {
+    return sizeof(ByteBuffer) + size;
+}
+
+SMCApi::ByteBuffer::~ByteBuffer() {
+    if (block && block->references.fetch_sub(1, std::memory_order_acq_rel) == 1)
+        delete block;
+}
+
+SMCApi::Utf8String::Utf8String() : wide(nullptr) {
+}
+
+SMCApi::Utf8String::Utf8String(const std::string& value) : value(value), wide(nullptr) {
+}
+
+SMCApi::Utf8String::Utf8String(std::string&& value) : value(std::move(value)), wide(nullptr) {
+}
+
+SMCApi::Utf8String::Utf8String(const char* data, size_t size) : value(data, size), wide(nullptr) {
+}
+
+SMCApi::Utf8String::Utf8String(const std::wstring& value) : wide(nullptr) {
+    toUtf8(value.data(), value.size(), Utf8String::value);
+}
+
+SMCApi::Utf8String::Utf8String(const SMCApi::Utf8String& value) : value(value.value), wide(nullptr) {
+}
+
+SMCApi::Utf8String::Utf8String(SMCApi::Utf8String&& value) noexcept : value(std::move(value.value)), wide(value.wide.exchange(nullptr)) {
+}
+
+SMCApi::Utf8String& SMCApi::Utf8String::operator=(const SMCApi::Utf8String& value) {
+    if (this != &value) {
+        Utf8String::value = value.value;
+        compact();
     }
+    return *this;
+}
+
+SMCApi::Utf8String& SMCApi::Utf8String::operator=(SMCApi::Utf8String&& value) noexcept {
+    if (this != &value) {
+        Utf8String::value = std::move(value.value);
+        delete wide.exchange(value.wide.exchange(nullptr));
     }
-    return "";
+    return *this;
 }
 
-SMCApi::NumberType SMCApi::Number::getType() {
-    return type;
+SMCApi::Utf8String SMCApi::Utf8String::adopt(std::wstring* value) {
+    Utf8String result(*value);
+    result.wide.store(value);
+    return result;
+}
+
+const std::string& SMCApi::Utf8String::getValue() const {
+    return value;
+}
+
+const char* SMCApi::Utf8String::getData() const {
+    return value.data();
+}
+
+size_t SMCApi::Utf8String::getSize() const {
+    return value.size();
+}
+
+bool SMCApi::Utf8String::isEmpty() const {
+    return value.empty();
+}
+
+const std::wstring* SMCApi::Utf8String::getWide() const {
+    std::wstring* result = wide.load(std::memory_order_acquire);
+    if (result)
+        return result;
+    auto* created = new std::wstring();
+    fromUtf8(value.data(), value.size(), *created);
+    if (wide.compare_exchange_strong(result, created, std::memory_order_acq_rel, std::memory_order_acquire))
+        return created;
+    delete created;
+    return result;
+}
+
+std::wstring* SMCApi::Utf8String::releaseWide() {
+    return wide.exchange(nullptr);
+}
+
+void SMCApi::Utf8String::compact() {
+    delete wide.exchange(nullptr);
+}
+
+bool SMCApi::Utf8String::operator==(const SMCApi::Utf8String& value) const {
+    return Utf8String::value == value.value;
+}
+
+bool SMCApi::Utf8String::operator!=(const SMCApi::Utf8String& value) const {
+    return Utf8String::value != value.value;
+}
+
+bool SMCApi::Utf8String::operator<(const SMCApi::Utf8String& value) const {
+    return Utf8String::value < value.value;
+}
+
+size_t SMCApi::Utf8String::getMemorySize() const {
+    std::wstring* pWide = wide.load(std::memory_order_acquire);
+    return sizeof(Utf8String) - sizeof(std::string) + stringMemorySize(value) + (pWide ? stringMemorySize(*pWide) : 0);
+}
+
+SMCApi::Utf8String::~Utf8String() {
+    delete wide.load(std::memory_order_relaxed);
 }
 
 SMCApi::ObjectType SMCApi::convertToObject(ValueType type) {
@@ -455,6 +830,94 @@ SMCApi::ValueType SMCApi::convertToValue(SMCApi::ObjectType type) {
     }
 }
 
+std::string SMCApi::toUtf8(const std::wstring& value) {
+    std::string result;
+    toUtf8(value.data(), value.size(), result);
+    return result;
+}
+
+std::wstring SMCApi::fromUtf8(const std::string& value) {
+    std::wstring result;
+    fromUtf8(value.data(), value.size(), result);
+    return result;
+}
+
+void SMCApi::toUtf8(const wchar_t* data, size_t size, std::string& result) {
+    result.reserve(result.size() + size);
+    size_t i = 0;
+    while (i < size) {
+#ifdef SMCAPI_SSE2
+        char block[16];
+        if (i + 16 <= size && packAscii(data + i, block)) {
+            result.append(block, 16);
+            i += 16;
+            continue;
+        }
+        size_t end = std::min(i + 16, size);
+#else
+        size_t end = size;
+#endif
+        for (; i < end; i++) {
+            auto c = (unsigned long)data[i];
+            if (sizeof(wchar_t) == 2 && c >= 0xD800 && c < 0xDC00 && i + 1 < size) {
+                auto low = (unsigned long)data[i + 1];
+                if (low >= 0xDC00 && low < 0xE000) {
+                    c = 0x10000 + ((c - 0xD800) << 10) + (low - 0xDC00);
+                    i++;
+                }
+            }
+            if (c < 0x80) {
+                result.push_back((char)c);
+            } else if (c < 0x800) {
+                result.push_back((char)(0xC0 | (c >> 6)));
+                result.push_back((char)(0x80 | (c & 0x3F)));
+            } else if (c < 0x10000) {
+                result.push_back((char)(0xE0 | (c >> 12)));
+                result.push_back((char)(0x80 | ((c >> 6) & 0x3F)));
+                result.push_back((char)(0x80 | (c & 0x3F)));
+            } else {
+                result.push_back((char)(0xF0 | (c >> 18)));
+                result.push_back((char)(0x80 | ((c >> 12) & 0x3F)));
+                result.push_back((char)(0x80 | ((c >> 6) & 0x3F)));
+                result.push_back((char)(0x80 | (c & 0x3F)));
+            }
+        }
+    }
+}
+
+void SMCApi::fromUtf8(const char* data, size_t size, std::wstring& result) {
+    result.reserve(result.size() + size);
+    auto p = (const unsigned char*)data;
+    auto end = p + size;
+    while (p < end) {
+#ifdef SMCAPI_SSE2
+        wchar_t block[16];
+        if (end - p >= 16 && widenAscii(p, block)) {
+            result.append(block, 16);
+            p += 16;
+            continue;
+        }
+        auto blockEnd = end - p > 16 ? p + 16 : end;
+#else
+        auto blockEnd = end;
+#endif
+        while (p < blockEnd) {
+            unsigned long c = *p++;
+            int extra = c >= 0xF0 ? 3 : c >= 0xE0 ? 2 : c >= 0xC0 ? 1 : 0;
+            if (extra)
+                c &= 0x3F >> extra;
+            for (; extra > 0 && p < end && (*p & 0xC0) == 0x80; --extra)
+                c = (c << 6) | (*p++ & 0x3F);
+            if (sizeof(wchar_t) == 2 && c >= 0x10000) {
+                c -= 0x10000;
+                result.push_back((wchar_t)(0xD800 + (c >> 10)));
+                c = 0xDC00 + (c & 0x3FF);
+            }
+            result.push_back((wchar_t)c);
+        }
+    }
+}
+
 bool equalsCharIgnoreCase(char a, char b) {
     return std::tolower(static_cast<unsigned char>(a)) ==
         std::tolower(static_cast<unsigned char>(b));
@@ -465,44 +928,114 @@ bool equalsIgnoreCase(const std::wstring& a, const std::wstring& b) {
 }
 
 
-SMCApi::ObjectField::ObjectField(const std::wstring& name, const SMCApi::ObjectType type) : name(name), pValue(nullptr), type(type),
+SMCApi::ObjectField::ObjectField(const std::wstring& name, const SMCApi::ObjectType type) : nameId(SymbolTable::intern(name)), type(type), pValue(nullptr),
                                                                                             valueBytesLength(0) {
 }
 
-SMCApi::ObjectField::ObjectField(const std::wstring& name, const std::wstring* value) : name(name), pValue(nullptr), valueBytesLength(0) {
+SMCApi::ObjectField::ObjectField(const std::wstring& name, const std::wstring* value) : nameId(SymbolTable::intern(name)), pValue(nullptr), valueBytesLength(0) {
     setValue(value);
 }
 
-SMCApi::ObjectField::ObjectField(const std::wstring& name, const SMCApi::Number* value) : name(name), pValue(nullptr), valueBytesLength(0) {
+SMCApi::ObjectField::ObjectField(const std::wstring& name, const SMCApi::Number* value) : nameId(SymbolTable::intern(name)), pValue(nullptr), valueBytesLength(0) {
     setValue(value);
 }
 
-SMCApi::ObjectField::ObjectField(const std::wstring& name, const signed char* value, size_t size) : name(name), pValue(nullptr), valueBytesLength(0) {
+SMCApi::ObjectField::ObjectField(const std::wstring& name, const SMCApi::Number& value) : nameId(SymbolTable::intern(name)), pValue(nullptr), valueBytesLength(0) {
     setValue(value);
 }
 
-SMCApi::ObjectField::ObjectField(const std::wstring& name, const bool value) : name(name), pValue(nullptr), valueBytesLength(0) {
+SMCApi::ObjectField::ObjectField(const std::wstring& name, const signed char* value, size_t size) : nameId(SymbolTable::intern(name)), pValue(nullptr), valueBytesLength(0) {
+    setValue(value, size);
+}
+
+SMCApi::ObjectField::ObjectField(const std::wstring& name, const SMCApi::ByteBuffer& value) : nameId(SymbolTable::intern(name)), pValue(nullptr), valueBytesLength(0) {
     setValue(value);
 }
 
-SMCApi::ObjectField::ObjectField(const std::wstring& name, const SMCApi::ObjectArray* value) : name(name), pValue(nullptr), valueBytesLength(0) {
+SMCApi::ObjectField::ObjectField(const std::wstring& name, const SMCApi::Utf8String& value) : nameId(SymbolTable::intern(name)), pValue(nullptr), valueBytesLength(0) {
     setValue(value);
 }
 
-SMCApi::ObjectField::ObjectField(const std::wstring& name, const SMCApi::ObjectElement* value) : name(name), pValue(nullptr), valueBytesLength(0) {
+SMCApi::ObjectField::ObjectField(const std::wstring& name, const bool value) : nameId(SymbolTable::intern(name)), pValue(nullptr), valueBytesLength(0) {
     setValue(value);
 }
 
-SMCApi::ObjectField::ObjectField(const SMCApi::ObjectField* objectField) : name(objectField->name), pValue(nullptr), valueBytesLength(0) {
+SMCApi::ObjectField::ObjectField(const std::wstring& name, const SMCApi::ObjectArray* value) : nameId(SymbolTable::intern(name)), pValue(nullptr), valueBytesLength(0) {
+    setValue(value);
+}
+
+SMCApi::ObjectField::ObjectField(const std::wstring& name, const SMCApi::ObjectElement* value) : nameId(SymbolTable::intern(name)), pValue(nullptr), valueBytesLength(0) {
+    setValue(value);
+}
+
+SMCApi::ObjectField::ObjectField(const SMCApi::ObjectField* objectField) : nameId(objectField->nameId), pValue(nullptr), valueBytesLength(0) {
     setValue(objectField);
 }
 
+SMCApi::ObjectField::ObjectField(const SMCApi::ObjectField& objectField) : nameId(objectField.nameId), pValue(nullptr), valueBytesLength(0) {
+    setValue(&objectField);
+}
+
+SMCApi::ObjectField::ObjectField(SMCApi::ObjectField&& objectField) noexcept : nameId(objectField.nameId), type(objectField.type),
+                                                                              pValue(objectField.pValue),
+                                                                              valueBytesLength(objectField.valueBytesLength) {
+    if (objectField.isInline()) {
+        memcpy(inlineValue, objectField.inlineValue, sizeof(inlineValue));
+        pValue = inlineValue;
+    }
+    objectField.pValue = nullptr;
+}
+
+SMCApi::ObjectField& SMCApi::ObjectField::operator=(const SMCApi::ObjectField& objectField) {
+    if (this != &objectField) {
+        nameId = objectField.nameId;
+        setValue(&objectField);
+    }
+    return *this;
+}
+
+SMCApi::ObjectField& SMCApi::ObjectField::operator=(SMCApi::ObjectField&& objectField) noexcept {
+    if (this != &objectField) {
+        deleteValue();
+        nameId = objectField.nameId;
+        type = objectField.type;
+        valueBytesLength = objectField.valueBytesLength;
+        pValue = objectField.pValue;
+        if (objectField.isInline()) {
+            memcpy(inlineValue, objectField.inlineValue, sizeof(inlineValue));
+            pValue = inlineValue;
+        }
+        objectField.pValue = nullptr;
+    }
+    return *this;
+}
+
+bool SMCApi::ObjectField::isInline() const {
+    return pValue == (const void*)inlineValue;
+}
+
+void SMCApi::ObjectField::setInline(const void* value) {
+    if (type == ObjectType::OT_BOOLEAN)
+        *(bool*)inlineValue = *(const bool*)value;
+    else
+        new(inlineValue) Number((const Number*)value);
+    pValue = inlineValue;
+}
+
 const std::wstring& SMCApi::ObjectField::getName() const {
-    return name;
+    return SymbolTable::getName(nameId);
 }
 
 void SMCApi::ObjectField::setName(const std::wstring& name) {
-    ObjectField::name = name;
+    nameId = SymbolTable::intern(name);
+}
+
+unsigned int SMCApi::ObjectField::getNameId() const {
+    return nameId;
+}
+
+void SMCApi::ObjectField::setNameId(unsigned int nameId) {
+    ObjectField::nameId = nameId;
 }
 
 bool SMCApi::ObjectField::isNull() {
@@ -517,7 +1050,21 @@ void SMCApi::ObjectField::setValueNull(const SMCApi::ObjectType type) {
 void SMCApi::ObjectField::setValue(const std::wstring* value) {
     deleteValue();
     type = ObjectType::OT_STRING;
-    pValue = (void*)value;
+    pValue = value ? new Utf8String(Utf8String::adopt((std::wstring*)value)) : nullptr;
+}
+
+void SMCApi::ObjectField::setValue(const SMCApi::Utf8String& value) {
+    auto* pValueNew = new Utf8String(value);
+    deleteValue();
+    type = ObjectType::OT_STRING;
+    pValue = pValueNew;
+}
+
+void SMCApi::ObjectField::setValue(SMCApi::Utf8String&& value) {
+    auto* pValueNew = new Utf8String(std::move(value));
+    deleteValue();
+    type = ObjectType::OT_STRING;
+    pValue = pValueNew;
 }
 
 void SMCApi::ObjectField::setValue(const SMCApi::Number* value) {
@@ -526,19 +1073,41 @@ void SMCApi::ObjectField::setValue(const SMCApi::Number* value) {
     pValue = (void*)value;
 }
 
+void SMCApi::ObjectField::setValue(const SMCApi::Number& value) {
+    // value may be the value of this field, so it is copied before delete
+    auto typeNew = (ObjectType)convertToObject(((SMCApi::Number&)value).getType());
+    if (isInlineType(typeNew)) {
+        Number copy(&value);
+        deleteValue();
+        type = typeNew;
+        setInline(&copy);
+    } else {
+        auto* pValueNew = new Number(&value);
+        deleteValue();
+        type = typeNew;
+        pValue = pValueNew;
+    }
+}
+
 void SMCApi::ObjectField::setValue(const signed char* value, size_t size) {
     deleteValue();
     type = ObjectType::OT_BYTES;
-    pValue = (void*)value;
+    pValue = value ? new ByteBuffer(ByteBuffer::adopt((signed char*)value, size)) : nullptr;
     valueBytesLength = size;
 }
 
+void SMCApi::ObjectField::setValue(const SMCApi::ByteBuffer& value) {
+    auto* pValueNew = new ByteBuffer(value);
+    deleteValue();
+    type = ObjectType::OT_BYTES;
+    pValue = pValueNew;
+    valueBytesLength = pValueNew->getSize();
+}
+
 void SMCApi::ObjectField::setValue(const bool value) {
     deleteValue();
     type = ObjectType::OT_BOOLEAN;
-    auto* valueInternal = new bool;
-    *valueInternal = value;
-    pValue = valueInternal;
+    setInline(&value);
 }
 
 void SMCApi::ObjectField::setValue(const SMCApi::ObjectArray* value) {
@@ -557,46 +1126,10 @@ void SMCApi::ObjectField::setValue(const SMCApi::ObjectField* value) {
     deleteValue();
     type = value->type;
     valueBytesLength = value->valueBytesLength;
-    if (((SMCApi::ObjectField*)value)->isNull())
-        return;
-    switch (value->getType()) {
-    case OT_STRING: {
-        auto pStrNew = new std::wstring(*value->getValueString());
-        pValue = pStrNew;
-        break;
-    }
-    case OT_BYTE:
-    case OT_SHORT:
-    case OT_INTEGER:
-    case OT_LONG:
-    case OT_BIG_INTEGER:
-    case OT_FLOAT:
-    case OT_DOUBLE:
-    case OT_BIG_DECIMAL:
-        pValue = new Number(value->getValueNumber());
-        break;
-    case OT_BYTES: {
-        size_t size = value->getBytesCount();
-        pValue = new char[size];
-        memcpy(pValue, value->getValueBytes(), size);
-        break;
-    }
-    case OT_BOOLEAN: {
-        bool* pV = new bool;
-        *pV = value->getValueBoolean();
-        pValue = pV;
-        break;
-    }
-    case OT_OBJECT_ARRAY:
-        pValue = new SMCApi::ObjectArray(value->getValueObjectArray());
-        break;
-    case OT_OBJECT_ELEMENT:
-        pValue = new SMCApi::ObjectElement(value->getValueObjectElement());
-        break;
-    default:
-        pValue = nullptr;
-        break;
-    }
+    if (value->pValue && isInlineType(type))
+        setInline(value->pValue);
+    else
+        pValue = copyValue(value->pValue, type, valueBytesLength);
 }
 
 void SMCApi::ObjectField::setValue(SMCApi::IValue* value) {
@@ -604,8 +1137,11 @@ void SMCApi::ObjectField::setValue(SMCApi::IValue* value) {
     type = (ObjectType)convertToObject(value->getType());
     switch (value->getType()) {
     case VT_STRING: {
-        auto pStrNew = new std::wstring(*value->getValueString());
-        pValue = pStrNew;
+        auto* pValueInternal = dynamic_cast<Value*>(value);
+        if (pValueInternal)
+            pValue = new Utf8String(*pValueInternal->getValueUtf8());
+        else
+            pValue = new Utf8String(*value->getValueString());
         break;
     }
     case VT_BYTE:
@@ -616,12 +1152,18 @@ void SMCApi::ObjectField::setValue(SMCApi::IValue* value) {
     case VT_FLOAT:
     case VT_DOUBLE:
     case VT_BIG_DECIMAL:
-        pValue = new Number(value->getValueNumber());
+        if (isInlineType(type))
+            setInline(value->getValueNumber());
+        else
+            pValue = new Number(value->getValueNumber());
         break;
     case VT_BYTES: {
-        valueBytesLength = value->getBytesCount();
-        pValue = new char[valueBytesLength];
-        memcpy(pValue, value->getValueBytes(), valueBytesLength);
+        auto* pValueInternal = dynamic_cast<Value*>(value);
+        if (pValueInternal)
+            pValue = new ByteBuffer(*pValueInternal->getValueByteBuffer());
+        else
+            pValue = new ByteBuffer(value->getValueBytes(), value->getBytesCount());
+        valueBytesLength = ((ByteBuffer*)pValue)->getSize();
         break;
     }
     case VT_OBJECT_ARRAY:
@@ -629,10 +1171,9 @@ void SMCApi::ObjectField::setValue(SMCApi::IValue* value) {
         pValue = new SMCApi::ObjectArray(value->getValueObjectArray());
         break;
     case VT_BOOLEAN: {
-        bool* pV = new bool;
-        *pV = value->getValueBoolean();
+        bool valueBoolean = value->getValueBoolean();
         type = ObjectType::OT_BOOLEAN;
-        pValue = pV;
+        setInline(&valueBoolean);
         break;
     }
     }
@@ -640,62 +1181,97 @@ void SMCApi::ObjectField::setValue(SMCApi::IValue* value) {
 
 const std::wstring* SMCApi::ObjectField::getValueString() const {
     if (type != ObjectType::OT_STRING) {
-        std::wstring error(L"wrong type");
-        throw ModuleException(error);
+        throw ModuleException(L"wrong type");
+    }
+    return pValue ? ((Utf8String*)pValue)->getWide() : nullptr;
+}
+
+const SMCApi::Utf8String* SMCApi::ObjectField::getValueUtf8() const {
+    if (type != ObjectType::OT_STRING) {
+        throw ModuleException(L"wrong type");
     }
-    return (std::wstring*)pValue;
+    return (Utf8String*)pValue;
 }
 
 const SMCApi::Number* SMCApi::ObjectField::getValueNumber() const {
     if (type != ObjectType::OT_BYTE && type != ObjectType::OT_SHORT && type != ObjectType::OT_INTEGER && type != ObjectType::OT_LONG &&
         type != ObjectType::OT_FLOAT && type != ObjectType::OT_DOUBLE && type != ObjectType::OT_BIG_INTEGER &&
         type != ObjectType::OT_BIG_DECIMAL) {
-        std::wstring error(L"wrong type");
-        throw ModuleException(error);
+        throw ModuleException(L"wrong type");
     }
     return (Number*)pValue;
 }
 
 const signed char* SMCApi::ObjectField::getValueBytes() const {
     if (type != ObjectType::OT_BYTES) {
-        std::wstring error(L"wrong type");
-        throw ModuleException(error);
+        throw ModuleException(L"wrong type");
     }
-    return (signed char*)pValue;
+    return pValue ? ((ByteBuffer*)pValue)->getData() : nullptr;
 }
 
 size_t SMCApi::ObjectField::getBytesCount() const {
     if (type != ObjectType::OT_BYTES) {
-        std::wstring error(L"wrong type");
-        throw ModuleException(error);
+        throw ModuleException(L"wrong type");
     }
     return valueBytesLength;
 }
 
+const SMCApi::ByteBuffer* SMCApi::ObjectField::getValueByteBuffer() const {
+    if (type != ObjectType::OT_BYTES) {
+        throw ModuleException(L"wrong type");
+    }
+    return (ByteBuffer*)pValue;
+}
+
 bool SMCApi::ObjectField::getValueBoolean() const {
     if (type != ObjectType::OT_BOOLEAN) {
-        std::wstring error(L"wrong type");
-        throw ModuleException(error);
+        throw ModuleException(L"wrong type");
     }
     return *((bool*)pValue);
 }
 
 const SMCApi::ObjectArray* SMCApi::ObjectField::getValueObjectArray() const {
     if (type != ObjectType::OT_OBJECT_ARRAY) {
-        std::wstring error(L"wrong type");
-        throw ModuleException(error);
+        throw ModuleException(L"wrong type");
     }
     return (ObjectArray*)pValue;
 }
 
 const SMCApi::ObjectElement* SMCApi::ObjectField::getValueObjectElement() const {
     if (type != ObjectType::OT_OBJECT_ELEMENT) {
-        std::wstring error(L"wrong type");
-        throw ModuleException(error);
+        throw ModuleException(L"wrong type");
     }
     return (ObjectElement*)pValue;
 }
 
+const std::wstring* SMCApi::ObjectField::tryGetValueString() const {
+    return type == ObjectType::OT_STRING && pValue ? ((Utf8String*)pValue)->getWide() : nullptr;
+}
+
+const SMCApi::Utf8String* SMCApi::ObjectField::tryGetValueUtf8() const {
+    return type == ObjectType::OT_STRING ? (Utf8String*)pValue : nullptr;
+}
+
+const SMCApi::Number* SMCApi::ObjectField::tryGetValueNumber() const {
+    return isNumber(type) ? (Number*)pValue : nullptr;
+}
+
+const signed char* SMCApi::ObjectField::tryGetValueBytes() const {
+    return type == ObjectType::OT_BYTES && pValue ? ((ByteBuffer*)pValue)->getData() : nullptr;
+}
+
+const bool* SMCApi::ObjectField::tryGetValueBoolean() const {
+    return type == ObjectType::OT_BOOLEAN ? (bool*)pValue : nullptr;
+}
+
+const SMCApi::ObjectArray* SMCApi::ObjectField::tryGetValueObjectArray() const {
+    return type == ObjectType::OT_OBJECT_ARRAY ? (ObjectArray*)pValue : nullptr;
+}
+
+const SMCApi::ObjectElement* SMCApi::ObjectField::tryGetValueObjectElement() const {
+    return type == ObjectType::OT_OBJECT_ELEMENT ? (ObjectElement*)pValue : nullptr;
+}
+
 SMCApi::ObjectType SMCApi::ObjectField::getType() const {
     return type;
 }
@@ -707,89 +1283,180 @@ bool SMCApi::ObjectField::isSimple() {
 void SMCApi::ObjectField::deleteValue() {
     if (pValue == nullptr)
         return;
-    switch (type) {
-    case ObjectType::OT_BYTE:
-    case ObjectType::OT_SHORT:
-    case ObjectType::OT_INTEGER:
-    case ObjectType::OT_LONG:
-    case ObjectType::OT_FLOAT:
-    case ObjectType::OT_DOUBLE:
-    case ObjectType::OT_BIG_INTEGER:
-    case ObjectType::OT_BIG_DECIMAL:
-        delete (Number*)pValue;
-        break;
-    case OT_OBJECT_ARRAY:
-        delete (ObjectArray*)pValue;
-        break;
-    case OT_OBJECT_ELEMENT:
-        delete (ObjectElement*)pValue;
-        break;
-    case OT_STRING:
-        delete (std::wstring*)pValue;
-        break;
-    case OT_BYTES:
-        delete[] (signed char*)pValue;
-        break;
-    case OT_BOOLEAN:
-        delete (bool*)pValue;
-        break;
-    default:
-        break;
+    if (isInline()) {
+        if (type != ObjectType::OT_BOOLEAN)
+            ((Number*)pValue)->~Number();
+    } else {
+        destroyValue(pValue, type);
     }
     pValue = nullptr;
 }
 
+size_t SMCApi::ObjectField::getMemorySize() const {
+    return sizeof(ObjectField) + (isInline() ? 0 : valueMemorySize(pValue, type, valueBytesLength));
+}
+
 SMCApi::ObjectField::~ObjectField() {
     deleteValue();
 }
 
-SMCApi::ObjectField::ObjectField(const std::wstring& name) : name(name), pValue(nullptr), type(ObjectType::OT_INTEGER) {
+SMCApi::ObjectField::ObjectField(const std::wstring& name) : nameId(SymbolTable::intern(name)), type(ObjectType::OT_INTEGER), pValue(nullptr),
+                                                             valueBytesLength(0) {
+}
+
+SMCApi::ObjectField::ObjectField(unsigned int nameId, const SMCApi::ObjectType type) : nameId(nameId), type(type), pValue(nullptr), valueBytesLength(0) {
 }
 
 const void* SMCApi::ObjectField::getValue() const {
+    if (pValue != nullptr && type == ObjectType::OT_STRING)
+        return ((const Utf8String*)pValue)->getWide();
+    if (pValue != nullptr && type == ObjectType::OT_BYTES)
+        return ((const ByteBuffer*)pValue)->getData();
+    return pValue;
+}
+
+const void* SMCApi::ObjectField::getStoredValue() const {
     return pValue;
 }
 
-SMCApi::ObjectElement::ObjectElement(const std::vector<ObjectField*>& fields) : fields(fields) {
+SMCApi::ObjectElement::ObjectElement(const std::vector<ObjectField*>& fields) : pFields(new std::vector<ObjectField*>(fields)) {
 }
 
-SMCApi::ObjectElement::ObjectElement(const SMCApi::ObjectElement* objectElement) {
-    for (auto v : objectElement->fields)
-        fields.push_back(new ObjectField(v));
+SMCApi::ObjectElement::ObjectElement(const SMCApi::ObjectElement* objectElement) : pFields(nullptr) {
+    size_t count = objectElement->size();
+    values.reserve(count);
+    for (size_t i = 0; i < count; i++)
+        values.emplace_back(*objectElement->getField((int)i));
 }
 
 std::vector<SMCApi::ObjectField*>* SMCApi::ObjectElement::getFields() {
-    return &fields;
+    if (pFields == nullptr) {
+        auto* fields = new std::vector<ObjectField*>();
+        fields->reserve(values.size());
+        for (auto& field : values)
+            fields->push_back(new ObjectField(std::move(field)));
+        std::vector<ObjectField>().swap(values);
+        pFields = fields;
+    }
+    return pFields;
+}
+
+size_t SMCApi::ObjectElement::size() const {
+    return pFields ? pFields->size() : values.size();
+}
+
+SMCApi::ObjectField* SMCApi::ObjectElement::getField(int id) {
+    return pFields ? (*pFields)[id] : &values[id];
+}
+
+const SMCApi::ObjectField* SMCApi::ObjectElement::getField(int id) const {
+    return pFields ? (*pFields)[id] : &values[id];
+}
+
+SMCApi::ObjectField* SMCApi::ObjectElement::add(SMCApi::ObjectField&& field) {
+    if (pFields) {
+        pFields->push_back(new ObjectField(std::move(field)));
+        return pFields->back();
+    }
+    values.push_back(std::move(field));
+    return &values.back();
+}
+
+void SMCApi::ObjectElement::reserve(size_t count) {
+    if (pFields)
+        pFields->reserve(count);
+    else
+        values.reserve(count);
+}
+
+void SMCApi::ObjectElement::remove(int id) {
+    if (id < 0 || (size_t)id >= size())
+        throw ModuleException(L"wrong id");
+    if (pFields) {
+        delete (*pFields)[id];
+        pFields->erase(pFields->begin() + id);
+    } else {
+        values.erase(values.begin() + id);
+    }
+}
+
+void SMCApi::ObjectElement::clear() {
+    if (pFields) {
+        for (auto field : *pFields)
+            delete field;
+        pFields->clear();
+    } else {
+        values.clear();
+    }
 }
 
 SMCApi::ObjectField* SMCApi::ObjectElement::findField(const std::wstring& name) {
-    for (auto field : fields) {
-        if (field->getName() == name)
+    unsigned int nameId = SymbolTable::find(name);
+    return nameId != SymbolTable::NOT_FOUND ? findField(nameId) : nullptr;
+}
+
+SMCApi::ObjectField* SMCApi::ObjectElement::findField(unsigned int nameId) {
+    size_t count = size();
+    for (size_t i = 0; i < count; i++) {
+        ObjectField* field = getField((int)i);
+        if (field->getNameId() == nameId)
             return field;
     }
+    return nullptr;
 }
 
 SMCApi::ObjectField* SMCApi::ObjectElement::findFieldIgnoreCase(const std::wstring& name) {
-    for (auto field : fields) {
+    size_t count = size();
+    for (size_t i = 0; i < count; i++) {
+        ObjectField* field = getField((int)i);
         if (equalsIgnoreCase(field->getName(), name))
             return field;
     }
+    return nullptr;
 }
 
 bool SMCApi::ObjectElement::isSimple() {
-    return std::all_of(fields.cbegin(), fields.cend(), [](ObjectField* field) { return field->isSimple(); });
+    size_t count = size();
+    for (size_t i = 0; i < count; i++) {
+        if (!getField((int)i)->isSimple())
+            return false;
+    }
+    return true;
+}
+
+size_t SMCApi::ObjectElement::getMemorySize() const {
+    size_t result = sizeof(ObjectElement);
+    if (pFields) {
+        result += sizeof(std::vector<ObjectField*>) + pFields->capacity() * sizeof(ObjectField*);
+        for (auto field : *pFields)
+            result += field->getMemorySize();
+    } else {
+        result += (values.capacity() - values.size()) * sizeof(ObjectField);
+        for (auto& field : values)
+            result += field.getMemorySize();
+    }
+    return result;
 }
 
 SMCApi::ObjectElement::~ObjectElement() {
-    for (auto field : fields)
-        delete field;
-    fields.clear();
+    if (pFields) {
+        for (auto field : *pFields)
+            delete field;
+        delete pFields;
+    }
 }
 
-SMCApi::ObjectElement::ObjectElement() {
+SMCApi::ObjectElement::ObjectElement() : pFields(nullptr) {
 }
 
 void SMCApi::ObjectArray::add(void* pValue, const SMCApi::ObjectType type, int id, size_t size) {
+    size_t itemSize = valueMemorySize(pValue, type, size);
+    if (pMemoryBudget)
+        pMemoryBudget->check(itemSize);
+    addChecked(pValue, type, id, size, itemSize);
+}
+
+void SMCApi::ObjectArray::addChecked(void* pValue, const SMCApi::ObjectType type, int id, size_t size, size_t itemSize) {
     if (id == -1) {
         objects.push_back(pValue);
         if (types)
@@ -804,82 +1471,60 @@ void SMCApi::ObjectArray::add(void* pValue, const SMCApi::ObjectType type, int i
         if (sizes)
             sizes->insert(sizes->begin() + id, size);
     }
+    itemsMemorySize += itemSize;
+    // observers first: spill of budget may remove items, so the position would be wrong after it
+    notifyAdded(id == -1 ? objects.size() - 1 : (size_t)id, 1);
+    updateMemoryBudget();
 }
 
 void SMCApi::ObjectArray::addCopy(void* pValue, const SMCApi::ObjectType type, size_t size) {
-    switch (type) {
-    case OT_OBJECT_ARRAY:
-        pValue = new ObjectArray((ObjectArray*)pValue);
-        break;
-    case OT_OBJECT_ELEMENT:
-        pValue = new ObjectElement((ObjectElement*)pValue);
-        break;
-    case OT_VALUE_ANY:
-        break;
-    case OT_STRING:
-        pValue = new std::wstring(*(std::wstring*)pValue);
-        break;
-    case OT_BYTE:
-    case OT_SHORT:
-    case OT_INTEGER:
-    case OT_LONG:
-    case OT_FLOAT:
-    case OT_DOUBLE:
-    case OT_BIG_INTEGER:
-    case OT_BIG_DECIMAL:
-        pValue = new Number((Number*)pValue);
-        break;
-    case OT_BYTES: {
-        long valueBytesLength = size;
-        auto oldValue = (signed char*)pValue;
-        pValue = new signed char[valueBytesLength];
-        memcpy(pValue, oldValue, valueBytesLength);
-        break;
-    }
-    case OT_BOOLEAN: {
-        auto value = *((bool*)pValue);
-        pValue = new bool;
-        *((bool*)pValue) = value;
-        break;
+    // budget is checked before copy (copy is not larger than value), so the copy is not lost if it is exceeded
+    if (pMemoryBudget)
+        pMemoryBudget->check(valueMemorySize(pValue, type, size));
+    void* pCopy = copyValue(pValue, type, size);
+    addChecked(pCopy, type, -1, size, valueMemorySize(pCopy, type, size));
+}
+
+void SMCApi::ObjectArray::addRange(void* const* values, size_t count, const SMCApi::ObjectType type, const SMCApi::ObjectType* valueTypes,
+                                   const size_t* valueSizes, int id) {
+    size_t itemsSize = 0;
+    for (size_t i = 0; i < count; i++)
+        itemsSize += valueMemorySize(values[i], valueTypes ? valueTypes[i] : type, valueSizes ? valueSizes[i] : 0);
+    if (pMemoryBudget)
+        pMemoryBudget->check(itemsSize);
+    addRangeChecked(values, count, type, valueTypes, valueSizes, id, itemsSize);
+}
+
+void SMCApi::ObjectArray::addRangeChecked(void* const* values, size_t count, const SMCApi::ObjectType type, const SMCApi::ObjectType* valueTypes,
+                                          const size_t* valueSizes, int id, size_t itemsSize) {
+    size_t position = id < 0 || (size_t)id > objects.size() ? objects.size() : (size_t)id;
+    objects.insert(objects.begin() + position, values, values + count);
+    if (types) {
+        if (valueTypes)
+            types->insert(types->begin() + position, valueTypes, valueTypes + count);
+        else
+            types->insert(types->begin() + position, count, type);
     }
+    if (sizes) {
+        if (valueSizes)
+            sizes->insert(sizes->begin() + position, valueSizes, valueSizes + count);
+        else
+            sizes->insert(sizes->begin() + position, count, 0);
     }
-    add(pValue, type, -1, size);
+    itemsMemorySize += itemsSize;
+    notifyAdded(position, count);
+    updateMemoryBudget();
+}
+
+void SMCApi::ObjectArray::deleteValue(int id) {
+    destroyValue(objects[id], getItemType(id));
+    objects[id] = nullptr;
 }
 
 void SMCApi::ObjectArray::deleteItem(int id) {
     if (objects.size() <= id)
         return;
-    void* pValue = objects[id];
-    switch (type) {
-    case ObjectType::OT_BYTE:
-    case ObjectType::OT_SHORT:
-    case ObjectType::OT_INTEGER:
-    case ObjectType::OT_LONG:
-    case ObjectType::OT_FLOAT:
-    case ObjectType::OT_DOUBLE:
-    case ObjectType::OT_BIG_INTEGER:
-    case ObjectType::OT_BIG_DECIMAL:
-        delete (Number*)pValue;
-        break;
-    case OT_OBJECT_ARRAY:
-        delete (ObjectArray*)pValue;
-        break;
-    case OT_OBJECT_ELEMENT:
-        delete (ObjectElement*)pValue;
-        break;
-    case OT_STRING:
-        delete (std::wstring*)pValue;
-        break;
-    case OT_BYTES:
-        delete[] (signed char*)pValue;
-        break;
-    case OT_BOOLEAN:
-        delete (bool*)pValue;
-        break;
-    default:
-        break;
-    }
-    pValue = nullptr;
+    deleteValue(id);
     objects.erase(objects.begin() + id);
     if (types && types->size() > id)
         types->erase(types->begin() + id);
@@ -887,14 +1532,57 @@ void SMCApi::ObjectArray::deleteItem(int id) {
         sizes->erase(sizes->begin() + id);
 }
 
-SMCApi::ObjectArray::ObjectArray(const SMCApi::ObjectType type) : type(type), types(nullptr), sizes(nullptr) {
+void SMCApi::ObjectArray::notifyAdded(size_t from, size_t count) const {
+    if (observers == nullptr)
+        return;
+    for (auto observer : *observers) {
+        for (size_t i = from; i < from + count; i++)
+            observer->added(getItemType((int)i), objects[i]);
+    }
+}
+
+void SMCApi::ObjectArray::notifyRemoved(size_t from, size_t count) const {
+    if (observers == nullptr)
+        return;
+    for (auto observer : *observers) {
+        for (size_t i = from; i < from + count; i++)
+            observer->removed(getItemType((int)i), objects[i]);
+    }
+}
+
+SMCApi::ObjectType SMCApi::ObjectArray::getItemType(int id) const {
+    return types && types->size() > id ? types->at(id) : type;
+}
+
+size_t SMCApi::ObjectArray::getItemMemorySize(int id) const {
+    return valueMemorySize(objects[id], getItemType(id), sizes && sizes->size() > id ? sizes->at(id) : 0);
+}
+
+void SMCApi::ObjectArray::updateMemoryBudget() {
+    if (pMemoryBudget == nullptr)
+        return;
+    size_t size = getMemorySize();
+    if (size > chargedMemorySize) {
+        size_t delta = size - chargedMemorySize;
+        chargedMemorySize = size;
+        pMemoryBudget->charge(this, delta);
+    } else if (size < chargedMemorySize) {
+        size_t delta = chargedMemorySize - size;
+        chargedMemorySize = size;
+        pMemoryBudget->release(delta);
+    }
+}
+
+SMCApi::ObjectArray::ObjectArray(const SMCApi::ObjectType type) : type(type), types(nullptr), sizes(nullptr), itemsMemorySize(0), chargedMemorySize(0),
+                                                                  pMemoryBudget(nullptr), observers(nullptr) {
     if (type == ObjectType::OT_VALUE_ANY)
         types = new std::vector<ObjectType>;
     if (type == ObjectType::OT_BYTES || type == ObjectType::OT_VALUE_ANY)
         sizes = new std::vector<size_t>;
 }
 
-SMCApi::ObjectArray::ObjectArray(const SMCApi::ObjectArray* objectArray) : type(objectArray->type), types(nullptr), sizes(nullptr) {
+SMCApi::ObjectArray::ObjectArray(const SMCApi::ObjectArray* objectArray) : type(objectArray->type), types(nullptr), sizes(nullptr), itemsMemorySize(0),
+                                                                          chargedMemorySize(0), pMemoryBudget(nullptr), observers(nullptr) {
     std::vector<size_t>* sizesTmp = nullptr;
     if (objectArray->sizes) {
         sizes = new std::vector<size_t>;
@@ -902,8 +1590,10 @@ SMCApi::ObjectArray::ObjectArray(const SMCApi::ObjectArray* objectArray) : type(
         for (auto t : *(objectArray->sizes))
             sizesTmp->push_back(t);
     }
-    if (objectArray->types) {
+    if (objectArray->types)
         types = new std::vector<ObjectType>;
+    reserve(objectArray->objects.size());
+    if (objectArray->types) {
         auto typesTmp = new std::vector<ObjectType>;
         for (auto t : *(objectArray->types))
             typesTmp->push_back(t);
@@ -925,62 +1615,200 @@ size_t SMCApi::ObjectArray::size() const {
 
 void SMCApi::ObjectArray::add(const std::wstring* value, int id) {
     if (type != ObjectType::OT_STRING && type != ObjectType::OT_VALUE_ANY) {
-        std::wstring error(L"wrong type");
-        throw ModuleException(error);
+        throw ModuleException(L"wrong type");
+    }
+    auto* pValue = value ? new Utf8String(Utf8String::adopt((std::wstring*)value)) : nullptr;
+    try {
+        add((void*)pValue, ObjectType::OT_STRING, id);
+    } catch (...) {
+        if (pValue)
+            pValue->releaseWide();
+        delete pValue;
+        throw;
+    }
+}
+
+void SMCApi::ObjectArray::add(const SMCApi::Utf8String& value, int id) {
+    add(Utf8String(value), id);
+}
+
+void SMCApi::ObjectArray::add(SMCApi::Utf8String&& value, int id) {
+    if (type != ObjectType::OT_STRING && type != ObjectType::OT_VALUE_ANY) {
+        throw ModuleException(L"wrong type");
+    }
+    auto* pValue = new Utf8String(std::move(value));
+    try {
+        add((void*)pValue, ObjectType::OT_STRING, id);
+    } catch (...) {
+        delete pValue;
+        throw;
     }
-    add((void*)value, ObjectType::OT_STRING, id);
 }
 
 void SMCApi::ObjectArray::add(const SMCApi::Number* value, int id) {
     if (type != ObjectType::OT_BYTE && type != ObjectType::OT_SHORT && type != ObjectType::OT_INTEGER && type != ObjectType::OT_LONG &&
         type != ObjectType::OT_FLOAT && type != ObjectType::OT_DOUBLE && type != ObjectType::OT_BIG_INTEGER &&
         type != ObjectType::OT_BIG_DECIMAL && type != ObjectType::OT_VALUE_ANY) {
-        std::wstring error(L"wrong type");
-        throw ModuleException(error);
+        throw ModuleException(L"wrong type");
     }
     add((void*)value, (ObjectType)convertToObject(((SMCApi::Number*)value)->getType()), id);
 }
 
 void SMCApi::ObjectArray::add(const signed char* value, size_t size, int id) {
     if (type != ObjectType::OT_BYTES && type != ObjectType::OT_VALUE_ANY) {
-        std::wstring error(L"wrong type");
-        throw ModuleException(error);
+        throw ModuleException(L"wrong type");
+    }
+    if (pMemoryBudget)
+        pMemoryBudget->check(sizeof(ByteBuffer) + size);
+    add(value ? new ByteBuffer(ByteBuffer::adopt((signed char*)value, size)) : nullptr, ObjectType::OT_BYTES, id, size);
+}
+
+void SMCApi::ObjectArray::add(const SMCApi::ByteBuffer& value, int id) {
+    if (type != ObjectType::OT_BYTES && type != ObjectType::OT_VALUE_ANY) {
+        throw ModuleException(L"wrong type");
+    }
+    auto* pValue = new ByteBuffer(value);
+    try {
+        add(pValue, ObjectType::OT_BYTES, id, value.getSize());
+    } catch (...) {
+        delete pValue;
+        throw;
     }
-    add((void*)value, ObjectType::OT_BYTES, id);
 }
 
 void SMCApi::ObjectArray::add(const bool value, int id) {
     if (type != ObjectType::OT_BOOLEAN && type != ObjectType::OT_VALUE_ANY) {
-        std::wstring error(L"wrong type");
-        throw ModuleException(error);
+        throw ModuleException(L"wrong type");
     }
     auto* valueInternal = new bool;
     *valueInternal = value;
-    add((void*)valueInternal, ObjectType::OT_BOOLEAN, id);
+    try {
+        add((void*)valueInternal, ObjectType::OT_BOOLEAN, id);
+    } catch (...) {
+        delete valueInternal;
+        throw;
+    }
 }
 
 void SMCApi::ObjectArray::add(const SMCApi::ObjectArray* value, int id) {
     if (type != ObjectType::OT_OBJECT_ARRAY) {
-        std::wstring error(L"wrong type");
-        throw ModuleException(error);
+        throw ModuleException(L"wrong type");
     }
     add((void*)value, ObjectType::OT_OBJECT_ARRAY, id);
 }
 
 void SMCApi::ObjectArray::add(const SMCApi::ObjectElement* value, int id) {
     if (type != ObjectType::OT_OBJECT_ELEMENT) {
-        std::wstring error(L"wrong type");
-        throw ModuleException(error);
+        throw ModuleException(L"wrong type");
     }
     add((void*)value, ObjectType::OT_OBJECT_ELEMENT, id);
 }
 
+void SMCApi::ObjectArray::add(const std::wstring* const* values, size_t count, int id) {
+    if (type != ObjectType::OT_STRING && type != ObjectType::OT_VALUE_ANY) {
+        throw ModuleException(L"wrong type");
+    }
+    std::vector<void*> valuesInternal(count);
+    for (size_t i = 0; i < count; i++)
+        valuesInternal[i] = values[i] ? new Utf8String(Utf8String::adopt((std::wstring*)values[i])) : nullptr;
+    try {
+        addRange(valuesInternal.data(), count, ObjectType::OT_STRING, nullptr, nullptr, id);
+    } catch (...) {
+        for (void* pValue : valuesInternal) {
+            if (pValue)
+                ((Utf8String*)pValue)->releaseWide();
+            delete (Utf8String*)pValue;
+        }
+        throw;
+    }
+}
+
+void SMCApi::ObjectArray::add(const SMCApi::Number* const* values, size_t count, int id) {
+    if (type != ObjectType::OT_BYTE && type != ObjectType::OT_SHORT && type != ObjectType::OT_INTEGER && type != ObjectType::OT_LONG &&
+        type != ObjectType::OT_FLOAT && type != ObjectType::OT_DOUBLE && type != ObjectType::OT_BIG_INTEGER &&
+        type != ObjectType::OT_BIG_DECIMAL && type != ObjectType::OT_VALUE_ANY) {
+        throw ModuleException(L"wrong type");
+    }
+    std::vector<ObjectType> valueTypes(count);
+    for (size_t i = 0; i < count; i++)
+        valueTypes[i] = convertToObject(((SMCApi::Number*)values[i])->getType());
+    addRange((void* const*)values, count, type, valueTypes.data(), nullptr, id);
+}
+
+void SMCApi::ObjectArray::add(const signed char* const* values, const size_t* valueSizes, size_t count, int id) {
+    if (type != ObjectType::OT_BYTES && type != ObjectType::OT_VALUE_ANY) {
+        throw ModuleException(L"wrong type");
+    }
+    // budget is checked before arrays are adopted, after adoption they are owned by this array
+    size_t itemsSize = 0;
+    for (size_t i = 0; i < count; i++)
+        itemsSize += values[i] ? sizeof(ByteBuffer) + valueSizes[i] : 0;
+    if (pMemoryBudget)
+        pMemoryBudget->check(itemsSize);
+    std::vector<void*> valuesInternal(count);
+    for (size_t i = 0; i < count; i++)
+        valuesInternal[i] = values[i] ? new ByteBuffer(ByteBuffer::adopt((signed char*)values[i], valueSizes[i])) : nullptr;
+    addRangeChecked(valuesInternal.data(), count, ObjectType::OT_BYTES, nullptr, valueSizes, id, itemsSize);
+}
+
+void SMCApi::ObjectArray::add(const bool* values, size_t count, int id) {
+    if (type != ObjectType::OT_BOOLEAN && type != ObjectType::OT_VALUE_ANY) {
+        throw ModuleException(L"wrong type");
+    }
+    std::vector<void*> valuesInternal(count);
+    for (size_t i = 0; i < count; i++)
+        valuesInternal[i] = new bool(values[i]);
+    try {
+        addRange(valuesInternal.data(), count, ObjectType::OT_BOOLEAN, nullptr, nullptr, id);
+    } catch (...) {
+        for (void* pValue : valuesInternal)
+            delete (bool*)pValue;
+        throw;
+    }
+}
+
+void SMCApi::ObjectArray::add(const SMCApi::Utf8String* values, size_t count, int id) {
+    if (type != ObjectType::OT_STRING && type != ObjectType::OT_VALUE_ANY) {
+        throw ModuleException(L"wrong type");
+    }
+    std::vector<void*> valuesInternal(count);
+    for (size_t i = 0; i < count; i++)
+        valuesInternal[i] = new Utf8String(values[i]);
+    try {
+        addRange(valuesInternal.data(), count, ObjectType::OT_STRING, nullptr, nullptr, id);
+    } catch (...) {
+        for (void* pValue : valuesInternal)
+            delete (Utf8String*)pValue;
+        throw;
+    }
+}
+
+void SMCApi::ObjectArray::add(const SMCApi::ObjectArray* const* values, size_t count, int id) {
+    if (type != ObjectType::OT_OBJECT_ARRAY) {
+        throw ModuleException(L"wrong type");
+    }
+    addRange((void* const*)values, count, ObjectType::OT_OBJECT_ARRAY, nullptr, nullptr, id);
+}
+
+void SMCApi::ObjectArray::add(const SMCApi::ObjectElement* const* values, size_t count, int id) {
+    if (type != ObjectType::OT_OBJECT_ELEMENT) {
+        throw ModuleException(L"wrong type");
+    }
+    addRange((void* const*)values, count, ObjectType::OT_OBJECT_ELEMENT, nullptr, nullptr, id);
+}
+
 const std::wstring* SMCApi::ObjectArray::getString(int id) const {
     if (type != ObjectType::OT_STRING && (type != ObjectType::OT_VALUE_ANY || (types == nullptr || types->at(id) != ObjectType::OT_STRING))) {
-        std::wstring error(L"wrong type");
-        throw ModuleException(error);
+        throw ModuleException(L"wrong type");
+    }
+    return objects[id] ? ((Utf8String*)objects[id])->getWide() : nullptr;
+}
+
+const SMCApi::Utf8String* SMCApi::ObjectArray::getUtf8(int id) const {
+    if (type != ObjectType::OT_STRING && (type != ObjectType::OT_VALUE_ANY || (types == nullptr || types->at(id) != ObjectType::OT_STRING))) {
+        throw ModuleException(L"wrong type");
     }
-    return (std::wstring*)objects[id];
+    return (Utf8String*)objects[id];
 }
 
 const SMCApi::Number* SMCApi::ObjectArray::getNumber(int id) const {
@@ -996,8 +1824,7 @@ const SMCApi::Number* SMCApi::ObjectArray::getNumber(int id) const {
                 vType != ObjectType::OT_BIG_DECIMAL;
         }
         if (isError) {
-            std::wstring error(L"wrong type");
-            throw ModuleException(error);
+            throw ModuleException(L"wrong type");
         }
     }
     return (Number*)objects[id];
@@ -1005,32 +1832,35 @@ const SMCApi::Number* SMCApi::ObjectArray::getNumber(int id) const {
 
 const signed char* SMCApi::ObjectArray::getBytes(int id) const {
     if (type != ObjectType::OT_BYTES && (type != ObjectType::OT_VALUE_ANY || (types == nullptr || types->at(id) != ObjectType::OT_BYTES))) {
-        std::wstring error(L"wrong type");
-        throw ModuleException(error);
+        throw ModuleException(L"wrong type");
     }
-    return (signed char*)objects[id];
+    return objects[id] ? ((ByteBuffer*)objects[id])->getData() : nullptr;
 }
 
 const size_t SMCApi::ObjectArray::getBytesCount(int id) const {
     if (type != ObjectType::OT_BYTES && (type != ObjectType::OT_VALUE_ANY || (types == nullptr || types->at(id) != ObjectType::OT_BYTES))) {
-        std::wstring error(L"wrong type");
-        throw ModuleException(error);
+        throw ModuleException(L"wrong type");
     }
     return id >= 0 && sizes && sizes->size() > id ? sizes->at(id) : 0;
 }
 
+const SMCApi::ByteBuffer* SMCApi::ObjectArray::getByteBuffer(int id) const {
+    if (type != ObjectType::OT_BYTES && (type != ObjectType::OT_VALUE_ANY || (types == nullptr || types->at(id) != ObjectType::OT_BYTES))) {
+        throw ModuleException(L"wrong type");
+    }
+    return (ByteBuffer*)objects[id];
+}
+
 const SMCApi::ObjectArray* SMCApi::ObjectArray::getObjectArray(int id) const {
     if (type != ObjectType::OT_OBJECT_ARRAY) {
-        std::wstring error(L"wrong type");
-        throw ModuleException(error);
+        throw ModuleException(L"wrong type");
     }
     return (ObjectArray*)objects[id];
 }
 
 const SMCApi::ObjectElement* SMCApi::ObjectArray::getObjectElement(int id) const {
     if (type != ObjectType::OT_OBJECT_ELEMENT) {
-        std::wstring error(L"wrong type");
-        throw ModuleException(error);
+        throw ModuleException(L"wrong type");
     }
     return (ObjectElement*)objects[id];
 }
@@ -1040,14 +1870,104 @@ SMCApi::ObjectType SMCApi::ObjectArray::getType(int id) {
 }
 
 void SMCApi::ObjectArray::remove(int id) {
+    if (objects.size() <= id)
+        return;
+    notifyRemoved((size_t)id, 1);
+    size_t itemSize = getItemMemorySize(id);
     deleteItem(id);
+    itemsMemorySize -= std::min(itemSize, itemsMemorySize);
+    updateMemoryBudget();
+}
+
+void SMCApi::ObjectArray::remove(int from, int to) {
+    if (from < 0)
+        from = 0;
+    if (to > objects.size())
+        to = (int)objects.size();
+    if (from >= to)
+        return;
+    notifyRemoved((size_t)from, (size_t)(to - from));
+    size_t itemsSize = 0;
+    for (int i = from; i < to; i++) {
+        itemsSize += getItemMemorySize(i);
+        deleteValue(i);
+    }
+    objects.erase(objects.begin() + from, objects.begin() + to);
+    if (types && types->size() >= to)
+        types->erase(types->begin() + from, types->begin() + to);
+    if (sizes && sizes->size() >= to)
+        sizes->erase(sizes->begin() + from, sizes->begin() + to);
+    itemsMemorySize -= std::min(itemsSize, itemsMemorySize);
+    updateMemoryBudget();
+}
+
+void SMCApi::ObjectArray::clear() {
+    if (observers) {
+        for (auto observer : *observers)
+            observer->cleared();
+    }
+    for (int i = 0; i < objects.size(); i++)
+        deleteValue(i);
+    objects.clear();
+    if (types)
+        types->clear();
+    if (sizes)
+        sizes->clear();
+    itemsMemorySize = 0;
+    updateMemoryBudget();
+}
+
+void SMCApi::ObjectArray::reorder(const std::vector<size_t>& order) {
+    std::vector<bool> used(objects.size(), false);
+    for (size_t id : order) {
+        if (id >= objects.size() || used[id])
+            throw ModuleException(L"wrong order");
+        used[id] = true;
+    }
+    size_t itemsSize = 0;
+    for (size_t i = 0; i < objects.size(); i++) {
+        if (!used[i]) {
+            notifyRemoved(i, 1);
+            itemsSize += getItemMemorySize((int)i);
+            deleteValue((int)i);
+        }
+    }
+    std::vector<void*> newObjects;
+    newObjects.reserve(order.size());
+    for (size_t id : order)
+        newObjects.push_back(objects[id]);
+    if (types) {
+        std::vector<ObjectType> newTypes;
+        newTypes.reserve(order.size());
+        for (size_t id : order)
+            newTypes.push_back(getItemType((int)id));
+        types->swap(newTypes);
+    }
+    if (sizes) {
+        std::vector<size_t> newSizes;
+        newSizes.reserve(order.size());
+        for (size_t id : order)
+            newSizes.push_back(sizes->size() > id ? (*sizes)[id] : 0);
+        sizes->swap(newSizes);
+    }
+    objects.swap(newObjects);
+    itemsMemorySize -= std::min(itemsSize, itemsMemorySize);
+    updateMemoryBudget();
+}
+
+void SMCApi::ObjectArray::reserve(size_t count) {
+    objects.reserve(count);
+    if (types)
+        types->reserve(count);
+    if (sizes)
+        sizes->reserve(count);
+    updateMemoryBudget();
 }
 
 bool SMCApi::ObjectArray::getBoolean(int id) const {
     if (type != ObjectType::OT_BOOLEAN &&
         (type != ObjectType::OT_VALUE_ANY || (types == nullptr || types->at(id) != ObjectType::OT_BOOLEAN))) {
-        std::wstring error(L"wrong type");
-        throw ModuleException(error);
+        throw ModuleException(L"wrong type");
     }
     return *((bool*)objects[id]);
 }
@@ -1056,9 +1976,67 @@ bool SMCApi::ObjectArray::isSimple() {
     return ObjectType::OT_OBJECT_ARRAY != type && ObjectType::OT_OBJECT_ELEMENT != type;
 }
 
+size_t SMCApi::ObjectArray::getMemorySize() const {
+    size_t result = sizeof(ObjectArray) + objects.capacity() * sizeof(void*) + itemsMemorySize;
+    if (types)
+        result += sizeof(std::vector<ObjectType>) + types->capacity() * sizeof(ObjectType);
+    if (sizes)
+        result += sizeof(std::vector<size_t>) + sizes->capacity() * sizeof(size_t);
+    return result;
+}
+
+size_t SMCApi::ObjectArray::recalculateMemorySize() {
+    itemsMemorySize = 0;
+    for (int i = 0; i < objects.size(); i++) {
+        if (objects[i] != nullptr && getType(i) == ObjectType::OT_OBJECT_ARRAY)
+            ((ObjectArray*)objects[i])->recalculateMemorySize();
+        else if (objects[i] != nullptr && getType(i) == ObjectType::OT_OBJECT_ELEMENT)
+            recalculateElement((const ObjectElement*)objects[i]);
+        itemsMemorySize += getItemMemorySize(i);
+    }
+    updateMemoryBudget();
+    return getMemorySize();
+}
+
+void SMCApi::ObjectArray::setMemoryBudget(SMCApi::MemoryBudget* budget) {
+    if (pMemoryBudget)
+        pMemoryBudget->release(chargedMemorySize);
+    chargedMemorySize = 0;
+    pMemoryBudget = budget;
+    updateMemoryBudget();
+}
+
+SMCApi::MemoryBudget* SMCApi::ObjectArray::getMemoryBudget() const {
+    return pMemoryBudget;
+}
+
+void SMCApi::ObjectArray::addObserver(SMCApi::ObjectArrayObserver* observer) {
+    if (observers == nullptr)
+        observers = new std::vector<ObjectArrayObserver*>;
+    observers->push_back(observer);
+}
+
+void SMCApi::ObjectArray::removeObserver(SMCApi::ObjectArrayObserver* observer) {
+    if (observers == nullptr)
+        return;
+    observers->erase(std::remove(observers->begin(), observers->end(), observer), observers->end());
+    if (observers->empty()) {
+        delete observers;
+        observers = nullptr;
+    }
+}
+
 SMCApi::ObjectArray::~ObjectArray() {
-    for (int i = objects.size() - 1; i >= 0; --i)
-        deleteItem(i);
+    if (observers) {
+        std::vector<ObjectArrayObserver*>* detached = observers;
+        observers = nullptr;
+        for (auto observer : *detached)
+            observer->detached();
+        delete detached;
+    }
+    setMemoryBudget(nullptr);
+    for (int i = 0; i < objects.size(); i++)
+        deleteValue(i);
     objects.clear();
     if (types) {
         types->clear();
@@ -1072,18 +2050,67 @@ SMCApi::ObjectArray::~ObjectArray() {
 }
 
 const void* SMCApi::ObjectArray::get(int id) const {
+    const void* pValue = objects[id];
+    if (pValue == nullptr)
+        return nullptr;
+    ObjectType itemType = getItemType(id);
+    if (itemType == ObjectType::OT_STRING)
+        return ((const Utf8String*)pValue)->getWide();
+    if (itemType == ObjectType::OT_BYTES)
+        return ((const ByteBuffer*)pValue)->getData();
+    return pValue;
+}
+
+const void* SMCApi::ObjectArray::getStored(int id) const {
     return objects[id];
 }
 
-SMCApi::ModuleException::ModuleException(const std::wstring& msg) : message(msg) {
+const std::wstring* SMCApi::ObjectArray::tryGetString(int id) const {
+    return id >= 0 && id < objects.size() && getItemType(id) == ObjectType::OT_STRING && objects[id] ? ((Utf8String*)objects[id])->getWide() : nullptr;
 }
 
-SMCApi::ModuleException::ModuleException(const std::wstring* pMsg): message(*pMsg) {
+const SMCApi::Utf8String* SMCApi::ObjectArray::tryGetUtf8(int id) const {
+    return id >= 0 && id < objects.size() && getItemType(id) == ObjectType::OT_STRING ? (Utf8String*)objects[id] : nullptr;
+}
+
+const SMCApi::Number* SMCApi::ObjectArray::tryGetNumber(int id) const {
+    return id >= 0 && id < objects.size() && isNumber(getItemType(id)) ? (Number*)objects[id] : nullptr;
+}
+
+const signed char* SMCApi::ObjectArray::tryGetBytes(int id) const {
+    return id >= 0 && id < objects.size() && getItemType(id) == ObjectType::OT_BYTES && objects[id] ? ((ByteBuffer*)objects[id])->getData() : nullptr;
+}
+
+const bool* SMCApi::ObjectArray::tryGetBoolean(int id) const {
+    return id >= 0 && id < objects.size() && getItemType(id) == ObjectType::OT_BOOLEAN ? (bool*)objects[id] : nullptr;
+}
+
+const SMCApi::ObjectArray* SMCApi::ObjectArray::tryGetObjectArray(int id) const {
+    return id >= 0 && id < objects.size() && getItemType(id) == ObjectType::OT_OBJECT_ARRAY ? (ObjectArray*)objects[id] : nullptr;
+}
+
+const SMCApi::ObjectElement* SMCApi::ObjectArray::tryGetObjectElement(int id) const {
+    return id >= 0 && id < objects.size() && getItemType(id) == ObjectType::OT_OBJECT_ELEMENT ? (ObjectElement*)objects[id] : nullptr;
+}
+
+SMCApi::ModuleException::ModuleException(const std::wstring& msg) : staticMessage(nullptr), message(msg) {
+}
+
+SMCApi::ModuleException::ModuleException(const std::wstring* pMsg): staticMessage(nullptr), message(*pMsg) {
     delete pMsg;
 }
 
 const std::wstring* SMCApi::ModuleException::getMessage() const {
-    return &(this->message);
+    if (staticMessage == nullptr)
+        return &(this->message);
+    // exception is not changed, it may be read by several threads (std::exception_ptr)
+    LiteralMessages& literalMessages = getLiteralMessages();
+    std::lock_guard<std::mutex> lock(literalMessages.mutex);
+    return &*literalMessages.messages.emplace(staticMessage).first;
+}
+
+const wchar_t* SMCApi::ModuleException::getMessageText() const {
+    return staticMessage ? staticMessage : message.c_str();
 }
 
 SMCApi::ModuleException::~ModuleException() = default;
@@ -0,0 +1,386 @@
+/*
+Library (provider c++), is a part of the platform Shelf MK (Shell for modular structures, SMC platform).
+The author and copyright holder of the software package (application) Shelf MK (Shell for modular structures, SMC platform) is Ulyanov Nikolay Vladimirovich (ulianownv@mail.ru).
+The following are prohibited: changing and distributing the program code, selling/reselling it, as well as other actions and rights not expressly permitted.
+*/
+
+#include "SMCApi.h"
+#include <type_traits>
+
+#ifndef SMCMODULEDEFINITIONPROVIDER_SMCAPIBINDING_H
+#define SMCMODULEDEFINITIONPROVIDER_SMCAPIBINDING_H
+
+namespace SMCApi {
+    /**
+     * conversion of one C++ type to ObjectField value
+     * encode sets value of field, decode reads value (false if field is null or has other type)
+     *
+     * @version 1.0.0
+     */
+    template<typename M>
+    struct FieldCodec;
+
+    /**
+     * codec for numbers, NumberType is given by C++ type, on decode any number type is accepted
+     */
+    template<typename M, typename Internal>
+    struct NumberFieldCodec {
+        static bool accepts(ObjectType type) {
+            return type >= OT_BYTE && type <= OT_BIG_DECIMAL;
+        }
+
+        static void encode(const M& value, ObjectField* field) {
+            field->setValue(Number((Internal)value));
+        }
+
+        static bool decode(const ObjectField* field, M& value) {
+            auto* number = (Number*)field->tryGetValueNumber();
+            if (number == nullptr)
+                return false;
+            if (std::is_floating_point<M>::value)
+                value = (M)number->doubleValue();
+            else
+                value = (M)number->longValue();
+            return true;
+        }
+    };
+
+    template<>
+    struct FieldCodec<signed char> : NumberFieldCodec<signed char, signed char> {
+    };
+
+    template<>
+    struct FieldCodec<short> : NumberFieldCodec<short, short> {
+    };
+
+    template<>
+    struct FieldCodec<int> : NumberFieldCodec<int, long> {
+    };
+
+    template<>
+    struct FieldCodec<long> : NumberFieldCodec<long, long> {
+    };
+
+    template<>
+    struct FieldCodec<long long int> : NumberFieldCodec<long long int, long long int> {
+    };
+
+    template<>
+    struct FieldCodec<float> : NumberFieldCodec<float, float> {
+    };
+
+    template<>
+    struct FieldCodec<double> : NumberFieldCodec<double, double> {
+    };
+
+    template<>
+    struct FieldCodec<bool> {
+        static bool accepts(ObjectType type) {
+            return type == OT_BOOLEAN;
+        }
+
+        static void encode(const bool& value, ObjectField* field) {
+            field->setValue(value);
+        }
+
+        static bool decode(const ObjectField* field, bool& value) {
+            const bool* result = field->tryGetValueBoolean();
+            if (result == nullptr)
+                return false;
+            value = *result;
+            return true;
+        }
+    };
+
+    template<>
+    struct FieldCodec<std::wstring> {
+        static bool accepts(ObjectType type) {
+            return type == OT_STRING;
+        }
+
+        static void encode(const std::wstring& value, ObjectField* field) {
+            field->setValue(Utf8String(value));
+        }
+
+        static bool decode(const ObjectField* field, std::wstring& value) {
+            const std::wstring* result = field->tryGetValueString();
+            if (result == nullptr)
+                return false;
+            value.assign(*result);
+            return true;
+        }
+    };
+
+    /**
+     * codec for std::string, value is UTF-8 and is stored without conversion
+     */
+    template<>
+    struct FieldCodec<std::string> {
+        static bool accepts(ObjectType type) {
+            return type == OT_STRING;
+        }
+
+        static void encode(const std::string& value, ObjectField* field) {
+            field->setValue(Utf8String(value));
+        }
+
+        static bool decode(const ObjectField* field, std::string& value) {
+            const Utf8String* result = field->tryGetValueUtf8();
+            if (result == nullptr)
+                return false;
+            value.assign(result->getValue());
+            return true;
+        }
+    };
+
+    template<>
+    struct FieldCodec<std::vector<signed char>> {
+        static bool accepts(ObjectType type) {
+            return type == OT_BYTES;
+        }
+
+        static void encode(const std::vector<signed char>& value, ObjectField* field) {
+            field->setValue(ByteBuffer(value.data(), value.size()));
+        }
+
+        static bool decode(const ObjectField* field, std::vector<signed char>& value) {
+            const signed char* result = field->tryGetValueBytes();
+            if (result == nullptr)
+                return false;
+            value.assign(result, result + field->getBytesCount());
+            return true;
+        }
+    };
+
+    /**
+     * binding of C++ struct to ObjectElement, list of fields is set once
+     * example:
+     *  static const ObjectBinding<Trade> binding = ObjectBinding<Trade>().field(L"id", &Trade::id).field(L"price", &Trade::price);
+     *  ObjectArray* array = binding.encodeArray(trades);
+     *  binding.decodeArray(array, trades);
+     * on decode of array positions of fields are found by names once and are reused while elements have the same layout
+     * (count of fields, names and types at the same positions), so elements of one array are decoded without string comparisons
+     *
+     * @version 1.0.0
+     */
+    template<typename T>
+    class ObjectBinding {
+    public:
+        /**
+         * positions of fields of binding in element, -1 if not found
+         */
+        class Layout {
+        private:
+            std::vector<int> positions;
+            size_t count;
+
+            friend class ObjectBinding<T>;
+
+        public:
+            Layout() : count(0) {
+            }
+        };
+
+    private:
+        class FieldBinding {
+        public:
+            const std::wstring name;
+            const unsigned int nameId;
+
+            explicit FieldBinding(const std::wstring& name) : name(name), nameId(SymbolTable::intern(name)) {
+            }
+
+            virtual bool accepts(ObjectType type) const = 0;
+
+            virtual void encode(const T& value, ObjectField* field) const = 0;
+
+            virtual void decode(const ObjectField* field, T& value) const = 0;
+
+            virtual ~FieldBinding() = default;
+        };
+
+        template<typename M>
+        class MemberBinding : public FieldBinding {
+        private:
+            M T::* member;
+
+        public:
+            MemberBinding(const std::wstring& name, M T::* member) : FieldBinding(name), member(member) {
+            }
+
+            bool accepts(ObjectType type) const override {
+                return FieldCodec<M>::accepts(type);
+            }
+
+            void encode(const T& value, ObjectField* field) const override {
+                FieldCodec<M>::encode(value.*member, field);
+            }
+
+            void decode(const ObjectField* field, T& value) const override {
+                FieldCodec<M>::decode(field, value.*member);
+            }
+        };
+
+        std::vector<std::shared_ptr<FieldBinding>> fields;
+
+        bool matches(const Layout& layout, const ObjectElement* element) const {
+            if (layout.positions.size() != fields.size() || layout.count != element->size())
+                return false;
+            for (size_t i = 0; i < fields.size(); i++) {
+                int position = layout.positions[i];
+                if (position >= 0) {
+                    const ObjectField* field = element->getField(position);
+                    if (field->getNameId() != fields[i]->nameId || !fields[i]->accepts(field->getType()))
+                        return false;
+                } else {
+                    // field, which was not found, should not be in element
+                    for (size_t j = 0; j < layout.count; j++) {
+                        if (element->getField((int)j)->getNameId() == fields[i]->nameId)
+                            return false;
+                    }
+                }
+            }
+            return true;
+        }
+
+    public:
+        /**
+         * add field
+         *
+         * @param name                  name of field in ObjectElement
+         * @param member                pointer to member, type should have FieldCodec
+         * @return this
+         */
+        template<typename M>
+        ObjectBinding& field(const std::wstring& name, M T::* member) {
+            fields.push_back(std::make_shared<MemberBinding<M>>(name, member));
+            return *this;
+        }
+
+        size_t size() const {
+            return fields.size();
+        }
+
+        /**
+         * find positions of fields in element by name ids
+         *
+         * @param element               ObjectElement
+         * @return Layout
+         */
+        Layout getLayout(const ObjectElement* element) const {
+            Layout layout;
+            layout.count = element->size();
+            layout.positions.assign(fields.size(), -1);
+            for (size_t i = 0; i < fields.size(); i++) {
+                for (size_t j = 0; j < layout.count; j++) {
+                    if (element->getField((int)j)->getNameId() == fields[i]->nameId) {
+                        layout.positions[i] = (int)j;
+                        break;
+                    }
+                }
+            }
+            return layout;
+        }
+
+        /**
+         * create element, fields are in order of binding
+         *
+         * @param value                 value
+         * @return ObjectElement, caller owns it
+         */
+        ObjectElement* encode(const T& value) const {
+            auto* element = new ObjectElement();
+            encode(value, element);
+            return element;
+        }
+
+        /**
+         * write value in element, if element has fields with names in order of binding (example: encoded before) fields are reused
+         *
+         * @param value                 value
+         * @param element               ObjectElement
+         */
+        void encode(const T& value, ObjectElement* element) const {
+            bool reuse = element->size() == fields.size();
+            for (size_t i = 0; reuse && i < fields.size(); i++)
+                reuse = element->getField((int)i)->getNameId() == fields[i]->nameId;
+            if (!reuse) {
+                element->clear();
+                element->reserve(fields.size());
+                for (auto& field : fields)
+                    element->add(ObjectField(field->nameId, OT_INTEGER));
+            }
+            for (size_t i = 0; i < fields.size(); i++)
+                fields[i]->encode(value, element->getField((int)i));
+        }
+
+        /**
+         * read value from element, fields are found by names
+         * fields which are not found, null or have other type are not changed
+         *
+         * @param element               ObjectElement
+         * @param value                 value
+         */
+        void decode(const ObjectElement* element, T& value) const {
+            decode(element, getLayout(element), value);
+        }
+
+        /**
+         * read value from element with known layout, without string comparisons
+         *
+         * @param element               ObjectElement with the same layout
+         * @param layout                Layout from getLayout
+         * @param value                 value
+         */
+        void decode(const ObjectElement* element, const Layout& layout, T& value) const {
+            for (size_t i = 0; i < fields.size(); i++) {
+                int position = layout.positions[i];
+                if (position >= 0 && (size_t)position < element->size())
+                    fields[i]->decode(element->getField(position), value);
+            }
+        }
+
+        /**
+         * create array of elements
+         *
+         * @param values                values
+         * @return ObjectArray with type OT_OBJECT_ELEMENT, caller owns it
+         */
+        ObjectArray* encodeArray(const std::vector<T>& values) const {
+            std::vector<ObjectElement*> elements;
+            elements.reserve(values.size());
+            for (const T& value : values)
+                elements.push_back(encode(value));
+            auto* array = new ObjectArray(OT_OBJECT_ELEMENT);
+            array->add(elements.data(), elements.size());
+            return array;
+        }
+
+        /**
+         * append values from array of elements, layout is found once and again only if element has other layout
+         * T should be default constructible
+         *
+         * @param array                 ObjectArray with type OT_OBJECT_ELEMENT
+         * @param values                result
+         * @return count of decoded values
+         */
+        size_t decodeArray(const ObjectArray* array, std::vector<T>& values) const {
+            size_t count = 0;
+            values.reserve(values.size() + array->size());
+            Layout layout;
+            for (size_t i = 0; i < array->size(); i++) {
+                const ObjectElement* element = array->tryGetObjectElement((int)i);
+                if (element == nullptr)
+                    continue;
+                if (!matches(layout, element))
+                    layout = getLayout(element);
+                values.emplace_back();
+                decode(element, layout, values.back());
+                count++;
+            }
+            return count;
+        }
+    };
+}
+
+#endif //SMCMODULEDEFINITIONPROVIDER_SMCAPIBINDING_H
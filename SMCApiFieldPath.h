@@ -0,0 +1,95 @@
+/*
+Library (provider c++), is a part of the platform Shelf MK (Shell for modular structures, SMC platform).
+The author and copyright holder of the software package (application) Shelf MK (Shell for modular structures, SMC platform) is Ulyanov Nikolay Vladimirovich (ulianownv@mail.ru).
+The following are prohibited: changing and distributing the program code, selling/reselling it, as well as other actions and rights not expressly permitted.
+*/
+
+#include "SMCApi.h"
+
+#ifndef SMCMODULEDEFINITIONPROVIDER_SMCAPIFIELDPATH_H
+#define SMCMODULEDEFINITIONPROVIDER_SMCAPIFIELDPATH_H
+
+/**
+ * internal helpers of library (query and stream), not part of API
+ */
+namespace SMCApi {
+    namespace internal {
+        /**
+         * names of field path (names separated by '.')
+         */
+        inline std::vector<std::wstring> splitPath(const std::wstring& path) {
+            std::vector<std::wstring> names;
+            size_t begin = 0;
+            while (true) {
+                size_t end = path.find(L'.', begin);
+                names.push_back(path.substr(begin, end == std::wstring::npos ? std::wstring::npos : end - begin));
+                if (end == std::wstring::npos)
+                    break;
+                begin = end + 1;
+            }
+            return names;
+        }
+
+        /**
+         * field found by names of nested fields
+         * names are resolved in SymbolTable once, position of field on each level is remembered and checked first on next element
+         */
+        class FieldPath {
+        private:
+            std::vector<unsigned int> nameIds;
+            std::vector<int> positions;
+            bool valid;
+
+            const ObjectField* findField(const ObjectElement* element, size_t level) {
+                size_t count = element->size();
+                int position = positions[level];
+                if ((size_t)position < count && element->getField(position)->getNameId() == nameIds[level])
+                    return element->getField(position);
+                for (size_t i = 0; i < count; i++) {
+                    const ObjectField* field = element->getField((int)i);
+                    if (field->getNameId() == nameIds[level]) {
+                        positions[level] = (int)i;
+                        return field;
+                    }
+                }
+                return nullptr;
+            }
+
+        public:
+            /**
+             * @param names                 names of fields
+             * @param intern                add names to SymbolTable (for paths used with elements created later)
+             */
+            explicit FieldPath(const std::vector<std::wstring>& names, bool intern = false) : positions(names.size(), 0), valid(!names.empty()) {
+                nameIds.reserve(names.size());
+                for (auto& name : names) {
+                    unsigned int nameId = intern ? SymbolTable::intern(name) : SymbolTable::find(name);
+                    if (nameId == SymbolTable::NOT_FOUND)
+                        valid = false;
+                    nameIds.push_back(nameId);
+                }
+            }
+
+            /**
+             * false if some name was never used, field can not be found
+             */
+            bool isValid() const {
+                return valid;
+            }
+
+            const ObjectField* find(const ObjectElement* element) {
+                if (!valid)
+                    return nullptr;
+                for (size_t level = 0; element != nullptr; level++) {
+                    const ObjectField* field = findField(element, level);
+                    if (field == nullptr || level + 1 == nameIds.size())
+                        return field;
+                    element = field->tryGetValueObjectElement();
+                }
+                return nullptr;
+            }
+        };
+    }
+}
+
+#endif //SMCMODULEDEFINITIONPROVIDER_SMCAPIFIELDPATH_H
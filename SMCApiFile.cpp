@@ -0,0 +1,386 @@
+/*
+Library (provider c++), is a part of the platform Shelf MK (Shell for modular structures, SMC platform).
+The author and copyright holder of the software package (application) Shelf MK (Shell for modular structures, SMC platform) is Ulyanov Nikolay Vladimirovich (ulianownv@mail.ru).
+The following are prohibited: changing and distributing the program code, selling/reselling it, as well as other actions and rights not expressly permitted.
+*/
+
+#include "SMCApiFile.h"
+#include <cstring>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <dlfcn.h>
+#endif
+
+namespace {
+#ifdef _WIN32
+    const wchar_t PATH_SEPARATOR = L'\\';
+
+    typedef HANDLE NativeFile;
+
+    const std::wstring& toNativePath(const std::wstring& path) {
+        return path;
+    }
+
+    NativeFile openFile(const std::wstring& path) {
+        HANDLE handle = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (handle == INVALID_HANDLE_VALUE)
+            throw SMCApi::ModuleException(L"file not found: " + path);
+        return handle;
+    }
+
+    void closeFile(NativeFile file) {
+        CloseHandle(file);
+    }
+
+    size_t readFile(NativeFile file, size_t offset, char* buffer, size_t size) {
+        size_t result = 0;
+        while (result < size) {
+            OVERLAPPED overlapped{};
+            unsigned long long position = offset + result;
+            overlapped.Offset = (DWORD)(position & 0xFFFFFFFF);
+            overlapped.OffsetHigh = (DWORD)(position >> 32);
+            DWORD count = 0;
+            DWORD portion = size - result > 0x40000000 ? 0x40000000 : (DWORD)(size - result);
+            if (!ReadFile(file, buffer + result, portion, &count, &overlapped) || count == 0)
+                break;
+            result += count;
+        }
+        return result;
+    }
+#else
+    const wchar_t PATH_SEPARATOR = L'/';
+
+    typedef int NativeFile;
+
+    std::string toNativePath(const std::wstring& path) {
+        return SMCApi::toUtf8(path);
+    }
+
+    std::wstring fromNativePath(const char* path) {
+        return SMCApi::fromUtf8(path);
+    }
+
+    NativeFile openFile(const std::wstring& path) {
+        int fd = open(toNativePath(path).c_str(), O_RDONLY);
+        if (fd < 0)
+            throw SMCApi::ModuleException(L"file not found: " + path);
+        return fd;
+    }
+
+    void closeFile(NativeFile file) {
+        close(file);
+    }
+
+    size_t readFile(NativeFile file, size_t offset, char* buffer, size_t size) {
+        size_t result = 0;
+        while (result < size) {
+            ssize_t count = pread(file, buffer + result, size - result, (off_t)(offset + result));
+            if (count <= 0)
+                break;
+            result += count;
+        }
+        return result;
+    }
+#endif
+
+    class FileReader final : public SMCApi::IFileReader {
+    private:
+        NativeFile file;
+        size_t fileLength;
+        size_t pos;
+
+    public:
+        FileReader(NativeFile file, size_t fileLength) : file(file), fileLength(fileLength), pos(0) {
+        }
+
+        size_t read(char* buffer, size_t size) override {
+            size_t count = readFile(file, pos, buffer, size);
+            pos += count;
+            return count;
+        }
+
+        size_t skip(size_t size) override {
+            size_t count = pos + size > fileLength ? fileLength - pos : size;
+            pos += count;
+            return count;
+        }
+
+        size_t position() override {
+            return pos;
+        }
+
+        void close() override {
+            closeFile(file);
+            delete this;
+        }
+    };
+
+    class FileMapping final : public SMCApi::IFileMapping {
+    private:
+        void* pView;
+        size_t viewLength;
+        size_t delta;
+        size_t viewOffset;
+        size_t size;
+#ifdef _WIN32
+        HANDLE mapping;
+#endif
+
+    public:
+        FileMapping(const std::wstring& path, size_t offset, size_t size) : pView(nullptr), viewLength(0), delta(0), viewOffset(offset), size(size) {
+            if (size == 0)
+                return;
+#ifdef _WIN32
+            SYSTEM_INFO info;
+            GetSystemInfo(&info);
+            delta = offset % info.dwAllocationGranularity;
+            viewLength = size + delta;
+            HANDLE file = openFile(path);
+            mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+            CloseHandle(file);
+            if (mapping == nullptr)
+                throw SMCApi::ModuleException(L"map file error: " + path);
+            unsigned long long start = offset - delta;
+            pView = MapViewOfFile(mapping, FILE_MAP_READ, (DWORD)(start >> 32), (DWORD)(start & 0xFFFFFFFF), viewLength);
+            if (pView == nullptr) {
+                CloseHandle(mapping);
+                throw SMCApi::ModuleException(L"map file error: " + path);
+            }
+#else
+            delta = offset % (size_t)sysconf(_SC_PAGESIZE);
+            viewLength = size + delta;
+            int fd = openFile(path);
+            pView = mmap(nullptr, viewLength, PROT_READ, MAP_PRIVATE, fd, (off_t)(offset - delta));
+            closeFile(fd);
+            if (pView == MAP_FAILED)
+                throw SMCApi::ModuleException(L"map file error: " + path);
+#endif
+        }
+
+        const char* getData() override {
+            return pView ? (const char*)pView + delta : nullptr;
+        }
+
+        size_t length() override {
+            return size;
+        }
+
+        size_t offset() override {
+            return viewOffset;
+        }
+
+        void close() override {
+            if (pView) {
+#ifdef _WIN32
+                UnmapViewOfFile(pView);
+                CloseHandle(mapping);
+#else
+                munmap(pView, viewLength);
+#endif
+            }
+            delete this;
+        }
+    };
+
+    class FileIterator final : public SMCApi::IFileIterator {
+    private:
+        std::wstring path;
+        SMCApi::FileTool* current;
+        std::wstring nextName;
+#ifdef _WIN32
+        HANDLE find;
+        WIN32_FIND_DATAW findData;
+#else
+        DIR* dir;
+#endif
+
+        void fetch() {
+            nextName.clear();
+#ifdef _WIN32
+            if (find == INVALID_HANDLE_VALUE)
+                return;
+            do {
+                std::wstring fileName(findData.cFileName);
+                bool found = fileName != L"." && fileName != L"..";
+                if (found)
+                    nextName = fileName;
+                if (!FindNextFileW(find, &findData)) {
+                    FindClose(find);
+                    find = INVALID_HANDLE_VALUE;
+                }
+                if (found)
+                    return;
+            } while (find != INVALID_HANDLE_VALUE);
+#else
+            if (dir == nullptr)
+                return;
+            while (struct dirent* entry = readdir(dir)) {
+                if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0)
+                    continue;
+                nextName = fromNativePath(entry->d_name);
+                return;
+            }
+#endif
+        }
+
+    public:
+        explicit FileIterator(const std::wstring& path) : path(path), current(nullptr) {
+#ifdef _WIN32
+            find = FindFirstFileW((path + L"\\*").c_str(), &findData);
+#else
+            dir = opendir(toNativePath(path).c_str());
+#endif
+            fetch();
+        }
+
+        bool hasNext() override {
+            return !nextName.empty();
+        }
+
+        SMCApi::IFileTool* next() override {
+            delete current;
+            current = nullptr;
+            if (nextName.empty())
+                return nullptr;
+            current = new SMCApi::FileTool(path + PATH_SEPARATOR + nextName);
+            fetch();
+            return current;
+        }
+
+        void close() override {
+            delete current;
+#ifdef _WIN32
+            if (find != INVALID_HANDLE_VALUE)
+                FindClose(find);
+#else
+            if (dir != nullptr)
+                closedir(dir);
+#endif
+            delete this;
+        }
+    };
+}
+
+SMCApi::FileTool::FileTool(const std::wstring& path) : path(path), pData(nullptr), childrens(nullptr) {
+    size_t pos = path.find_last_of(L"/\\");
+    name = pos == std::wstring::npos ? path : path.substr(pos + 1);
+}
+
+const std::wstring& SMCApi::FileTool::getPath() const {
+    return path;
+}
+
+std::wstring SMCApi::FileTool::getName() {
+    return name;
+}
+
+bool SMCApi::FileTool::exists() {
+#ifdef _WIN32
+    return GetFileAttributesW(path.c_str()) != INVALID_FILE_ATTRIBUTES;
+#else
+    struct stat st{};
+    return stat(toNativePath(path).c_str(), &st) == 0;
+#endif
+}
+
+bool SMCApi::FileTool::isDirectory() {
+#ifdef _WIN32
+    DWORD attributes = GetFileAttributesW(path.c_str());
+    return attributes != INVALID_FILE_ATTRIBUTES && (attributes & FILE_ATTRIBUTE_DIRECTORY);
+#else
+    struct stat st{};
+    return stat(toNativePath(path).c_str(), &st) == 0 && S_ISDIR(st.st_mode);
+#endif
+}
+
+std::vector<SMCApi::IFileTool*>* SMCApi::FileTool::getChildrens() {
+    if (childrens)
+        return childrens;
+    childrens = new std::vector<IFileTool*>;
+    if (!isDirectory())
+        return childrens;
+    IFileIterator* iterator = getChildrensIterator();
+    while (iterator->hasNext())
+        childrens->push_back(new FileTool(((FileTool*)iterator->next())->getPath()));
+    iterator->close();
+    return childrens;
+}
+
+char* SMCApi::FileTool::getData() {
+    if (pData)
+        return pData;
+    size_t size = length();
+    pData = new char[size + 1];
+    pData[read(0, pData, size)] = 0;
+    return pData;
+}
+
+size_t SMCApi::FileTool::length() {
+#ifdef _WIN32
+    WIN32_FILE_ATTRIBUTE_DATA data;
+    if (!GetFileAttributesExW(path.c_str(), GetFileExInfoStandard, &data))
+        return 0;
+    return (size_t)(((unsigned long long)data.nFileSizeHigh << 32) | data.nFileSizeLow);
+#else
+    struct stat st{};
+    if (stat(toNativePath(path).c_str(), &st) != 0)
+        return 0;
+    return (size_t)st.st_size;
+#endif
+}
+
+void* SMCApi::FileTool::loadAsLibrary() {
+#ifdef _WIN32
+    return LoadLibraryW(path.c_str());
+#else
+    return dlopen(toNativePath(path).c_str(), RTLD_NOW);
+#endif
+}
+
+size_t SMCApi::FileTool::read(size_t offset, char* buffer, size_t size) {
+    NativeFile file = openFile(path);
+    size_t result = readFile(file, offset, buffer, size);
+    closeFile(file);
+    return result;
+}
+
+SMCApi::IFileReader* SMCApi::FileTool::getReader() {
+    if (isDirectory())
+        throw ModuleException(L"is directory: " + path);
+    size_t size = length();
+    return new FileReader(openFile(path), size);
+}
+
+SMCApi::IFileMapping* SMCApi::FileTool::map(size_t offset, size_t size) {
+    if (isDirectory())
+        throw ModuleException(L"is directory: " + path);
+    size_t fileLength = length();
+    if (offset > fileLength || fileLength - offset < size)
+        throw ModuleException(L"range out of file: " + path);
+    if (size == 0)
+        size = fileLength - offset;
+    return new FileMapping(path, offset, size);
+}
+
+SMCApi::IFileIterator* SMCApi::FileTool::getChildrensIterator() {
+    return new FileIterator(path);
+}
+
+SMCApi::FileTool::~FileTool() {
+    delete[] pData;
+    pData = nullptr;
+    if (childrens) {
+        for (auto children : *childrens)
+            delete (FileTool*)children;
+        delete childrens;
+        childrens = nullptr;
+    }
+}
@@ -0,0 +1,66 @@
+/*
+Library (provider c++), is a part of the platform Shelf MK (Shell for modular structures, SMC platform).
+The author and copyright holder of the software package (application) Shelf MK (Shell for modular structures, SMC platform) is Ulyanov Nikolay Vladimirovich (ulianownv@mail.ru).
+The following are prohibited: changing and distributing the program code, selling/reselling it, as well as other actions and rights not expressly permitted.
+*/
+
+#include "SMCApi.h"
+
+#ifndef SMCMODULEDEFINITIONPROVIDER_SMCAPIFILE_H
+#define SMCMODULEDEFINITIONPROVIDER_SMCAPIFILE_H
+
+namespace SMCApi {
+    /**
+     * IFileTool for local file system
+     * used by host and for run modules without platform
+     * all returned objects (data, childrens) are valid until the tool is deleted
+     *
+     * @version 1.0.0
+     */
+    class CLASS_DECLSPEC FileTool : public IFileTool {
+    private:
+        std::wstring path;
+        std::wstring name;
+        char* pData;
+        std::vector<IFileTool*>* childrens;
+
+    public:
+        /**
+         * @param path                  full path to file or folder
+         */
+        explicit FileTool(const std::wstring& path);
+
+        /**
+         * full path
+         *
+         * @return string
+         */
+        const std::wstring& getPath() const;
+
+        std::wstring getName() override;
+
+        bool exists() override;
+
+        bool isDirectory() override;
+
+        std::vector<IFileTool*>* getChildrens() override;
+
+        char* getData() override;
+
+        size_t length() override;
+
+        void* loadAsLibrary() override;
+
+        size_t read(size_t offset, char* buffer, size_t size) override;
+
+        IFileReader* getReader() override;
+
+        IFileMapping* map(size_t offset, size_t size) override;
+
+        IFileIterator* getChildrensIterator() override;
+
+        virtual ~FileTool();
+    };
+}
+
+#endif //SMCMODULEDEFINITIONPROVIDER_SMCAPIFILE_H
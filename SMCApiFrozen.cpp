@@ -0,0 +1,649 @@
+/*
+Library (provider c++), is a part of the platform Shelf MK (Shell for modular structures, SMC platform).
+The author and copyright holder of the software package (application) Shelf MK (Shell for modular structures, SMC platform) is Ulyanov Nikolay Vladimirovich (ulianownv@mail.ru).
+The following are prohibited: changing and distributing the program code, selling/reselling it, as well as other actions and rights not expressly permitted.
+*/
+
+#include "SMCApiFrozen.h"
+#include <cstddef>
+#include <cstring>
+#include <unordered_map>
+
+/**
+ * layout of memory block (all offsets are from start of block, all records are aligned to 8 bytes):
+ * array   - FrozenArrayHeader, FrozenSlot[count]
+ * element - FrozenElementHeader, FrozenFieldRecord[count]
+ * string  - UTF-8 char[length + 1], big number - char[length + 1], bytes - signed char[length]
+ * field name is UTF-8 char[length + 1], written once per block and shared by all records with this name
+ * root array is at offset 0
+ */
+struct SMCApi::FrozenSlot {
+    unsigned short type;
+    unsigned short isNull;
+    unsigned int length;
+    union {
+        long long int longValue;
+        double doubleValue;
+        unsigned long long offset;
+    };
+};
+
+namespace {
+    struct FrozenArrayHeader {
+        unsigned int type;
+        unsigned int count;
+    };
+
+    struct FrozenElementHeader {
+        unsigned int count;
+        unsigned int reserved;
+    };
+
+    struct FrozenFieldRecord {
+        unsigned long long nameOffset;
+        unsigned int nameLength;
+        unsigned int reserved;
+        SMCApi::FrozenSlot slot;
+    };
+
+    class FrozenBuilder {
+    private:
+        std::vector<char> buffer;
+        std::unordered_map<unsigned int, std::pair<size_t, size_t>> names;
+
+        size_t allocate(size_t size) {
+            size_t offset = (buffer.size() + 7) & ~(size_t)7;
+            buffer.resize(offset + size);
+            return offset;
+        }
+
+        template<typename T>
+        T* at(size_t offset) {
+            return (T*)(buffer.data() + offset);
+        }
+
+        size_t writeData(const void* data, size_t size) {
+            size_t offset = allocate(size);
+            if (size > 0)
+                memcpy(buffer.data() + offset, data, size);
+            return offset;
+        }
+
+        /**
+         * fill slot, slot is given by offset because buffer may be moved by nested writes
+         */
+        void writeValue(size_t slotOffset, SMCApi::ObjectType type, const void* value) {
+            SMCApi::FrozenSlot slot = {};
+            slot.type = (unsigned short)type;
+            slot.isNull = value == nullptr ? 1 : 0;
+            if (value != nullptr) {
+                switch (type) {
+                case SMCApi::OT_OBJECT_ARRAY:
+                    slot.offset = writeArray((const SMCApi::ObjectArray*)value);
+                    break;
+                case SMCApi::OT_OBJECT_ELEMENT:
+                    slot.offset = writeElement((const SMCApi::ObjectElement*)value);
+                    break;
+                case SMCApi::OT_STRING: {
+                    auto* str = (const SMCApi::Utf8String*)value;
+                    slot.length = (unsigned int)str->getSize();
+                    slot.offset = writeData(str->getData(), str->getSize() + 1);
+                    break;
+                }
+                case SMCApi::OT_BYTE:
+                case SMCApi::OT_SHORT:
+                case SMCApi::OT_INTEGER:
+                case SMCApi::OT_LONG:
+                    slot.longValue = ((SMCApi::Number*)value)->longValue();
+                    break;
+                case SMCApi::OT_FLOAT:
+                case SMCApi::OT_DOUBLE:
+                    slot.doubleValue = ((SMCApi::Number*)value)->doubleValue();
+                    break;
+                case SMCApi::OT_BIG_INTEGER:
+                case SMCApi::OT_BIG_DECIMAL: {
+                    std::string str = ((SMCApi::Number*)value)->toString();
+                    slot.length = (unsigned int)str.size();
+                    slot.offset = writeData(str.c_str(), str.size() + 1);
+                    break;
+                }
+                case SMCApi::OT_BYTES: {
+                    auto* bytes = (const SMCApi::ByteBuffer*)value;
+                    slot.length = (unsigned int)bytes->getSize();
+                    slot.offset = writeData(bytes->getData(), bytes->getSize());
+                    break;
+                }
+                case SMCApi::OT_BOOLEAN:
+                    slot.longValue = *(const bool*)value ? 1 : 0;
+                    break;
+                case SMCApi::OT_VALUE_ANY:
+                    slot.isNull = 1;
+                    break;
+                }
+            }
+            *at<SMCApi::FrozenSlot>(slotOffset) = slot;
+        }
+
+    public:
+        size_t writeArray(const SMCApi::ObjectArray* array) {
+            auto* objectArray = const_cast<SMCApi::ObjectArray*>(array);
+            size_t count = array->size();
+            size_t offset = allocate(sizeof(FrozenArrayHeader) + count * sizeof(SMCApi::FrozenSlot));
+            *at<FrozenArrayHeader>(offset) = {(unsigned int)objectArray->getType(), (unsigned int)count};
+            for (size_t i = 0; i < count; i++) {
+                SMCApi::ObjectType type = objectArray->getType((int)i);
+                writeValue(offset + sizeof(FrozenArrayHeader) + i * sizeof(SMCApi::FrozenSlot), type, array->getStored((int)i));
+            }
+            return offset;
+        }
+
+        size_t writeElement(const SMCApi::ObjectElement* element) {
+            size_t count = element->size();
+            size_t offset = allocate(sizeof(FrozenElementHeader) + count * sizeof(FrozenFieldRecord));
+            *at<FrozenElementHeader>(offset) = {(unsigned int)count, 0};
+            for (size_t i = 0; i < count; i++) {
+                const SMCApi::ObjectField* field = element->getField((int)i);
+                auto name = names.find(field->getNameId());
+                if (name == names.end()) {
+                    std::string utf8 = SMCApi::toUtf8(field->getName());
+                    size_t nameOffset = writeData(utf8.c_str(), utf8.size() + 1);
+                    name = names.emplace(field->getNameId(), std::make_pair(nameOffset, utf8.size())).first;
+                }
+                size_t recordOffset = offset + sizeof(FrozenElementHeader) + i * sizeof(FrozenFieldRecord);
+                at<FrozenFieldRecord>(recordOffset)->nameOffset = name->second.first;
+                at<FrozenFieldRecord>(recordOffset)->nameLength = (unsigned int)name->second.second;
+                writeValue(recordOffset + offsetof(FrozenFieldRecord, slot), field->getType(), field->getStoredValue());
+            }
+            return offset;
+        }
+
+        size_t size() const {
+            return buffer.size();
+        }
+
+        char* release() {
+            char* data = new char[buffer.size()];
+            memcpy(data, buffer.data(), buffer.size());
+            std::vector<char>().swap(buffer);
+            return data;
+        }
+    };
+
+    /**
+     * name id by name data in block, names are shared in block, so each name is converted and interned once
+     */
+    typedef std::unordered_map<const char*, unsigned int> FrozenNameIds;
+
+    SMCApi::ObjectArray* thawArray(const SMCApi::FrozenArray& array, FrozenNameIds& nameIds);
+
+    SMCApi::ObjectElement* thawElement(const SMCApi::FrozenElement& element, FrozenNameIds& nameIds);
+
+    /**
+     * new value in format of ObjectArray and ObjectField (pointer, owned by receiver)
+     */
+    void* thawValue(const SMCApi::FrozenValue& value, size_t& size, FrozenNameIds& nameIds) {
+        size = 0;
+        if (value.isNull())
+            return nullptr;
+        switch (value.getType()) {
+        case SMCApi::OT_OBJECT_ARRAY:
+            return thawArray(value.getObjectArray(), nameIds);
+        case SMCApi::OT_OBJECT_ELEMENT:
+            return thawElement(value.getObjectElement(), nameIds);
+        case SMCApi::OT_STRING: {
+            SMCApi::FrozenString str = value.getString();
+            return new SMCApi::Utf8String(str.data, str.length);
+        }
+        case SMCApi::OT_BYTES: {
+            size = value.getBytesCount();
+            auto* bytes = new signed char[size];
+            if (size > 0)
+                memcpy(bytes, value.getBytes(), size);
+            return bytes;
+        }
+        case SMCApi::OT_BOOLEAN:
+            return new bool(value.getBoolean());
+        default:
+            return value.getNumber();
+        }
+    }
+
+    SMCApi::ObjectArray* thawArray(const SMCApi::FrozenArray& array, FrozenNameIds& nameIds) {
+        auto* result = new SMCApi::ObjectArray(array.getType());
+        for (size_t i = 0; i < array.size(); i++) {
+            SMCApi::FrozenValue value = array.get((int)i);
+            size_t size;
+            void* pValue = thawValue(value, size, nameIds);
+            switch (value.getType()) {
+            case SMCApi::OT_OBJECT_ARRAY:
+                result->add((SMCApi::ObjectArray*)pValue);
+                break;
+            case SMCApi::OT_OBJECT_ELEMENT:
+                result->add((SMCApi::ObjectElement*)pValue);
+                break;
+            case SMCApi::OT_STRING:
+                if (pValue) {
+                    result->add(std::move(*(SMCApi::Utf8String*)pValue));
+                    delete (SMCApi::Utf8String*)pValue;
+                } else {
+                    result->add((const std::wstring*)nullptr);
+                }
+                break;
+            case SMCApi::OT_BYTES:
+                result->add((signed char*)pValue, size);
+                break;
+            case SMCApi::OT_BOOLEAN:
+                result->add(pValue != nullptr && *(bool*)pValue);
+                delete (bool*)pValue;
+                break;
+            case SMCApi::OT_VALUE_ANY:
+                break;
+            default:
+                result->add((SMCApi::Number*)pValue);
+                break;
+            }
+        }
+        return result;
+    }
+
+    SMCApi::ObjectElement* thawElement(const SMCApi::FrozenElement& element, FrozenNameIds& nameIds) {
+        auto* result = new SMCApi::ObjectElement();
+        result->reserve(element.size());
+        for (size_t i = 0; i < element.size(); i++) {
+            SMCApi::FrozenValue value = element.getField((int)i);
+            SMCApi::FrozenString name = element.getName((int)i);
+            auto nameId = nameIds.find(name.data);
+            if (nameId == nameIds.end())
+                nameId = nameIds.emplace(name.data, SMCApi::SymbolTable::intern(name.toString())).first;
+            SMCApi::ObjectField* field = result->add(SMCApi::ObjectField(nameId->second, value.getType()));
+            size_t size;
+            void* pValue = thawValue(value, size, nameIds);
+            if (pValue != nullptr) {
+                switch (value.getType()) {
+                case SMCApi::OT_OBJECT_ARRAY:
+                    field->setValue((SMCApi::ObjectArray*)pValue);
+                    break;
+                case SMCApi::OT_OBJECT_ELEMENT:
+                    field->setValue((SMCApi::ObjectElement*)pValue);
+                    break;
+                case SMCApi::OT_STRING:
+                    field->setValue(std::move(*(SMCApi::Utf8String*)pValue));
+                    delete (SMCApi::Utf8String*)pValue;
+                    break;
+                case SMCApi::OT_BYTES:
+                    field->setValue((signed char*)pValue, size);
+                    break;
+                case SMCApi::OT_BOOLEAN:
+                    field->setValue(*(bool*)pValue);
+                    delete (bool*)pValue;
+                    break;
+                case SMCApi::OT_BIG_INTEGER:
+                case SMCApi::OT_BIG_DECIMAL:
+                    field->setValue((SMCApi::Number*)pValue);
+                    break;
+                default:
+                    field->setValue(*(SMCApi::Number*)pValue);
+                    delete (SMCApi::Number*)pValue;
+                    break;
+                }
+            }
+        }
+        return result;
+    }
+
+    /**
+     * check of block from outside (copy): counts, offsets and lengths are in block, type tags are known, strings are null terminated
+     * arrays and elements are written in order of walk (each one after records of previous), so each record is checked once
+     */
+    class FrozenValidator {
+    private:
+        const char* data;
+        size_t size;
+        size_t next;
+
+        static void fail() {
+            throw SMCApi::ModuleException(L"wrong data");
+        }
+
+        static bool isType(unsigned int type) {
+            return type <= SMCApi::OT_BOOLEAN;
+        }
+
+        /**
+         * read header of array or element and check that its items are in block
+         *
+         * @return offset of first item
+         */
+        template<typename Header, typename Item>
+        size_t record(unsigned long long offset, Header& header) {
+            if (offset < next || (offset & 7) != 0 || offset > size || size - offset < sizeof(Header))
+                fail();
+            memcpy(&header, data + offset, sizeof(Header));
+            if ((size - offset - sizeof(Header)) / sizeof(Item) < header.count)
+                fail();
+            next = offset + sizeof(Header) + header.count * sizeof(Item);
+            return offset + sizeof(Header);
+        }
+
+        void checkText(unsigned long long offset, size_t length) {
+            if (offset > size || size - offset <= length || data[offset + length] != 0)
+                fail();
+        }
+
+        void checkSlot(const SMCApi::FrozenSlot& slot) {
+            if (!isType(slot.type) || (slot.type == SMCApi::OT_VALUE_ANY && !slot.isNull))
+                fail();
+            if (slot.isNull)
+                return;
+            switch (slot.type) {
+            case SMCApi::OT_OBJECT_ARRAY:
+                checkArray(slot.offset);
+                break;
+            case SMCApi::OT_OBJECT_ELEMENT:
+                checkElement(slot.offset);
+                break;
+            case SMCApi::OT_STRING:
+            case SMCApi::OT_BIG_INTEGER:
+            case SMCApi::OT_BIG_DECIMAL:
+                checkText(slot.offset, slot.length);
+                break;
+            case SMCApi::OT_BYTES:
+                if (slot.offset > size || size - slot.offset < slot.length)
+                    fail();
+                break;
+            default:
+                break;
+            }
+        }
+
+    public:
+        FrozenValidator(const char* data, size_t size) : data(data), size(size), next(0) {
+        }
+
+        void checkArray(unsigned long long offset) {
+            FrozenArrayHeader header;
+            size_t slots = record<FrozenArrayHeader, SMCApi::FrozenSlot>(offset, header);
+            if (!isType(header.type))
+                fail();
+            for (size_t i = 0; i < header.count; i++) {
+                SMCApi::FrozenSlot slot;
+                memcpy(&slot, data + slots + i * sizeof(SMCApi::FrozenSlot), sizeof(slot));
+                if (header.type != SMCApi::OT_VALUE_ANY && slot.type != header.type)
+                    fail();
+                checkSlot(slot);
+            }
+        }
+
+        void checkElement(unsigned long long offset) {
+            FrozenElementHeader header;
+            size_t records = record<FrozenElementHeader, FrozenFieldRecord>(offset, header);
+            for (size_t i = 0; i < header.count; i++) {
+                FrozenFieldRecord field;
+                memcpy(&field, data + records + i * sizeof(FrozenFieldRecord), sizeof(field));
+                checkText(field.nameOffset, field.nameLength);
+                checkSlot(field.slot);
+            }
+        }
+    };
+
+    void throwWrongType() {
+        throw SMCApi::ModuleException(L"wrong type");
+    }
+}
+
+std::wstring SMCApi::FrozenString::toString() const {
+    std::wstring result;
+    if (data)
+        fromUtf8(data, length, result);
+    return result;
+}
+
+std::string SMCApi::FrozenString::getUtf8() const {
+    return data ? std::string(data, length) : std::string();
+}
+
+bool SMCApi::FrozenString::equals(const std::wstring& value) const {
+    return equals(toUtf8(value));
+}
+
+bool SMCApi::FrozenString::equals(const std::string& value) const {
+    return value.size() == length && (length == 0 || memcmp(data, value.data(), length) == 0);
+}
+
+SMCApi::FrozenValue::FrozenValue(const char* base, const SMCApi::FrozenSlot* slot) : base(base), slot(slot) {
+}
+
+bool SMCApi::FrozenValue::isValid() const {
+    return slot != nullptr;
+}
+
+SMCApi::ObjectType SMCApi::FrozenValue::getType() const {
+    if (slot == nullptr)
+        throwWrongType();
+    return (ObjectType)slot->type;
+}
+
+bool SMCApi::FrozenValue::isNull() const {
+    return slot == nullptr || slot->isNull != 0;
+}
+
+SMCApi::FrozenString SMCApi::FrozenValue::getString() const {
+    if (getType() != ObjectType::OT_STRING)
+        throwWrongType();
+    if (slot->isNull)
+        return {nullptr, 0};
+    return {base + slot->offset, slot->length};
+}
+
+long long int SMCApi::FrozenValue::getLong() const {
+    switch (getType()) {
+    case ObjectType::OT_BYTE:
+    case ObjectType::OT_SHORT:
+    case ObjectType::OT_INTEGER:
+    case ObjectType::OT_LONG:
+        return slot->longValue;
+    case ObjectType::OT_FLOAT:
+    case ObjectType::OT_DOUBLE:
+        return (long long int)slot->doubleValue;
+    case ObjectType::OT_BIG_INTEGER:
+        return slot->isNull ? 0 : std::stoll(std::string(base + slot->offset, slot->length));
+    case ObjectType::OT_BIG_DECIMAL:
+        return slot->isNull ? 0 : (long long int)std::stod(std::string(base + slot->offset, slot->length));
+    default:
+        throwWrongType();
+    }
+    return 0;
+}
+
+double SMCApi::FrozenValue::getDouble() const {
+    switch (getType()) {
+    case ObjectType::OT_BYTE:
+    case ObjectType::OT_SHORT:
+    case ObjectType::OT_INTEGER:
+    case ObjectType::OT_LONG:
+        return (double)slot->longValue;
+    case ObjectType::OT_FLOAT:
+    case ObjectType::OT_DOUBLE:
+        return slot->doubleValue;
+    case ObjectType::OT_BIG_INTEGER:
+    case ObjectType::OT_BIG_DECIMAL:
+        return slot->isNull ? 0 : std::stod(std::string(base + slot->offset, slot->length));
+    default:
+        throwWrongType();
+    }
+    return 0;
+}
+
+SMCApi::Number* SMCApi::FrozenValue::getNumber() const {
+    ObjectType type = getType();
+    if (type < ObjectType::OT_BYTE || type > ObjectType::OT_BIG_DECIMAL)
+        throwWrongType();
+    if (slot->isNull)
+        return nullptr;
+    switch (type) {
+    case ObjectType::OT_BYTE:
+        return new Number((signed char)slot->longValue);
+    case ObjectType::OT_SHORT:
+        return new Number((short)slot->longValue);
+    case ObjectType::OT_INTEGER:
+        return new Number((long)slot->longValue);
+    case ObjectType::OT_LONG:
+        return new Number(slot->longValue);
+    case ObjectType::OT_FLOAT:
+        return new Number((float)slot->doubleValue);
+    case ObjectType::OT_DOUBLE:
+        return new Number(slot->doubleValue);
+    case ObjectType::OT_BIG_INTEGER:
+    case ObjectType::OT_BIG_DECIMAL: {
+        auto* valueString = new char[slot->length + 1];
+        memcpy(valueString, base + slot->offset, slot->length + 1);
+        return new Number(type == ObjectType::OT_BIG_INTEGER ? NumberType::NT_BIG_INTEGER : NumberType::NT_BIG_DECIMAL, valueString);
+    }
+    default:
+        throwWrongType();
+    }
+    return nullptr;
+}
+
+const signed char* SMCApi::FrozenValue::getBytes() const {
+    if (getType() != ObjectType::OT_BYTES)
+        throwWrongType();
+    return slot->isNull ? nullptr : (const signed char*)(base + slot->offset);
+}
+
+size_t SMCApi::FrozenValue::getBytesCount() const {
+    if (getType() != ObjectType::OT_BYTES)
+        throwWrongType();
+    return slot->length;
+}
+
+bool SMCApi::FrozenValue::getBoolean() const {
+    if (getType() != ObjectType::OT_BOOLEAN)
+        throwWrongType();
+    return slot->longValue != 0;
+}
+
+SMCApi::FrozenArray SMCApi::FrozenValue::getObjectArray() const {
+    if (getType() != ObjectType::OT_OBJECT_ARRAY)
+        throwWrongType();
+    return FrozenArray(slot->isNull ? nullptr : base, slot->offset);
+}
+
+SMCApi::FrozenElement SMCApi::FrozenValue::getObjectElement() const {
+    if (getType() != ObjectType::OT_OBJECT_ELEMENT)
+        throwWrongType();
+    return FrozenElement(slot->isNull ? nullptr : base, slot->offset);
+}
+
+SMCApi::FrozenArray::FrozenArray(const char* base, unsigned long long offset) : base(base), offset(offset) {
+}
+
+size_t SMCApi::FrozenArray::size() const {
+    return base ? ((const FrozenArrayHeader*)(base + offset))->count : 0;
+}
+
+SMCApi::ObjectType SMCApi::FrozenArray::getType(int id) const {
+    if (base == nullptr)
+        return ObjectType::OT_VALUE_ANY;
+    if (id >= 0 && (size_t)id < size())
+        return get(id).getType();
+    return (ObjectType)((const FrozenArrayHeader*)(base + offset))->type;
+}
+
+SMCApi::FrozenValue SMCApi::FrozenArray::get(int id) const {
+    if (id < 0 || (size_t)id >= size()) {
+        throw ModuleException(L"wrong id");
+    }
+    return FrozenValue(base, (const FrozenSlot*)(base + offset + sizeof(FrozenArrayHeader)) + id);
+}
+
+SMCApi::FrozenElement::FrozenElement(const char* base, unsigned long long offset) : base(base), offset(offset) {
+}
+
+size_t SMCApi::FrozenElement::size() const {
+    return base ? ((const FrozenElementHeader*)(base + offset))->count : 0;
+}
+
+SMCApi::FrozenString SMCApi::FrozenElement::getName(int id) const {
+    if (id < 0 || (size_t)id >= size()) {
+        throw ModuleException(L"wrong id");
+    }
+    const FrozenFieldRecord* record = (const FrozenFieldRecord*)(base + offset + sizeof(FrozenElementHeader)) + id;
+    return {base + record->nameOffset, record->nameLength};
+}
+
+SMCApi::FrozenValue SMCApi::FrozenElement::getField(int id) const {
+    if (id < 0 || (size_t)id >= size()) {
+        throw ModuleException(L"wrong id");
+    }
+    const FrozenFieldRecord* record = (const FrozenFieldRecord*)(base + offset + sizeof(FrozenElementHeader)) + id;
+    return FrozenValue(base, &record->slot);
+}
+
+SMCApi::FrozenValue SMCApi::FrozenElement::findField(const std::wstring& name) const {
+    size_t count = size();
+    std::string utf8 = count > 0 ? toUtf8(name) : std::string();
+    for (size_t i = 0; i < count; i++) {
+        if (getName((int)i).equals(utf8))
+            return getField((int)i);
+    }
+    return FrozenValue(base, nullptr);
+}
+
+SMCApi::FrozenObjectArray::FrozenObjectArray(char* data, size_t length) : references(1), data(data), length(length) {
+}
+
+SMCApi::FrozenObjectArray* SMCApi::FrozenObjectArray::freeze(const SMCApi::ObjectArray* array) {
+    FrozenBuilder builder;
+    builder.writeArray(array);
+    size_t length = builder.size();
+    return new FrozenObjectArray(builder.release(), length);
+}
+
+SMCApi::FrozenObjectArray* SMCApi::FrozenObjectArray::retain() {
+    references.fetch_add(1, std::memory_order_relaxed);
+    return this;
+}
+
+void SMCApi::FrozenObjectArray::release() {
+    if (references.fetch_sub(1, std::memory_order_acq_rel) == 1)
+        delete this;
+}
+
+long SMCApi::FrozenObjectArray::countReferences() const {
+    return references.load(std::memory_order_relaxed);
+}
+
+SMCApi::FrozenArray SMCApi::FrozenObjectArray::getArray() const {
+    return FrozenArray(data, 0);
+}
+
+size_t SMCApi::FrozenObjectArray::getMemorySize() const {
+    return sizeof(FrozenObjectArray) + length;
+}
+
+const char* SMCApi::FrozenObjectArray::getData() const {
+    return data;
+}
+
+size_t SMCApi::FrozenObjectArray::getDataSize() const {
+    return length;
+}
+
+SMCApi::FrozenObjectArray* SMCApi::FrozenObjectArray::copy(const char* data, size_t size) {
+    if (data == nullptr)
+        throw ModuleException(L"wrong data");
+    FrozenValidator(data, size).checkArray(0);
+    char* block = new char[size];
+    memcpy(block, data, size);
+    return new FrozenObjectArray(block, size);
+}
+
+SMCApi::ObjectArray* SMCApi::FrozenObjectArray::thaw() const {
+    FrozenNameIds nameIds;
+    return thawArray(getArray(), nameIds);
+}
+
+SMCApi::FrozenObjectArray::~FrozenObjectArray() {
+    delete[] data;
+}
@@ -0,0 +1,245 @@
+/*
+Library (provider c++), is a part of the platform Shelf MK (Shell for modular structures, SMC platform).
+The author and copyright holder of the software package (application) Shelf MK (Shell for modular structures, SMC platform) is Ulyanov Nikolay Vladimirovich (ulianownv@mail.ru).
+The following are prohibited: changing and distributing the program code, selling/reselling it, as well as other actions and rights not expressly permitted.
+*/
+
+#include "SMCApi.h"
+#include <atomic>
+
+#ifndef SMCMODULEDEFINITIONPROVIDER_SMCAPIFROZEN_H
+#define SMCMODULEDEFINITIONPROVIDER_SMCAPIFROZEN_H
+
+namespace SMCApi {
+    class CLASS_DECLSPEC FrozenArray;
+
+    class CLASS_DECLSPEC FrozenElement;
+
+    struct FrozenSlot;
+
+    /**
+     * UTF-8 string in frozen data, data is null terminated, length is count of bytes
+     *
+     * @version 1.0.0
+     */
+    struct CLASS_DECLSPEC FrozenString {
+        const char* data;
+        size_t length;
+
+        std::wstring toString() const;
+
+        /**
+         * copy of UTF-8 bytes
+         *
+         * @return std::string
+         */
+        std::string getUtf8() const;
+
+        bool equals(const std::wstring& value) const;
+
+        /**
+         * compare with UTF-8 string without conversion
+         *
+         * @param value                 UTF-8 string
+         * @return bool
+         */
+        bool equals(const std::string& value) const;
+    };
+
+    /**
+     * read only view of one value (item of array or field of element)
+     * valid while FrozenObjectArray exists
+     *
+     * @version 1.0.0
+     */
+    class CLASS_DECLSPEC FrozenValue {
+    private:
+        const char* base;
+        const FrozenSlot* slot;
+
+    public:
+        FrozenValue(const char* base, const FrozenSlot* slot);
+
+        /**
+         * false for not found field
+         *
+         * @return bool
+         */
+        bool isValid() const;
+
+        ObjectType getType() const;
+
+        bool isNull() const;
+
+        FrozenString getString() const;
+
+        /**
+         * number as long, for float types the value is truncated
+         *
+         * @return long long int
+         */
+        long long int getLong() const;
+
+        double getDouble() const;
+
+        /**
+         * number as new Number
+         *
+         * @return Number, caller owns it
+         */
+        Number* getNumber() const;
+
+        const signed char* getBytes() const;
+
+        size_t getBytesCount() const;
+
+        bool getBoolean() const;
+
+        FrozenArray getObjectArray() const;
+
+        FrozenElement getObjectElement() const;
+    };
+
+    /**
+     * read only view of array
+     *
+     * @version 1.0.0
+     */
+    class CLASS_DECLSPEC FrozenArray {
+    private:
+        const char* base;
+        unsigned long long offset;
+
+    public:
+        FrozenArray(const char* base, unsigned long long offset);
+
+        size_t size() const;
+
+        /**
+         * type of array or item
+         *
+         * @param id                    item id or -1 for array type
+         * @return ObjectType
+         */
+        ObjectType getType(int id = -1) const;
+
+        FrozenValue get(int id) const;
+    };
+
+    /**
+     * read only view of element
+     *
+     * @version 1.0.0
+     */
+    class CLASS_DECLSPEC FrozenElement {
+    private:
+        const char* base;
+        unsigned long long offset;
+
+    public:
+        FrozenElement(const char* base, unsigned long long offset);
+
+        size_t size() const;
+
+        FrozenString getName(int id) const;
+
+        FrozenValue getField(int id) const;
+
+        /**
+         * find field by name
+         *
+         * @param name                  field name
+         * @return FrozenValue, not valid if not found
+         */
+        FrozenValue findField(const std::wstring& name) const;
+    };
+
+    /**
+     * immutable copy of ObjectArray in one memory block
+     * reference counted, can be read from any count of threads without locks
+     *
+     * @version 1.0.0
+     */
+    class CLASS_DECLSPEC FrozenObjectArray {
+    private:
+        std::atomic<long> references;
+        char* data;
+        size_t length;
+
+        FrozenObjectArray(char* data, size_t length);
+
+        ~FrozenObjectArray();
+
+    public:
+        FrozenObjectArray(const FrozenObjectArray&) = delete;
+
+        FrozenObjectArray& operator=(const FrozenObjectArray&) = delete;
+
+        /**
+         * create frozen copy
+         *
+         * @param array                 ObjectArray
+         * @return FrozenObjectArray with one reference, release it
+         */
+        static FrozenObjectArray* freeze(const ObjectArray* array);
+
+        /**
+         * add reference
+         *
+         * @return this
+         */
+        FrozenObjectArray* retain();
+
+        /**
+         * remove reference, delete on last
+         */
+        void release();
+
+        long countReferences() const;
+
+        /**
+         * root array
+         *
+         * @return FrozenArray
+         */
+        FrozenArray getArray() const;
+
+        /**
+         * size of memory block
+         *
+         * @return size in bytes
+         */
+        size_t getMemorySize() const;
+
+        /**
+         * memory block, can be saved and restored by copy
+         *
+         * @return data, size is getDataSize
+         */
+        const char* getData() const;
+
+        size_t getDataSize() const;
+
+        /**
+         * create frozen array from copy of memory block of other frozen array (example: read from file)
+         * block should be created by process on platform with the same byte order
+         * block is checked before copy (counts, offsets, lengths, types), so damaged block or block with other byte order is rejected
+         * (except rare case when wrong data looks valid), values of numbers are not checked
+         *
+         * @param data                  data from getData
+         * @param size                  size from getDataSize
+         * @return FrozenObjectArray with one reference, release it
+         * @throws ModuleException if block is not valid
+         */
+        static FrozenObjectArray* copy(const char* data, size_t size);
+
+        /**
+         * mutable copy
+         *
+         * @return ObjectArray, caller owns it
+         */
+        ObjectArray* thaw() const;
+    };
+}
+
+#endif //SMCMODULEDEFINITIONPROVIDER_SMCAPIFROZEN_H
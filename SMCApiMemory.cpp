@@ -0,0 +1,61 @@
+/*
+Library (provider c++), is a part of the platform Shelf MK (Shell for modular structures, SMC platform).
+The author and copyright holder of the software package (application) Shelf MK (Shell for modular structures, SMC platform) is Ulyanov Nikolay Vladimirovich (ulianownv@mail.ru).
+The following are prohibited: changing and distributing the program code, selling/reselling it, as well as other actions and rights not expressly permitted.
+*/
+
+#include "SMCApiMemory.h"
+
+SMCApi::MemoryBudget::MemoryBudget(size_t limit) : used(0), peak(0), limit(limit), policy(MemoryBudgetPolicy::MBP_THROW) {
+}
+
+SMCApi::MemoryBudget::MemoryBudget(size_t limit, const std::function<void(ObjectArray*, size_t)>& spill)
+    : used(0), peak(0), limit(limit), policy(MemoryBudgetPolicy::MBP_SPILL), spill(spill) {
+}
+
+size_t SMCApi::MemoryBudget::getLimit() const {
+    return limit.load(std::memory_order_relaxed);
+}
+
+void SMCApi::MemoryBudget::setLimit(size_t limit) {
+    MemoryBudget::limit.store(limit, std::memory_order_relaxed);
+}
+
+size_t SMCApi::MemoryBudget::getUsed() const {
+    return used.load(std::memory_order_relaxed);
+}
+
+size_t SMCApi::MemoryBudget::getPeak() const {
+    return peak.load(std::memory_order_relaxed);
+}
+
+SMCApi::MemoryBudgetPolicy SMCApi::MemoryBudget::getPolicy() const {
+    return policy;
+}
+
+void SMCApi::MemoryBudget::check(size_t size) const {
+    if (policy != MemoryBudgetPolicy::MBP_THROW)
+        return;
+    if (used.load(std::memory_order_relaxed) + size > limit.load(std::memory_order_relaxed)) {
+        throw ModuleException(L"memory budget exceeded");
+    }
+}
+
+void SMCApi::MemoryBudget::charge(SMCApi::ObjectArray* array, size_t size) {
+    size_t value = used.fetch_add(size, std::memory_order_relaxed) + size;
+    size_t current = peak.load(std::memory_order_relaxed);
+    while (value > current && !peak.compare_exchange_weak(current, value, std::memory_order_relaxed)) {
+    }
+    size_t max = limit.load(std::memory_order_relaxed);
+    if (policy == MemoryBudgetPolicy::MBP_SPILL && value > max && spill)
+        spill(array, value - max);
+}
+
+void SMCApi::MemoryBudget::release(size_t size) {
+    size_t current = used.load(std::memory_order_relaxed);
+    while (!used.compare_exchange_weak(current, current > size ? current - size : 0, std::memory_order_relaxed)) {
+    }
+}
+
+SMCApi::MemoryBudget::~MemoryBudget() {
+}
@@ -0,0 +1,107 @@
+/*
+Library (provider c++), is a part of the platform Shelf MK (Shell for modular structures, SMC platform).
+The author and copyright holder of the software package (application) Shelf MK (Shell for modular structures, SMC platform) is Ulyanov Nikolay Vladimirovich (ulianownv@mail.ru).
+The following are prohibited: changing and distributing the program code, selling/reselling it, as well as other actions and rights not expressly permitted.
+*/
+
+#include "SMCApi.h"
+#include <atomic>
+#include <functional>
+
+#ifndef SMCMODULEDEFINITIONPROVIDER_SMCAPIMEMORY_H
+#define SMCMODULEDEFINITIONPROVIDER_SMCAPIMEMORY_H
+
+namespace SMCApi {
+    /**
+     * what to do when budget is exceeded
+     *
+     * @version 1.0.0
+     */
+    enum MemoryBudgetPolicy {
+        /**
+         * throw ModuleException before value is added, caller keeps ownership of value
+         */
+        MBP_THROW,
+        /**
+         * add value and call spill function, it should free memory (remove items, flush them to disk)
+         */
+        MBP_SPILL
+    };
+
+    /**
+     * memory limit for one or many ObjectArray (see ObjectArray::setMemoryBudget)
+     * limit usually is taken from CFGIConfiguration::getThreadBufferSize
+     * used size is changed by arrays on add and remove, thread safe
+     *
+     * @version 1.0.0
+     */
+    class CLASS_DECLSPEC MemoryBudget {
+    private:
+        std::atomic<size_t> used;
+        std::atomic<size_t> peak;
+        std::atomic<size_t> limit;
+        MemoryBudgetPolicy policy;
+        std::function<void(ObjectArray*, size_t)> spill;
+
+    public:
+        /**
+         * budget with policy MBP_THROW
+         *
+         * @param limit                 max size in bytes
+         */
+        explicit MemoryBudget(size_t limit);
+
+        /**
+         * budget with policy MBP_SPILL
+         *
+         * @param limit                 max size in bytes
+         * @param spill                 called with array which exceeded limit and count of bytes above limit
+         */
+        MemoryBudget(size_t limit, const std::function<void(ObjectArray*, size_t)>& spill);
+
+        MemoryBudget(const MemoryBudget&) = delete;
+
+        MemoryBudget& operator=(const MemoryBudget&) = delete;
+
+        size_t getLimit() const;
+
+        void setLimit(size_t limit);
+
+        size_t getUsed() const;
+
+        /**
+         * max used size for all time
+         *
+         * @return size_t
+         */
+        size_t getPeak() const;
+
+        MemoryBudgetPolicy getPolicy() const;
+
+        /**
+         * check before add, throw ModuleException if policy is MBP_THROW and size does not fit
+         *
+         * @param size                  size of new value
+         */
+        void check(size_t size) const;
+
+        /**
+         * add size to used, call spill if policy is MBP_SPILL and limit is exceeded
+         *
+         * @param array                 changed array
+         * @param size                  size
+         */
+        void charge(ObjectArray* array, size_t size);
+
+        /**
+         * remove size from used
+         *
+         * @param size                  size
+         */
+        void release(size_t size);
+
+        virtual ~MemoryBudget();
+    };
+}
+
+#endif //SMCMODULEDEFINITIONPROVIDER_SMCAPIMEMORY_H
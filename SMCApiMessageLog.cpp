@@ -0,0 +1,768 @@
+/*
+Library (provider c++), is a part of the platform Shelf MK (Shell for modular structures, SMC platform).
+The author and copyright holder of the software package (application) Shelf MK (Shell for modular structures, SMC platform) is Ulyanov Nikolay Vladimirovich (ulianownv@mail.ru).
+The following are prohibited: changing and distributing the program code, selling/reselling it, as well as other actions and rights not expressly permitted.
+*/
+
+#include "SMCApiMessageLog.h"
+#include "SMCApiFile.h"
+#include "SMCApiFrozen.h"
+#include "SMCApiValue.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+/**
+ * layout of segment file:
+ * all numbers of fixed size are little endian, file does not depend on platform except memory block of FrozenObjectArray (native byte order)
+ * header - char[6] "SMCLOG", version, reserved (0), first sequence (8 bytes)
+ * record - payload size (4 bytes), checksum of payload (4 bytes), payload
+ * payload - message type (1 byte), value type (1 byte), flags (1 byte, 1 - null value), date (8 bytes), value (empty for null)
+ * value - VT_BYTE - VT_LONG: zigzag variable length number, VT_FLOAT / VT_DOUBLE: 4 / 8 bytes, VT_BIG_INTEGER / VT_BIG_DECIMAL: text,
+ * VT_STRING: UTF-8, VT_BYTES: bytes, VT_BOOLEAN: 1 byte, VT_OBJECT_ARRAY: memory block of FrozenObjectArray
+ * (checked by FrozenObjectArray::copy before use)
+ */
+namespace {
+#ifdef _WIN32
+    const wchar_t PATH_SEPARATOR = L'\\';
+
+    typedef HANDLE NativeFile;
+
+    NativeFile openWrite(const std::wstring& path) {
+        HANDLE handle = CreateFileW(path.c_str(), GENERIC_WRITE, FILE_SHARE_READ, nullptr, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (handle == INVALID_HANDLE_VALUE)
+            throw SMCApi::ModuleException(L"open file error: " + path);
+        return handle;
+    }
+
+    void closeFile(NativeFile file) {
+        CloseHandle(file);
+    }
+
+    void truncateFile(NativeFile file, size_t size) {
+        LARGE_INTEGER position;
+        position.QuadPart = (LONGLONG)size;
+        if (!SetFilePointerEx(file, position, nullptr, FILE_BEGIN) || !SetEndOfFile(file))
+            throw SMCApi::ModuleException(L"truncate file error");
+    }
+
+    void writeFile(NativeFile file, const char* data, size_t size) {
+        while (size > 0) {
+            DWORD count = 0;
+            DWORD portion = size > 0x40000000 ? 0x40000000 : (DWORD)size;
+            if (!WriteFile(file, data, portion, &count, nullptr) || count == 0)
+                throw SMCApi::ModuleException(L"write file error");
+            data += count;
+            size -= count;
+        }
+    }
+
+    void syncFile(NativeFile file) {
+        if (!FlushFileBuffers(file))
+            throw SMCApi::ModuleException(L"sync file error");
+    }
+
+    void makeDirectory(const std::wstring& path) {
+        CreateDirectoryW(path.c_str(), nullptr);
+    }
+
+    void removeFile(const std::wstring& path) {
+        DeleteFileW(path.c_str());
+    }
+
+    void removeDirectory(const std::wstring& path) {
+        RemoveDirectoryW(path.c_str());
+    }
+#else
+    const wchar_t PATH_SEPARATOR = L'/';
+
+    typedef int NativeFile;
+
+    NativeFile openWrite(const std::wstring& path) {
+        int fd = open(SMCApi::toUtf8(path).c_str(), O_WRONLY | O_CREAT, 0644);
+        if (fd < 0)
+            throw SMCApi::ModuleException(L"open file error: " + path);
+        return fd;
+    }
+
+    void closeFile(NativeFile file) {
+        close(file);
+    }
+
+    void truncateFile(NativeFile file, size_t size) {
+        if (ftruncate(file, (off_t)size) != 0 || lseek(file, (off_t)size, SEEK_SET) < 0)
+            throw SMCApi::ModuleException(L"truncate file error");
+    }
+
+    void writeFile(NativeFile file, const char* data, size_t size) {
+        while (size > 0) {
+            ssize_t count = write(file, data, size);
+            if (count <= 0)
+                throw SMCApi::ModuleException(L"write file error");
+            data += count;
+            size -= count;
+        }
+    }
+
+    void syncFile(NativeFile file) {
+#ifdef __linux__
+        int result = fdatasync(file);
+#else
+        int result = fsync(file);
+#endif
+        if (result != 0)
+            throw SMCApi::ModuleException(L"sync file error");
+    }
+
+    void makeDirectory(const std::wstring& path) {
+        mkdir(SMCApi::toUtf8(path).c_str(), 0755);
+    }
+
+    void removeFile(const std::wstring& path) {
+        unlink(SMCApi::toUtf8(path).c_str());
+    }
+
+    void removeDirectory(const std::wstring& path) {
+        rmdir(SMCApi::toUtf8(path).c_str());
+    }
+#endif
+
+    const char SEGMENT_MAGIC[6] = {'S', 'M', 'C', 'L', 'O', 'G'};
+    const char SEGMENT_VERSION = 3;
+    const size_t SEGMENT_HEADER_SIZE = 16;
+    const size_t RECORD_HEADER_SIZE = 8;
+    const size_t PAYLOAD_HEADER_SIZE = 11;
+    const char PAYLOAD_NULL = 1;
+    const wchar_t SEGMENT_EXTENSION[] = L".smclog";
+
+    struct Segment {
+        unsigned long long first;
+        std::wstring path;
+    };
+
+    std::wstring segmentPath(const std::wstring& directory, unsigned long long first) {
+        std::wstring name = std::to_wstring(first);
+        return directory + PATH_SEPARATOR + std::wstring(20 - std::min<size_t>(20, name.size()), L'0') + name + SEGMENT_EXTENSION;
+    }
+
+    /**
+     * segments of log in order of first sequence
+     */
+    std::vector<Segment> listSegments(const std::wstring& directory) {
+        std::vector<Segment> segments;
+        SMCApi::FileTool folder(directory);
+        if (!folder.isDirectory())
+            return segments;
+        size_t extensionLength = wcslen(SEGMENT_EXTENSION);
+        SMCApi::IFileIterator* iterator = folder.getChildrensIterator();
+        while (iterator->hasNext()) {
+            std::wstring name = iterator->next()->getName();
+            if (name.size() <= extensionLength || name.compare(name.size() - extensionLength, extensionLength, SEGMENT_EXTENSION) != 0)
+                continue;
+            std::wstring number = name.substr(0, name.size() - extensionLength);
+            if (number.find_first_not_of(L"0123456789") != std::wstring::npos)
+                continue;
+            segments.push_back({std::stoull(number), directory + PATH_SEPARATOR + name});
+        }
+        iterator->close();
+        std::sort(segments.begin(), segments.end(), [](const Segment& a, const Segment& b) {
+            return a.first < b.first;
+        });
+        return segments;
+    }
+
+    /**
+     * little endian number of size bytes
+     */
+    unsigned long long readFixed(const char* data, size_t size) {
+        unsigned long long value = 0;
+        for (size_t i = 0; i < size; i++)
+            value |= (unsigned long long)(unsigned char)data[i] << (i * 8);
+        return value;
+    }
+
+    void appendFixed(std::vector<char>& out, unsigned long long value, size_t size) {
+        for (size_t i = 0; i < size; i++)
+            out.push_back((char)(value >> (i * 8)));
+    }
+
+    unsigned int checksum(const char* data, size_t size) {
+        unsigned long long hash = 0x9E3779B97F4A7C15ULL ^ size;
+        size_t i = 0;
+        for (; i + 8 <= size; i += 8) {
+            unsigned long long word = readFixed(data + i, 8);
+            hash = (hash ^ word) * 0xFF51AFD7ED558CCDULL;
+            hash ^= hash >> 32;
+        }
+        unsigned long long word = readFixed(data + i, size - i);
+        hash = (hash ^ word) * 0xC4CEB9FE1A85EC53ULL;
+        return (unsigned int)(hash ^ (hash >> 32));
+    }
+
+    /**
+     * check header of segment
+     *
+     * @return first sequence
+     */
+    unsigned long long readSegmentHeader(const char* data, size_t length, const std::wstring& path) {
+        if (length < SEGMENT_HEADER_SIZE || memcmp(data, SEGMENT_MAGIC, sizeof(SEGMENT_MAGIC)) != 0 || data[6] != SEGMENT_VERSION)
+            throw SMCApi::ModuleException(L"wrong log segment: " + path);
+        return readFixed(data + 8, 8);
+    }
+
+    /**
+     * end of record
+     *
+     * @return end or 0 if record is not complete or checksum is wrong
+     */
+    size_t recordEnd(const char* data, size_t length, size_t position) {
+        if (length - position < RECORD_HEADER_SIZE)
+            return 0;
+        auto size = (unsigned int)readFixed(data + position, 4);
+        auto sum = (unsigned int)readFixed(data + position + 4, 4);
+        if (size < PAYLOAD_HEADER_SIZE || size > length - position - RECORD_HEADER_SIZE)
+            return 0;
+        if (checksum(data + position + RECORD_HEADER_SIZE, size) != sum)
+            return 0;
+        return position + RECORD_HEADER_SIZE + size;
+    }
+
+    void appendVarint(std::vector<char>& out, unsigned long long value) {
+        while (value >= 0x80) {
+            out.push_back((char)(value | 0x80));
+            value >>= 7;
+        }
+        out.push_back((char)value);
+    }
+
+    void appendBytes(std::vector<char>& out, const void* data, size_t size) {
+        out.insert(out.end(), (const char*)data, (const char*)data + size);
+    }
+
+    unsigned long long readVarint(const char*& data, const char* end) {
+        unsigned long long value = 0;
+        for (int shift = 0; data < end && shift < 64; shift += 7) {
+            auto byte = (unsigned char)*data++;
+            value |= (unsigned long long)(byte & 0x7F) << shift;
+            if ((byte & 0x80) == 0)
+                return value;
+        }
+        throw SMCApi::ModuleException(L"wrong record");
+    }
+
+    bool isInteger(SMCApi::ValueType type) {
+        return type >= SMCApi::VT_BYTE && type <= SMCApi::VT_LONG;
+    }
+
+    /**
+     * message of MessageLogReader
+     */
+    class LogMessage final : public SMCApi::IMessage {
+    public:
+        SMCApi::Value value;
+        long long int date;
+        SMCApi::MessageType messageType;
+        SMCApi::ValueType valueType;
+        /**
+         * null value, getters return null (false for boolean)
+         */
+        bool null;
+
+        LogMessage() : date(0), messageType(SMCApi::MESSAGE_PROCESS_STATE_CHANGE), valueType(SMCApi::VT_STRING), null(false) {
+        }
+
+        SMCApi::ValueType getType() override {
+            return valueType;
+        }
+
+        std::wstring* getValueString() override {
+            return null ? nullptr : value.getValueString();
+        }
+
+        SMCApi::Number* getValueNumber() override {
+            return null ? nullptr : value.getValueNumber();
+        }
+
+        signed char* getValueBytes() override {
+            return null ? nullptr : value.getValueBytes();
+        }
+
+        size_t getBytesCount() override {
+            return null ? 0 : value.getBytesCount();
+        }
+
+        bool getValueBoolean() override {
+            return null ? false : value.getValueBoolean();
+        }
+
+        SMCApi::ObjectArray* getValueObjectArray() override {
+            return null ? nullptr : value.getValueObjectArray();
+        }
+
+        long long int getDate() override {
+            return date;
+        }
+
+        SMCApi::MessageType getMessageType() override {
+            return messageType;
+        }
+    };
+
+    void decodeValue(SMCApi::ValueType type, const char* data, const char* end, SMCApi::Value& value, std::string& text) {
+        switch (type) {
+        case SMCApi::VT_STRING:
+            text.assign(data, end);
+            value.setValueUtf8(text);
+            break;
+        case SMCApi::VT_BYTE:
+        case SMCApi::VT_SHORT:
+        case SMCApi::VT_INTEGER:
+        case SMCApi::VT_LONG: {
+            unsigned long long bits = readVarint(data, end);
+            auto number = (long long int)(bits >> 1) ^ -(long long int)(bits & 1);
+            if (type == SMCApi::VT_BYTE) {
+                SMCApi::Number result((signed char)number);
+                value.setValue(&result);
+            } else if (type == SMCApi::VT_SHORT) {
+                SMCApi::Number result((short)number);
+                value.setValue(&result);
+            } else if (type == SMCApi::VT_INTEGER) {
+                SMCApi::Number result((long)number);
+                value.setValue(&result);
+            } else {
+                SMCApi::Number result(number);
+                value.setValue(&result);
+            }
+            break;
+        }
+        case SMCApi::VT_FLOAT: {
+            float number;
+            if (end - data != sizeof(number))
+                throw SMCApi::ModuleException(L"wrong record");
+            auto bits = (unsigned int)readFixed(data, sizeof(number));
+            memcpy(&number, &bits, sizeof(number));
+            SMCApi::Number result(number);
+            value.setValue(&result);
+            break;
+        }
+        case SMCApi::VT_DOUBLE: {
+            double number;
+            if (end - data != sizeof(number))
+                throw SMCApi::ModuleException(L"wrong record");
+            unsigned long long bits = readFixed(data, sizeof(number));
+            memcpy(&number, &bits, sizeof(number));
+            SMCApi::Number result(number);
+            value.setValue(&result);
+            break;
+        }
+        case SMCApi::VT_BIG_INTEGER:
+        case SMCApi::VT_BIG_DECIMAL: {
+            auto* valueString = new char[end - data + 1];
+            memcpy(valueString, data, end - data);
+            valueString[end - data] = 0;
+            SMCApi::Number result(type == SMCApi::VT_BIG_INTEGER ? SMCApi::NT_BIG_INTEGER : SMCApi::NT_BIG_DECIMAL, valueString);
+            value.setValue(&result);
+            break;
+        }
+        case SMCApi::VT_BYTES:
+            value.setValue((const signed char*)data, (size_t)(end - data));
+            break;
+        case SMCApi::VT_BOOLEAN:
+            if (end - data != 1)
+                throw SMCApi::ModuleException(L"wrong record");
+            value.setValue(*data != 0);
+            break;
+        case SMCApi::VT_OBJECT_ARRAY: {
+            // block is checked by copy, so damaged block or block from platform with other byte order is not replayed
+            SMCApi::FrozenObjectArray* array = SMCApi::FrozenObjectArray::copy(data, (size_t)(end - data));
+            value.setValue(array);
+            array->release();
+            break;
+        }
+        default:
+            throw SMCApi::ModuleException(L"wrong record");
+        }
+    }
+}
+
+struct SMCApi::MessageLogWriter::State {
+    std::wstring directory;
+    MessageLogOptions options;
+    bool opened;
+    NativeFile file;
+    /**
+     * size of current segment with buffered records
+     */
+    size_t segmentLength;
+    unsigned long long sequence;
+    std::vector<char> buffer;
+    std::vector<char> payload;
+    std::string text;
+    size_t countNotSynced;
+    std::chrono::steady_clock::time_point firstNotSynced;
+
+    State(const std::wstring& directory, const MessageLogOptions& options) : directory(directory), options(options), opened(false), file(),
+                                                                              segmentLength(0), sequence(0), countNotSynced(0) {
+    }
+
+    void openSegment() {
+        file = openWrite(segmentPath(directory, sequence));
+        truncateFile(file, 0);
+        opened = true;
+        buffer.insert(buffer.end(), SEGMENT_MAGIC, SEGMENT_MAGIC + sizeof(SEGMENT_MAGIC));
+        buffer.push_back(SEGMENT_VERSION);
+        buffer.push_back(0);
+        appendFixed(buffer, sequence, 8);
+        segmentLength = SEGMENT_HEADER_SIZE;
+    }
+
+    /**
+     * continue last segment after last complete record
+     */
+    void open() {
+        makeDirectory(directory);
+        std::vector<Segment> segments = listSegments(directory);
+        if (segments.empty())
+            return;
+        const Segment& last = segments.back();
+        size_t end = SEGMENT_HEADER_SIZE;
+        unsigned long long count = 0;
+        FileTool segmentFile(last.path);
+        size_t length = segmentFile.length();
+        if (length < SEGMENT_HEADER_SIZE) {
+            // segment without header (example: crash on create) is created again
+            sequence = last.first;
+            openSegment();
+            return;
+        }
+        IFileMapping* mapping = segmentFile.map(0, length);
+        try {
+            readSegmentHeader(mapping->getData(), length, last.path);
+            while (size_t next = recordEnd(mapping->getData(), length, end)) {
+                end = next;
+                count++;
+            }
+        } catch (...) {
+            mapping->close();
+            throw;
+        }
+        mapping->close();
+        sequence = last.first + count;
+        file = openWrite(last.path);
+        opened = true;
+        truncateFile(file, end);
+        segmentLength = end;
+    }
+
+    void encode(MessageType type, long long int date, IValue* value) {
+        payload.clear();
+        ValueType valueType = value ? value->getType() : VT_STRING;
+        payload.push_back((char)type);
+        payload.push_back((char)valueType);
+        payload.push_back(value ? 0 : PAYLOAD_NULL);
+        appendFixed(payload, (unsigned long long)date, 8);
+        if (value == nullptr)
+            return;
+        switch (valueType) {
+        case VT_STRING: {
+            auto* typed = dynamic_cast<Value*>(value);
+            const std::string* utf8 = typed ? typed->getValueUtf8() : nullptr;
+            if (utf8 == nullptr) {
+                std::wstring* string = value->getValueString();
+                if (string == nullptr) {
+                    payload[2] = PAYLOAD_NULL;
+                    break;
+                }
+                text.clear();
+                toUtf8(string->data(), string->size(), text);
+                utf8 = &text;
+            }
+            appendBytes(payload, utf8->data(), utf8->size());
+            break;
+        }
+        case VT_BYTE:
+        case VT_SHORT:
+        case VT_INTEGER:
+        case VT_LONG:
+        case VT_FLOAT:
+        case VT_DOUBLE:
+        case VT_BIG_INTEGER:
+        case VT_BIG_DECIMAL: {
+            Number* number = value->getValueNumber();
+            if (number == nullptr) {
+                payload[2] = PAYLOAD_NULL;
+                break;
+            }
+            if (isInteger(valueType)) {
+                long long int integer = number->longValue();
+                appendVarint(payload, ((unsigned long long)integer << 1) ^ (unsigned long long)(integer >> 63));
+            } else if (valueType == VT_FLOAT) {
+                float floatValue = number->floatValue();
+                unsigned int bits;
+                memcpy(&bits, &floatValue, sizeof(bits));
+                appendFixed(payload, bits, sizeof(bits));
+            } else if (valueType == VT_DOUBLE) {
+                double doubleValue = number->doubleValue();
+                unsigned long long bits;
+                memcpy(&bits, &doubleValue, sizeof(bits));
+                appendFixed(payload, bits, sizeof(bits));
+            } else {
+                std::string string = number->toString();
+                appendBytes(payload, string.data(), string.size());
+            }
+            break;
+        }
+        case VT_BYTES: {
+            auto* typed = dynamic_cast<Value*>(value);
+            if (typed) {
+                const ByteBuffer* bytes = typed->getValueByteBuffer();
+                appendBytes(payload, bytes->getData(), bytes->getSize());
+            } else if (signed char* bytes = value->getValueBytes()) {
+                appendBytes(payload, bytes, value->getBytesCount());
+            } else {
+                payload[2] = PAYLOAD_NULL;
+            }
+            break;
+        }
+        case VT_BOOLEAN:
+            payload.push_back(value->getValueBoolean() ? 1 : 0);
+            break;
+        case VT_OBJECT_ARRAY: {
+            auto* typed = dynamic_cast<Value*>(value);
+            FrozenObjectArray* frozen = typed ? typed->getValueFrozenObjectArray() : nullptr;
+            if (frozen) {
+                appendBytes(payload, frozen->getData(), frozen->getDataSize());
+            } else if (ObjectArray* array = value->getValueObjectArray()) {
+                frozen = FrozenObjectArray::freeze(array);
+                appendBytes(payload, frozen->getData(), frozen->getDataSize());
+                frozen->release();
+            } else {
+                payload[2] = PAYLOAD_NULL;
+            }
+            break;
+        }
+        }
+    }
+};
+
+SMCApi::MessageLogWriter::MessageLogWriter(const std::wstring& directory, const SMCApi::MessageLogOptions& options) :
+        state(new State(directory, options)) {
+    try {
+        state->open();
+    } catch (...) {
+        if (state->opened)
+            closeFile(state->file);
+        delete state;
+        throw;
+    }
+}
+
+void SMCApi::MessageLogWriter::write(bool sync) {
+    if (!state->opened)
+        return;
+    if (!state->buffer.empty()) {
+        writeFile(state->file, state->buffer.data(), state->buffer.size());
+        state->buffer.clear();
+    }
+    if (sync) {
+        syncFile(state->file);
+        state->countNotSynced = 0;
+    }
+}
+
+unsigned long long SMCApi::MessageLogWriter::append(SMCApi::IMessage* message) {
+    if (message == nullptr)
+        throw ModuleException(L"wrong message");
+    return append(message->getMessageType(), message->getDate(), message);
+}
+
+unsigned long long SMCApi::MessageLogWriter::append(SMCApi::MessageType type, long long int date, SMCApi::IValue* value) {
+    state->encode(type, date, value);
+    size_t recordSize = RECORD_HEADER_SIZE + state->payload.size();
+    if (state->opened && state->segmentLength > SEGMENT_HEADER_SIZE && state->segmentLength + recordSize > state->options.segmentSize) {
+        write(state->options.syncPolicy != LSP_NONE);
+        closeFile(state->file);
+        state->opened = false;
+    }
+    if (!state->opened)
+        state->openSegment();
+    appendFixed(state->buffer, state->payload.size(), 4);
+    appendFixed(state->buffer, checksum(state->payload.data(), state->payload.size()), 4);
+    state->buffer.insert(state->buffer.end(), state->payload.begin(), state->payload.end());
+    state->segmentLength += recordSize;
+    unsigned long long sequence = state->sequence++;
+    auto now = std::chrono::steady_clock::now();
+    if (state->countNotSynced++ == 0)
+        state->firstNotSynced = now;
+    if (state->options.syncPolicy == LSP_ALWAYS || (state->options.syncPolicy == LSP_BATCH && (state->countNotSynced >= state->options.syncCount ||
+            std::chrono::duration_cast<std::chrono::milliseconds>(now - state->firstNotSynced).count() >= state->options.syncInterval))) {
+        write(true);
+    } else if (state->buffer.size() >= state->options.bufferSize) {
+        write(false);
+    }
+    return sequence;
+}
+
+void SMCApi::MessageLogWriter::flush() {
+    write(false);
+}
+
+void SMCApi::MessageLogWriter::sync() {
+    write(true);
+}
+
+unsigned long long SMCApi::MessageLogWriter::nextSequence() const {
+    return state->sequence;
+}
+
+SMCApi::MessageLogWriter::~MessageLogWriter() {
+    try {
+        write(state->options.syncPolicy != LSP_NONE);
+    } catch (...) {
+    }
+    if (state->opened)
+        closeFile(state->file);
+    delete state;
+}
+
+struct SMCApi::MessageLogReader::State {
+    std::wstring directory;
+    std::vector<Segment> segments;
+    size_t segmentId;
+    IFileMapping* mapping;
+    const char* data;
+    size_t length;
+    size_t position;
+    unsigned long long fromSequence;
+    /**
+     * sequence of record at position
+     */
+    unsigned long long nextSequence;
+    unsigned long long sequence;
+    LogMessage message;
+    std::string text;
+
+    State(const std::wstring& directory, unsigned long long fromSequence) : directory(directory), segmentId(0), mapping(nullptr), data(nullptr),
+                                                                          length(0), position(0), fromSequence(fromSequence), nextSequence(0),
+                                                                          sequence(0) {
+    }
+
+    void unmap() {
+        if (mapping)
+            mapping->close();
+        mapping = nullptr;
+        data = nullptr;
+        length = 0;
+    }
+
+    ~State() {
+        unmap();
+    }
+};
+
+SMCApi::MessageLogReader::MessageLogReader(const std::wstring& directory, unsigned long long fromSequence) :
+        state(new State(directory, fromSequence)) {
+    state->segments = listSegments(directory);
+    size_t id = 0;
+    while (id + 1 < state->segments.size() && state->segments[id + 1].first <= fromSequence)
+        id++;
+    if (!state->segments.empty()) {
+        try {
+            openSegment(id, SEGMENT_HEADER_SIZE);
+        } catch (...) {
+            delete state;
+            throw;
+        }
+    }
+}
+
+bool SMCApi::MessageLogReader::openSegment(size_t id, size_t position) {
+    const Segment& segment = state->segments[id];
+    FileTool segmentFile(segment.path);
+    size_t length = segmentFile.length();
+    if (length < SEGMENT_HEADER_SIZE)
+        return false;
+    IFileMapping* mapping = segmentFile.map(0, length);
+    unsigned long long first;
+    try {
+        first = readSegmentHeader(mapping->getData(), length, segment.path);
+    } catch (...) {
+        mapping->close();
+        throw;
+    }
+    if (id != state->segmentId || state->mapping == nullptr)
+        state->nextSequence = first;
+    state->unmap();
+    state->mapping = mapping;
+    state->data = mapping->getData();
+    state->length = length;
+    state->segmentId = id;
+    state->position = position;
+    return true;
+}
+
+bool SMCApi::MessageLogReader::next() {
+    while (true) {
+        size_t end = state->data ? recordEnd(state->data, state->length, state->position) : 0;
+        if (end) {
+            const char* payload = state->data + state->position + RECORD_HEADER_SIZE;
+            state->position = end;
+            unsigned long long sequence = state->nextSequence++;
+            if (sequence < state->fromSequence)
+                continue;
+            LogMessage& message = state->message;
+            message.value.clear();
+            message.messageType = (MessageType)(unsigned char)payload[0];
+            message.valueType = (ValueType)(unsigned char)payload[1];
+            message.null = (payload[2] & PAYLOAD_NULL) != 0;
+            message.date = (long long int)readFixed(payload + 3, 8);
+            if (!message.null)
+                decodeValue(message.valueType, payload + PAYLOAD_HEADER_SIZE, state->data + end, message.value, state->text);
+            state->sequence = sequence;
+            return true;
+        }
+        if (state->segments.empty() || state->segmentId + 1 >= state->segments.size())
+            state->segments = listSegments(state->directory);
+        if (state->segments.empty())
+            return false;
+        if (state->data == nullptr || FileTool(state->segments[state->segmentId].path).length() > state->length) {
+            // segment is written after it was mapped
+            size_t length = state->length;
+            if (!openSegment(state->segmentId, state->data ? state->position : SEGMENT_HEADER_SIZE))
+                return false;
+            if (state->length > length && recordEnd(state->data, state->length, state->position))
+                continue;
+        }
+        if (state->segmentId + 1 >= state->segments.size())
+            return false;
+        if (!openSegment(state->segmentId + 1, SEGMENT_HEADER_SIZE))
+            return false;
+    }
+}
+
+unsigned long long SMCApi::MessageLogReader::getSequence() const {
+    return state->sequence;
+}
+
+SMCApi::IMessage* SMCApi::MessageLogReader::getMessage() {
+    return &state->message;
+}
+
+SMCApi::MessageLogReader::~MessageLogReader() {
+    delete state;
+}
+
+void SMCApi::removeMessageLog(const std::wstring& directory) {
+    for (const Segment& segment : listSegments(directory))
+        removeFile(segment.path);
+    removeDirectory(directory);
+}
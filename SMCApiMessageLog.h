@@ -0,0 +1,176 @@
+/*
+Library (provider c++), is a part of the platform Shelf MK (Shell for modular structures, SMC platform).
+The author and copyright holder of the software package (application) Shelf MK (Shell for modular structures, SMC platform) is Ulyanov Nikolay Vladimirovich (ulianownv@mail.ru).
+The following are prohibited: changing and distributing the program code, selling/reselling it, as well as other actions and rights not expressly permitted.
+*/
+
+#include "SMCApi.h"
+
+#ifndef SMCMODULEDEFINITIONPROVIDER_SMCAPIMESSAGELOG_H
+#define SMCMODULEDEFINITIONPROVIDER_SMCAPIMESSAGELOG_H
+
+namespace SMCApi {
+    enum LogSyncPolicy {
+        /**
+         * data is written on full buffer, flush and close, operating system decides when it is on disk
+         */
+        LSP_NONE,
+        /**
+         * data is written and synced after syncCount records or syncInterval milliseconds from first not synced record (checked on append)
+         */
+        LSP_BATCH,
+        /**
+         * data is written and synced after each record
+         */
+        LSP_ALWAYS
+    };
+
+    /**
+     * options of MessageLogWriter
+     *
+     * @version 1.0.0
+     */
+    struct CLASS_DECLSPEC MessageLogOptions {
+        /**
+         * new segment is started when size of segment is greater
+         */
+        size_t segmentSize = 64 * 1024 * 1024;
+        LogSyncPolicy syncPolicy = LSP_BATCH;
+        size_t syncCount = 1000;
+        long long int syncInterval = 100;
+        /**
+         * size of buffer of not written records
+         */
+        size_t bufferSize = 64 * 1024;
+    };
+
+    /**
+     * append only log of messages in folder, log is split in segment files (<first sequence>.smclog)
+     * record: size, checksum, message type, value type, date, value (integers as variable length numbers, strings in UTF-8,
+     * ObjectArray as block of FrozenObjectArray), numbers of fixed size are little endian, so log can be read on other platform
+     * (except ObjectArray values, block of FrozenObjectArray has native byte order)
+     * on open of existing log records are continued, not complete record at end of last segment (example: after crash) is removed
+     * not thread safe, one writer for folder
+     *
+     * @version 1.0.0
+     */
+    class CLASS_DECLSPEC MessageLogWriter {
+    private:
+        struct State;
+
+        State* state;
+
+        void write(bool sync);
+
+    public:
+        /**
+         * open or create log
+         *
+         * @param directory             folder, created if not exists
+         * @param options               MessageLogOptions
+         */
+        explicit MessageLogWriter(const std::wstring& directory, const MessageLogOptions& options = MessageLogOptions());
+
+        MessageLogWriter(const MessageLogWriter&) = delete;
+
+        MessageLogWriter& operator=(const MessageLogWriter&) = delete;
+
+        /**
+         * add message
+         *
+         * @param message               IMessage
+         * @return sequence of record
+         */
+        unsigned long long append(IMessage* message);
+
+        /**
+         * add record
+         *
+         * @param type                  type of message
+         * @param date                  date
+         * @param value                 value, null (or value with null string, number, bytes, ObjectArray) is saved as null of its type
+         * @return sequence of record
+         */
+        unsigned long long append(MessageType type, long long int date, IValue* value);
+
+        /**
+         * write buffered records to file without sync
+         */
+        void flush();
+
+        /**
+         * write buffered records and wait while they are on disk
+         */
+        void sync();
+
+        /**
+         * sequence of next record (count of records in log)
+         *
+         * @return unsigned long long
+         */
+        unsigned long long nextSequence() const;
+
+        /**
+         * write buffered records, sync if policy is not LSP_NONE and close
+         */
+        ~MessageLogWriter();
+    };
+
+    /**
+     * sequential reader of log, segments are mapped to memory
+     * records added after end is reached are read by next calls of next (tail)
+     *
+     * @version 1.0.0
+     */
+    class CLASS_DECLSPEC MessageLogReader {
+    private:
+        struct State;
+
+        State* state;
+
+        bool openSegment(size_t id, size_t position);
+
+    public:
+        /**
+         * @param directory             folder of log
+         * @param fromSequence          sequence of first record
+         */
+        explicit MessageLogReader(const std::wstring& directory, unsigned long long fromSequence = 0);
+
+        MessageLogReader(const MessageLogReader&) = delete;
+
+        MessageLogReader& operator=(const MessageLogReader&) = delete;
+
+        /**
+         * read next record
+         *
+         * @return false if there are no more records
+         */
+        bool next();
+
+        /**
+         * sequence of current record
+         *
+         * @return unsigned long long
+         */
+        unsigned long long getSequence() const;
+
+        /**
+         * current record, valid until next call of next
+         *
+         * @return IMessage, ObjectArray value is FrozenObjectArray (without copy until getValueObjectArray), getters of null value return null
+         */
+        IMessage* getMessage();
+
+        ~MessageLogReader();
+    };
+
+    /**
+     * delete segments of log and folder
+     *
+     * @param directory             folder of log
+     */
+    CLASS_DECLSPEC void removeMessageLog(const std::wstring& directory);
+}
+
+#endif //SMCMODULEDEFINITIONPROVIDER_SMCAPIMESSAGELOG_H
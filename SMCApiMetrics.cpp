@@ -0,0 +1,632 @@
+/*
+Library (provider c++), is a part of the platform Shelf MK (Shell for modular structures, SMC platform).
+The author and copyright holder of the software package (application) Shelf MK (Shell for modular structures, SMC platform) is Ulyanov Nikolay Vladimirovich (ulianownv@mail.ru).
+The following are prohibited: changing and distributing the program code, selling/reselling it, as well as other actions and rights not expressly permitted.
+*/
+
+#include "SMCApiMetrics.h"
+#include <cmath>
+#include <cstdio>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace {
+    struct ContextCache {
+        unsigned long long owner;
+        const void* key;
+        SMCApi::ContextMetrics* metrics;
+    };
+
+    thread_local ContextCache executionContextCache = {0, nullptr, nullptr};
+    thread_local ContextCache configurationCache = {0, nullptr, nullptr};
+
+    std::atomic<unsigned long long> lastInstrumentationId(0);
+
+    int highestBit(unsigned long long value) {
+#ifdef _MSC_VER
+        unsigned long index;
+        if (_BitScanReverse(&index, (unsigned long)(value >> 32)))
+            return (int)index + 32;
+        _BitScanReverse(&index, (unsigned long)value);
+        return (int)index;
+#else
+        return 63 - __builtin_clzll(value);
+#endif
+    }
+
+    /**
+     * call function for every metric of context
+     * function(const wchar_t* name, const LatencyHistogram* histogram, const Counter* counter), one of pointers is null
+     */
+    template<typename Function>
+    void forEachMetric(const SMCApi::ContextMetrics* metrics, Function function) {
+        function(L"start", &metrics->start, nullptr);
+        function(L"process", &metrics->process, nullptr);
+        function(L"update", &metrics->update, nullptr);
+        function(L"stop", &metrics->stop, nullptr);
+        function(L"getMessages", &metrics->getMessages, nullptr);
+        function(L"getCommands", &metrics->getCommands, nullptr);
+        function(L"addMessage", &metrics->addMessage, nullptr);
+        function(L"executeNow", &metrics->executeNow, nullptr);
+        function(L"executeParallel", &metrics->executeParallel, nullptr);
+        function(L"messagesPerCall", &metrics->messagesPerCall, nullptr);
+        function(L"countMessagesIn", nullptr, &metrics->countMessagesIn);
+        function(L"countMessagesOut", nullptr, &metrics->countMessagesOut);
+        function(L"countErrors", nullptr, &metrics->countErrors);
+        function(L"countLogs", nullptr, &metrics->countLogs);
+        function(L"countExceptions", nullptr, &metrics->countExceptions);
+    }
+
+    void appendJsonString(std::string& result, const std::wstring& value) {
+        result.push_back('"');
+        for (char c : SMCApi::toUtf8(value)) {
+            if (c == '"' || c == '\\') {
+                result.push_back('\\');
+                result.push_back(c);
+            } else if ((unsigned char)c < 0x20) {
+                char buffer[8];
+                snprintf(buffer, sizeof(buffer), "\\u%04x", (unsigned int)(unsigned char)c);
+                result.append(buffer);
+            } else {
+                result.push_back(c);
+            }
+        }
+        result.push_back('"');
+    }
+
+    long countMessages(std::vector<SMCApi::IAction*>* actions) {
+        long count = 0;
+        if (actions) {
+            for (auto action : *actions)
+                count += (long)action->getMessages()->size();
+        }
+        return count;
+    }
+
+    long countMessages(std::vector<SMCApi::ICommand*>* commands) {
+        long count = 0;
+        if (commands) {
+            for (auto command : *commands)
+                count += countMessages(command->getActions());
+        }
+        return count;
+    }
+}
+
+SMCApi::LatencyHistogram::LatencyHistogram() {
+    reset();
+}
+
+int SMCApi::LatencyHistogram::bucketIndex(unsigned long long value) {
+    if (value < (unsigned long long)SUB_BUCKETS)
+        return (int)value;
+    int shift = highestBit(value) - SUB_BUCKET_BITS;
+    return (shift + 1) * SUB_BUCKETS + (int)((value >> shift) - SUB_BUCKETS);
+}
+
+unsigned long long SMCApi::LatencyHistogram::bucketValue(int index) {
+    if (index < SUB_BUCKETS)
+        return (unsigned long long)index;
+    int shift = index / SUB_BUCKETS - 1;
+    unsigned long long subBucket = (unsigned long long)(SUB_BUCKETS + index % SUB_BUCKETS);
+    return ((subBucket + 1) << shift) - 1;
+}
+
+void SMCApi::LatencyHistogram::record(long long int value) {
+    unsigned long long v = value < 0 ? 0 : (unsigned long long)value;
+    counts[bucketIndex(v)].fetch_add(1, std::memory_order_relaxed);
+    totalCount.fetch_add(1, std::memory_order_relaxed);
+    totalSum.fetch_add(v, std::memory_order_relaxed);
+    unsigned long long current = minValue.load(std::memory_order_relaxed);
+    while (v < current && !minValue.compare_exchange_weak(current, v, std::memory_order_relaxed)) {
+    }
+    current = maxValue.load(std::memory_order_relaxed);
+    while (v > current && !maxValue.compare_exchange_weak(current, v, std::memory_order_relaxed)) {
+    }
+}
+
+long long int SMCApi::LatencyHistogram::count() const {
+    return (long long int)totalCount.load(std::memory_order_relaxed);
+}
+
+long long int SMCApi::LatencyHistogram::sum() const {
+    return (long long int)totalSum.load(std::memory_order_relaxed);
+}
+
+long long int SMCApi::LatencyHistogram::min() const {
+    return count() > 0 ? (long long int)minValue.load(std::memory_order_relaxed) : 0;
+}
+
+long long int SMCApi::LatencyHistogram::max() const {
+    return (long long int)maxValue.load(std::memory_order_relaxed);
+}
+
+double SMCApi::LatencyHistogram::mean() const {
+    long long int countValues = count();
+    return countValues > 0 ? (double)sum() / (double)countValues : 0;
+}
+
+long long int SMCApi::LatencyHistogram::percentile(double percentile) const {
+    unsigned long long countValues = totalCount.load(std::memory_order_relaxed);
+    if (countValues == 0)
+        return 0;
+    if (percentile < 0)
+        percentile = 0;
+    if (percentile > 100)
+        percentile = 100;
+    unsigned long long target = (unsigned long long)std::ceil(percentile / 100.0 * (double)countValues);
+    if (target == 0)
+        target = 1;
+    unsigned long long accumulated = 0;
+    for (int i = 0; i < BUCKETS; i++) {
+        accumulated += counts[i].load(std::memory_order_relaxed);
+        if (accumulated >= target) {
+            long long int value = (long long int)bucketValue(i);
+            if (value > max())
+                value = max();
+            if (value < min())
+                value = min();
+            return value;
+        }
+    }
+    return max();
+}
+
+void SMCApi::LatencyHistogram::add(const SMCApi::LatencyHistogram& other) {
+    unsigned long long countValues = other.totalCount.load(std::memory_order_relaxed);
+    if (countValues == 0)
+        return;
+    for (int i = 0; i < BUCKETS; i++) {
+        unsigned long long value = other.counts[i].load(std::memory_order_relaxed);
+        if (value)
+            counts[i].fetch_add(value, std::memory_order_relaxed);
+    }
+    totalCount.fetch_add(countValues, std::memory_order_relaxed);
+    totalSum.fetch_add(other.totalSum.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    unsigned long long v = other.minValue.load(std::memory_order_relaxed);
+    unsigned long long current = minValue.load(std::memory_order_relaxed);
+    while (v < current && !minValue.compare_exchange_weak(current, v, std::memory_order_relaxed)) {
+    }
+    v = other.maxValue.load(std::memory_order_relaxed);
+    current = maxValue.load(std::memory_order_relaxed);
+    while (v > current && !maxValue.compare_exchange_weak(current, v, std::memory_order_relaxed)) {
+    }
+}
+
+void SMCApi::LatencyHistogram::reset() {
+    for (int i = 0; i < BUCKETS; i++)
+        counts[i].store(0, std::memory_order_relaxed);
+    totalCount.store(0, std::memory_order_relaxed);
+    totalSum.store(0, std::memory_order_relaxed);
+    minValue.store(~0ULL, std::memory_order_relaxed);
+    maxValue.store(0, std::memory_order_relaxed);
+}
+
+SMCApi::Counter::Counter() : value(0) {
+}
+
+void SMCApi::Counter::add(long long int count) {
+    value.fetch_add(count, std::memory_order_relaxed);
+}
+
+long long int SMCApi::Counter::get() const {
+    return value.load(std::memory_order_relaxed);
+}
+
+void SMCApi::Counter::reset() {
+    value.store(0, std::memory_order_relaxed);
+}
+
+SMCApi::ContextMetrics::ContextMetrics(const std::wstring& name) : name(name) {
+}
+
+void SMCApi::ContextMetrics::reset() {
+    start.reset();
+    process.reset();
+    update.reset();
+    stop.reset();
+    getMessages.reset();
+    getCommands.reset();
+    addMessage.reset();
+    executeNow.reset();
+    executeParallel.reset();
+    messagesPerCall.reset();
+    countMessagesIn.reset();
+    countMessagesOut.reset();
+    countErrors.reset();
+    countLogs.reset();
+    countExceptions.reset();
+}
+
+SMCApi::Instrumentation::Instrumentation() : enable(true), id(++lastInstrumentationId), pTraceRecorder(nullptr) {
+}
+
+bool SMCApi::Instrumentation::isEnable() const {
+    return enable.load(std::memory_order_relaxed);
+}
+
+void SMCApi::Instrumentation::setEnable(bool enable) {
+    Instrumentation::enable.store(enable, std::memory_order_relaxed);
+}
+
+void SMCApi::Instrumentation::setTraceRecorder(SMCApi::TraceRecorder* recorder) {
+    pTraceRecorder = recorder;
+}
+
+SMCApi::TraceRecorder* SMCApi::Instrumentation::getTraceRecorder() const {
+    return pTraceRecorder;
+}
+
+SMCApi::ContextMetrics* SMCApi::Instrumentation::getContext(const std::wstring& name) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = contexts.find(name);
+    if (it != contexts.end())
+        return it->second;
+    auto metrics = new ContextMetrics(name);
+    contexts[name] = metrics;
+    return metrics;
+}
+
+SMCApi::ContextMetrics* SMCApi::Instrumentation::getContext(SMCApi::CFGIExecutionContext* executionContext) {
+    if (executionContextCache.owner == id && executionContextCache.key == executionContext)
+        return executionContextCache.metrics;
+    ContextMetrics* metrics = getContext(executionContext ? executionContext->getName() : std::wstring());
+    executionContextCache = {id, executionContext, metrics};
+    return metrics;
+}
+
+SMCApi::ContextMetrics* SMCApi::Instrumentation::getContext(SMCApi::CFGIConfiguration* configuration) {
+    if (configurationCache.owner == id && configurationCache.key == configuration)
+        return configurationCache.metrics;
+    ContextMetrics* metrics = getContext(configuration ? configuration->getName() : std::wstring());
+    configurationCache = {id, configuration, metrics};
+    return metrics;
+}
+
+void SMCApi::Instrumentation::reset() {
+    std::lock_guard<std::mutex> lock(mutex);
+    for (auto& context : contexts)
+        context.second->reset();
+}
+
+SMCApi::ObjectArray* SMCApi::Instrumentation::snapshot() const {
+    auto result = new ObjectArray(ObjectType::OT_OBJECT_ELEMENT);
+    std::lock_guard<std::mutex> lock(mutex);
+    for (auto& context : contexts) {
+        forEachMetric(context.second, [&](const wchar_t* name, const LatencyHistogram* histogram, const Counter* counter) {
+            long long int count = histogram ? histogram->count() : counter->get();
+            if (count == 0)
+                return;
+            auto element = new ObjectElement();
+            element->reserve(histogram ? 11 : 4);
+            element->add(ObjectField(L"context", Utf8String(context.first)));
+            element->add(ObjectField(L"metric", Utf8String(name)));
+            element->add(ObjectField(L"count", Number(count)));
+            if (histogram) {
+                element->add(ObjectField(L"sum", Number(histogram->sum())));
+                element->add(ObjectField(L"min", Number(histogram->min())));
+                element->add(ObjectField(L"max", Number(histogram->max())));
+                element->add(ObjectField(L"mean", Number(histogram->mean())));
+                element->add(ObjectField(L"p50", Number(histogram->percentile(50))));
+                element->add(ObjectField(L"p90", Number(histogram->percentile(90))));
+                element->add(ObjectField(L"p99", Number(histogram->percentile(99))));
+                element->add(ObjectField(L"p999", Number(histogram->percentile(99.9))));
+            }
+            result->add(element);
+        });
+    }
+    return result;
+}
+
+std::string SMCApi::Instrumentation::toJson() const {
+    std::string result("[");
+    std::lock_guard<std::mutex> lock(mutex);
+    for (auto& context : contexts) {
+        forEachMetric(context.second, [&](const wchar_t* name, const LatencyHistogram* histogram, const Counter* counter) {
+            long long int count = histogram ? histogram->count() : counter->get();
+            if (count == 0)
+                return;
+            if (result.size() > 1)
+                result.push_back(',');
+            result.append("{\"context\":");
+            appendJsonString(result, context.first);
+            result.append(",\"metric\":");
+            appendJsonString(result, name);
+            char buffer[512];
+            if (histogram) {
+                snprintf(buffer, sizeof(buffer),
+                         ",\"count\":%lld,\"sum\":%lld,\"min\":%lld,\"max\":%lld,\"mean\":%.3f,\"p50\":%lld,\"p90\":%lld,\"p99\":%lld,\"p999\":%lld}",
+                         count, histogram->sum(), histogram->min(), histogram->max(), histogram->mean(), histogram->percentile(50),
+                         histogram->percentile(90), histogram->percentile(99), histogram->percentile(99.9));
+            } else {
+                snprintf(buffer, sizeof(buffer), ",\"count\":%lld}", count);
+            }
+            result.append(buffer);
+        });
+    }
+    result.push_back(']');
+    return result;
+}
+
+bool SMCApi::Instrumentation::save(const std::wstring& path) const {
+    std::string json = toJson();
+#ifdef _WIN32
+    FILE* file = _wfopen(path.c_str(), L"wb");
+#else
+    FILE* file = fopen(toUtf8(path).c_str(), "wb");
+#endif
+    if (file == nullptr)
+        return false;
+    bool result = fwrite(json.data(), 1, json.size(), file) == json.size();
+    return fclose(file) == 0 && result;
+}
+
+SMCApi::Instrumentation::~Instrumentation() {
+    for (auto& context : contexts)
+        delete context.second;
+    contexts.clear();
+}
+
+SMCApi::InstrumentedFlowControlTool::InstrumentedFlowControlTool(SMCApi::IFlowControlTool* tool, SMCApi::ContextMetrics* metrics,
+                                                                 SMCApi::TraceRecorder* recorder, bool sampled)
+    : tool(tool), metrics(metrics), recorder(recorder), sampled(sampled) {
+}
+
+long SMCApi::InstrumentedFlowControlTool::countManagedExecutionContexts() {
+    return tool->countManagedExecutionContexts();
+}
+
+void SMCApi::InstrumentedFlowControlTool::executeNow(SMCApi::CommandType type, long managedId, std::vector<IValue*>* values) {
+    long long int start = nowNanoseconds();
+    tool->executeNow(type, managedId, values);
+    long long int end = nowNanoseconds();
+    metrics->executeNow.record(end - start);
+    if (sampled)
+        recorder->record(L"executeNow", &metrics->name, start, end, managedId);
+}
+
+long long int SMCApi::InstrumentedFlowControlTool::executeParallel(SMCApi::CommandType type, long managedId, std::vector<IValue*>* values,
+                                                                   long waitingTacts, long maxWorkInterval) {
+    long long int start = nowNanoseconds();
+    long long int result = tool->executeParallel(type, managedId, values, waitingTacts, maxWorkInterval);
+    long long int end = nowNanoseconds();
+    metrics->executeParallel.record(end - start);
+    if (sampled) {
+        recorder->record(L"executeParallel", &metrics->name, start, end, managedId);
+        recorder->startAsync(L"waitThread", &metrics->name, result);
+    }
+    return result;
+}
+
+bool SMCApi::InstrumentedFlowControlTool::isThreadActive(long long int threadId) {
+    bool result = tool->isThreadActive(threadId);
+    if (!result && recorder)
+        recorder->finishAsync(threadId);
+    return result;
+}
+
+std::vector<SMCApi::IAction*>* SMCApi::InstrumentedFlowControlTool::getMessagesFromExecuted(long managedId) {
+    return tool->getMessagesFromExecuted(managedId);
+}
+
+std::vector<SMCApi::IAction*>* SMCApi::InstrumentedFlowControlTool::getMessagesFromExecuted(long long int threadId, long managedId) {
+    return tool->getMessagesFromExecuted(threadId, managedId);
+}
+
+std::vector<SMCApi::ICommand*>* SMCApi::InstrumentedFlowControlTool::getCommandsFromExecuted(long managedId) {
+    return tool->getCommandsFromExecuted(managedId);
+}
+
+std::vector<SMCApi::ICommand*>* SMCApi::InstrumentedFlowControlTool::getCommandsFromExecuted(long long int threadId, long managedId) {
+    return tool->getCommandsFromExecuted(threadId, managedId);
+}
+
+void SMCApi::InstrumentedFlowControlTool::releaseThread(long long int threadId) {
+    if (recorder)
+        recorder->finishAsync(threadId);
+    tool->releaseThread(threadId);
+}
+
+void SMCApi::InstrumentedFlowControlTool::releaseThreadCache(long long int threadId) {
+    tool->releaseThreadCache(threadId);
+}
+
+SMCApi::CFGIExecutionContext* SMCApi::InstrumentedFlowControlTool::getManagedExecutionContext(int id) {
+    return tool->getManagedExecutionContext(id);
+}
+
+SMCApi::InstrumentedFlowControlTool::~InstrumentedFlowControlTool() {
+}
+
+SMCApi::InstrumentedExecutionContextTool::InstrumentedExecutionContextTool(SMCApi::IExecutionContextTool* tool, SMCApi::ContextMetrics* metrics,
+                                                                           SMCApi::TraceRecorder* recorder, bool sampled)
+    : tool(tool), metrics(metrics), recorder(recorder), sampled(sampled && recorder != nullptr), pFlowControlTool(nullptr) {
+}
+
+void SMCApi::InstrumentedExecutionContextTool::addMessage(SMCApi::IValue* value) {
+    long long int start = nowNanoseconds();
+    tool->addMessage(value);
+    metrics->addMessage.record(nowNanoseconds() - start);
+    metrics->countMessagesOut.add();
+}
+
+void SMCApi::InstrumentedExecutionContextTool::addError(SMCApi::IValue* value) {
+    tool->addError(value);
+    metrics->countErrors.add();
+}
+
+void SMCApi::InstrumentedExecutionContextTool::addLog(const std::wstring& text) {
+    tool->addLog(text);
+    metrics->countLogs.add();
+}
+
+long SMCApi::InstrumentedExecutionContextTool::countCommands(long sourceId) {
+    return tool->countCommands(sourceId);
+}
+
+long SMCApi::InstrumentedExecutionContextTool::countCommands(SMCApi::CFGIExecutionContextManaged* executionContext) {
+    return tool->countCommands(executionContext);
+}
+
+std::vector<SMCApi::IAction*>* SMCApi::InstrumentedExecutionContextTool::getMessages(long sourceId) {
+    long long int start = nowNanoseconds();
+    std::vector<IAction*>* result = tool->getMessages(sourceId);
+    metrics->getMessages.record(nowNanoseconds() - start);
+    long count = countMessages(result);
+    metrics->messagesPerCall.record(count);
+    metrics->countMessagesIn.add(count);
+    return result;
+}
+
+std::vector<SMCApi::IAction*>* SMCApi::InstrumentedExecutionContextTool::getMessages(long sourceId, long fromIndex, long toIndex) {
+    long long int start = nowNanoseconds();
+    std::vector<IAction*>* result = tool->getMessages(sourceId, fromIndex, toIndex);
+    metrics->getMessages.record(nowNanoseconds() - start);
+    long count = countMessages(result);
+    metrics->messagesPerCall.record(count);
+    metrics->countMessagesIn.add(count);
+    return result;
+}
+
+std::vector<SMCApi::ICommand*>* SMCApi::InstrumentedExecutionContextTool::getCommands(long sourceId) {
+    long long int start = nowNanoseconds();
+    std::vector<ICommand*>* result = tool->getCommands(sourceId);
+    metrics->getCommands.record(nowNanoseconds() - start);
+    long count = countMessages(result);
+    metrics->messagesPerCall.record(count);
+    metrics->countMessagesIn.add(count);
+    return result;
+}
+
+std::vector<SMCApi::ICommand*>* SMCApi::InstrumentedExecutionContextTool::getCommands(long sourceId, long fromIndex, long toIndex) {
+    long long int start = nowNanoseconds();
+    std::vector<ICommand*>* result = tool->getCommands(sourceId, fromIndex, toIndex);
+    metrics->getCommands.record(nowNanoseconds() - start);
+    long count = countMessages(result);
+    metrics->messagesPerCall.record(count);
+    metrics->countMessagesIn.add(count);
+    return result;
+}
+
+std::vector<SMCApi::ICommand*>* SMCApi::InstrumentedExecutionContextTool::getCommands(SMCApi::CFGIExecutionContextManaged* executionContext,
+                                                                                     long fromIndex, long toIndex) {
+    long long int start = nowNanoseconds();
+    std::vector<ICommand*>* result = tool->getCommands(executionContext, fromIndex, toIndex);
+    metrics->getCommands.record(nowNanoseconds() - start);
+    long count = countMessages(result);
+    metrics->messagesPerCall.record(count);
+    metrics->countMessagesIn.add(count);
+    return result;
+}
+
+bool SMCApi::InstrumentedExecutionContextTool::isError(SMCApi::IAction* action) {
+    return tool->isError(action);
+}
+
+SMCApi::IConfigurationControlTool* SMCApi::InstrumentedExecutionContextTool::getConfigurationControlTool() {
+    return tool->getConfigurationControlTool();
+}
+
+SMCApi::IFlowControlTool* SMCApi::InstrumentedExecutionContextTool::getFlowControlTool() {
+    if (pFlowControlTool == nullptr) {
+        IFlowControlTool* flowControlTool = tool->getFlowControlTool();
+        if (flowControlTool == nullptr)
+            return nullptr;
+        pFlowControlTool = new InstrumentedFlowControlTool(flowControlTool, metrics, recorder, sampled);
+    }
+    return pFlowControlTool;
+}
+
+bool SMCApi::InstrumentedExecutionContextTool::isNeedStop() {
+    return tool->isNeedStop();
+}
+
+SMCApi::CFGIExecutionContext* SMCApi::InstrumentedExecutionContextTool::getExecutionContext() {
+    return tool->getExecutionContext();
+}
+
+SMCApi::InstrumentedExecutionContextTool::~InstrumentedExecutionContextTool() {
+    delete pFlowControlTool;
+    pFlowControlTool = nullptr;
+}
+
+SMCApi::InstrumentedMethod::InstrumentedMethod(SMCApi::IMethod* method, SMCApi::Instrumentation* instrumentation)
+    : method(method), instrumentation(instrumentation) {
+}
+
+void SMCApi::InstrumentedMethod::start(SMCApi::IConfigurationTool* configurationTool, SMCApi::IValueFactory* valueFactory) {
+    if (!instrumentation->isEnable()) {
+        method->start(configurationTool, valueFactory);
+        return;
+    }
+    ContextMetrics* metrics = instrumentation->getContext(configurationTool->getConfiguration());
+    TraceSpan span(instrumentation->getTraceRecorder(), L"start", &metrics->name);
+    long long int start = nowNanoseconds();
+    try {
+        method->start(configurationTool, valueFactory);
+    } catch (...) {
+        metrics->start.record(nowNanoseconds() - start);
+        metrics->countExceptions.add();
+        throw;
+    }
+    metrics->start.record(nowNanoseconds() - start);
+}
+
+void SMCApi::InstrumentedMethod::process(SMCApi::IConfigurationTool* configurationTool, SMCApi::IExecutionContextTool* executionContextTool,
+                                         SMCApi::IValueFactory* valueFactory) {
+    if (!instrumentation->isEnable()) {
+        method->process(configurationTool, executionContextTool, valueFactory);
+        return;
+    }
+    ContextMetrics* metrics = instrumentation->getContext(executionContextTool->getExecutionContext());
+    TraceRecorder* recorder = instrumentation->getTraceRecorder();
+    bool sampled = recorder && recorder->sample();
+    InstrumentedExecutionContextTool tool(executionContextTool, metrics, recorder, sampled);
+    TraceSpan span(sampled ? recorder : nullptr, L"process", &metrics->name);
+    long long int start = nowNanoseconds();
+    try {
+        method->process(configurationTool, &tool, valueFactory);
+    } catch (...) {
+        metrics->process.record(nowNanoseconds() - start);
+        metrics->countExceptions.add();
+        throw;
+    }
+    metrics->process.record(nowNanoseconds() - start);
+}
+
+void SMCApi::InstrumentedMethod::update(SMCApi::IConfigurationTool* configurationTool, SMCApi::IValueFactory* valueFactory) {
+    if (!instrumentation->isEnable()) {
+        method->update(configurationTool, valueFactory);
+        return;
+    }
+    ContextMetrics* metrics = instrumentation->getContext(configurationTool->getConfiguration());
+    TraceSpan span(instrumentation->getTraceRecorder(), L"update", &metrics->name);
+    long long int start = nowNanoseconds();
+    try {
+        method->update(configurationTool, valueFactory);
+    } catch (...) {
+        metrics->update.record(nowNanoseconds() - start);
+        metrics->countExceptions.add();
+        throw;
+    }
+    metrics->update.record(nowNanoseconds() - start);
+}
+
+void SMCApi::InstrumentedMethod::stop(SMCApi::IConfigurationTool* configurationTool, SMCApi::IValueFactory* valueFactory) {
+    if (!instrumentation->isEnable()) {
+        method->stop(configurationTool, valueFactory);
+        return;
+    }
+    ContextMetrics* metrics = instrumentation->getContext(configurationTool->getConfiguration());
+    TraceSpan span(instrumentation->getTraceRecorder(), L"stop", &metrics->name);
+    long long int start = nowNanoseconds();
+    try {
+        method->stop(configurationTool, valueFactory);
+    } catch (...) {
+        metrics->stop.record(nowNanoseconds() - start);
+        metrics->countExceptions.add();
+        throw;
+    }
+    metrics->stop.record(nowNanoseconds() - start);
+}
@@ -0,0 +1,372 @@
+/*
+Library (provider c++), is a part of the platform Shelf MK (Shell for modular structures, SMC platform).
+The author and copyright holder of the software package (application) Shelf MK (Shell for modular structures, SMC platform) is Ulyanov Nikolay Vladimirovich (ulianownv@mail.ru).
+The following are prohibited: changing and distributing the program code, selling/reselling it, as well as other actions and rights not expressly permitted.
+*/
+
+#include "SMCApi.h"
+#include "SMCApiTrace.h"
+#include <atomic>
+#include <map>
+#include <mutex>
+
+#ifndef SMCMODULEDEFINITIONPROVIDER_SMCAPIMETRICS_H
+#define SMCMODULEDEFINITIONPROVIDER_SMCAPIMETRICS_H
+
+namespace SMCApi {
+    /**
+     * log-linear histogram of non negative values (HDR style)
+     * values below 32 are exact, others are grouped in 32 buckets per power of two (relative error below 1/32)
+     * record is lock free and can be called from many threads
+     *
+     * @version 1.0.0
+     */
+    class CLASS_DECLSPEC LatencyHistogram {
+    public:
+        static const int SUB_BUCKET_BITS = 5;
+        static const int SUB_BUCKETS = 1 << SUB_BUCKET_BITS;
+        static const int BUCKETS = (64 - SUB_BUCKET_BITS + 1) * SUB_BUCKETS;
+
+    private:
+        std::atomic<unsigned long long> counts[BUCKETS];
+        std::atomic<unsigned long long> totalCount;
+        std::atomic<unsigned long long> totalSum;
+        std::atomic<unsigned long long> minValue;
+        std::atomic<unsigned long long> maxValue;
+
+    public:
+        LatencyHistogram();
+
+        LatencyHistogram(const LatencyHistogram&) = delete;
+
+        LatencyHistogram& operator=(const LatencyHistogram&) = delete;
+
+        /**
+         * add value, negative values are recorded as 0
+         *
+         * @param value                 value
+         */
+        void record(long long int value);
+
+        long long int count() const;
+
+        long long int sum() const;
+
+        long long int min() const;
+
+        long long int max() const;
+
+        double mean() const;
+
+        /**
+         * value at percentile, highest value of bucket limited by max
+         *
+         * @param percentile            from 0 to 100
+         * @return value or 0 if empty
+         */
+        long long int percentile(double percentile) const;
+
+        /**
+         * add all values of other histogram
+         *
+         * @param other                 LatencyHistogram
+         */
+        void add(const LatencyHistogram& other);
+
+        void reset();
+
+        /**
+         * bucket of value
+         *
+         * @param value                 value
+         * @return bucket id
+         */
+        static int bucketIndex(unsigned long long value);
+
+        /**
+         * highest value of bucket
+         *
+         * @param index                 bucket id
+         * @return value
+         */
+        static unsigned long long bucketValue(int index);
+    };
+
+    /**
+     * lock free counter
+     *
+     * @version 1.0.0
+     */
+    class CLASS_DECLSPEC Counter {
+    private:
+        std::atomic<long long int> value;
+
+    public:
+        Counter();
+
+        void add(long long int count = 1);
+
+        long long int get() const;
+
+        void reset();
+    };
+
+    /**
+     * metrics of one configuration or execution context
+     * lifecycle calls (start, update, stop) are collected by configuration name, process and tool calls - by execution context name
+     * all times in nanoseconds
+     *
+     * @version 1.0.0
+     */
+    struct CLASS_DECLSPEC ContextMetrics {
+        const std::wstring name;
+
+        LatencyHistogram start;
+        LatencyHistogram process;
+        LatencyHistogram update;
+        LatencyHistogram stop;
+
+        LatencyHistogram getMessages;
+        LatencyHistogram getCommands;
+        LatencyHistogram addMessage;
+        LatencyHistogram executeNow;
+        LatencyHistogram executeParallel;
+
+        /**
+         * count of messages, returned by one getMessages or getCommands call
+         */
+        LatencyHistogram messagesPerCall;
+
+        Counter countMessagesIn;
+        Counter countMessagesOut;
+        Counter countErrors;
+        Counter countLogs;
+        Counter countExceptions;
+
+        explicit ContextMetrics(const std::wstring& name);
+
+        void reset();
+    };
+
+    /**
+     * registry of metrics
+     * enabled by default, when disabled instrumented wrappers call original objects only
+     *
+     * @version 1.0.0
+     */
+    class CLASS_DECLSPEC Instrumentation {
+    private:
+        std::map<std::wstring, ContextMetrics*> contexts;
+        mutable std::mutex mutex;
+        std::atomic<bool> enable;
+        const unsigned long long id;
+        TraceRecorder* pTraceRecorder;
+
+    public:
+        Instrumentation();
+
+        Instrumentation(const Instrumentation&) = delete;
+
+        Instrumentation& operator=(const Instrumentation&) = delete;
+
+        bool isEnable() const;
+
+        void setEnable(bool enable);
+
+        /**
+         * record spans of instrumented calls
+         * set before instrumented calls are started
+         *
+         * @param recorder              TraceRecorder, not owned, null for disable
+         */
+        void setTraceRecorder(TraceRecorder* recorder);
+
+        TraceRecorder* getTraceRecorder() const;
+
+        /**
+         * get or create metrics
+         * returned object is valid until instrumentation is deleted
+         *
+         * @param name                  configuration or execution context name
+         * @return ContextMetrics
+         */
+        ContextMetrics* getContext(const std::wstring& name);
+
+        /**
+         * metrics of execution context, last result is cached per thread
+         *
+         * @param executionContext      CFGIExecutionContext, may be null
+         * @return ContextMetrics
+         */
+        ContextMetrics* getContext(CFGIExecutionContext* executionContext);
+
+        /**
+         * metrics of configuration, last result is cached per thread
+         *
+         * @param configuration         CFGIConfiguration, may be null
+         * @return ContextMetrics
+         */
+        ContextMetrics* getContext(CFGIConfiguration* configuration);
+
+        /**
+         * set all metrics to zero
+         */
+        void reset();
+
+        /**
+         * metrics as array of elements, one element for each not empty metric
+         * fields: context, metric, count and for histograms sum, min, max, mean, p50, p90, p99, p999
+         *
+         * @return ObjectArray, caller owns it
+         */
+        ObjectArray* snapshot() const;
+
+        /**
+         * metrics as JSON array, same structure as snapshot
+         *
+         * @return UTF-8 string
+         */
+        std::string toJson() const;
+
+        /**
+         * write toJson to file
+         *
+         * @param path                  file path
+         * @return true if written
+         */
+        bool save(const std::wstring& path) const;
+
+        virtual ~Instrumentation();
+    };
+
+    /**
+     * IFlowControlTool wrapper, measure executeNow and executeParallel
+     * with trace recorder the time from executeParallel to isThreadActive returned false is recorded as async span waitThread
+     *
+     * @version 1.0.0
+     */
+    class CLASS_DECLSPEC InstrumentedFlowControlTool : public IFlowControlTool {
+    private:
+        IFlowControlTool* tool;
+        ContextMetrics* metrics;
+        TraceRecorder* recorder;
+        bool sampled;
+
+    public:
+        /**
+         * @param tool                  original tool
+         * @param metrics               metrics of execution context
+         * @param recorder              TraceRecorder or null
+         * @param sampled               record spans of calls
+         */
+        InstrumentedFlowControlTool(IFlowControlTool* tool, ContextMetrics* metrics, TraceRecorder* recorder = nullptr, bool sampled = false);
+
+        long countManagedExecutionContexts() override;
+
+        void executeNow(CommandType type, long managedId, std::vector<IValue*>* values) override;
+
+        long long int executeParallel(CommandType type, long managedId, std::vector<IValue*>* values, long waitingTacts, long maxWorkInterval) override;
+
+        bool isThreadActive(long long int threadId) override;
+
+        std::vector<IAction*>* getMessagesFromExecuted(long managedId) override;
+
+        std::vector<IAction*>* getMessagesFromExecuted(long long int threadId, long managedId) override;
+
+        std::vector<ICommand*>* getCommandsFromExecuted(long managedId) override;
+
+        std::vector<ICommand*>* getCommandsFromExecuted(long long int threadId, long managedId) override;
+
+        void releaseThread(long long int threadId) override;
+
+        void releaseThreadCache(long long int threadId) override;
+
+        CFGIExecutionContext* getManagedExecutionContext(int id) override;
+
+        virtual ~InstrumentedFlowControlTool();
+    };
+
+    /**
+     * IExecutionContextTool wrapper, measure get and add calls
+     *
+     * @version 1.0.0
+     */
+    class CLASS_DECLSPEC InstrumentedExecutionContextTool : public IExecutionContextTool {
+    private:
+        IExecutionContextTool* tool;
+        ContextMetrics* metrics;
+        TraceRecorder* recorder;
+        bool sampled;
+        InstrumentedFlowControlTool* pFlowControlTool;
+
+    public:
+        /**
+         * @param tool                  original tool
+         * @param metrics               metrics of execution context
+         * @param recorder              TraceRecorder or null
+         * @param sampled               record spans of calls
+         */
+        InstrumentedExecutionContextTool(IExecutionContextTool* tool, ContextMetrics* metrics, TraceRecorder* recorder = nullptr, bool sampled = false);
+
+        void addMessage(IValue* value) override;
+
+        void addError(IValue* value) override;
+
+        void addLog(const std::wstring& text) override;
+
+        long countCommands(long sourceId) override;
+
+        long countCommands(CFGIExecutionContextManaged* executionContext) override;
+
+        std::vector<IAction*>* getMessages(long sourceId) override;
+
+        std::vector<IAction*>* getMessages(long sourceId, long fromIndex, long toIndex) override;
+
+        std::vector<ICommand*>* getCommands(long sourceId) override;
+
+        std::vector<ICommand*>* getCommands(long sourceId, long fromIndex, long toIndex) override;
+
+        std::vector<ICommand*>* getCommands(CFGIExecutionContextManaged* executionContext, long fromIndex, long toIndex) override;
+
+        bool isError(IAction* action) override;
+
+        IConfigurationControlTool* getConfigurationControlTool() override;
+
+        IFlowControlTool* getFlowControlTool() override;
+
+        bool isNeedStop() override;
+
+        CFGIExecutionContext* getExecutionContext() override;
+
+        virtual ~InstrumentedExecutionContextTool();
+    };
+
+    /**
+     * IMethod wrapper, measure lifecycle calls and calls of tools, passed to process
+     * use it in place of module object, example: new InstrumentedMethod(new Module(), &instrumentation)
+     *
+     * @version 1.0.0
+     */
+    class CLASS_DECLSPEC InstrumentedMethod : public IMethod {
+    private:
+        IMethod* method;
+        Instrumentation* instrumentation;
+
+    public:
+        /**
+         * @param method                module, not owned
+         * @param instrumentation       metrics registry, not owned
+         */
+        InstrumentedMethod(IMethod* method, Instrumentation* instrumentation);
+
+        void start(IConfigurationTool* configurationTool, IValueFactory* valueFactory) override;
+
+        void process(IConfigurationTool* configurationTool, IExecutionContextTool* executionContextTool, IValueFactory* valueFactory) override;
+
+        void update(IConfigurationTool* configurationTool, IValueFactory* valueFactory) override;
+
+        void stop(IConfigurationTool* configurationTool, IValueFactory* valueFactory) override;
+    };
+}
+
+#endif //SMCMODULEDEFINITIONPROVIDER_SMCAPIMETRICS_H
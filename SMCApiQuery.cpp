@@ -0,0 +1,1279 @@
+/*
+Library (provider c++), is a part of the platform Shelf MK (Shell for modular structures, SMC platform).
+The author and copyright holder of the software package (application) Shelf MK (Shell for modular structures, SMC platform) is Ulyanov Nikolay Vladimirovich (ulianownv@mail.ru).
+The following are prohibited: changing and distributing the program code, selling/reselling it, as well as other actions and rights not expressly permitted.
+*/
+
+#include "SMCApiQuery.h"
+#include "SMCApiFieldPath.h"
+#include <algorithm>
+#include <cstring>
+#include <exception>
+#include <map>
+#include <thread>
+#include <unordered_map>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SMCAPI_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace {
+    using SMCApi::internal::splitPath;
+    using SMCApi::internal::FieldPath;
+
+    /**
+     * count of values reduced at once, block stays in L1 cache for second pass of variance
+     */
+    const size_t BLOCK_SIZE = 512;
+
+    void reduceBlock(const double* values, size_t count, double& sum, double& min, double& max) {
+        size_t i = 0;
+#ifdef SMCAPI_SSE2
+        if (count >= 4) {
+            __m128d sum0 = _mm_setzero_pd();
+            __m128d sum1 = _mm_setzero_pd();
+            __m128d min0 = _mm_loadu_pd(values);
+            __m128d min1 = _mm_loadu_pd(values + 2);
+            __m128d max0 = min0;
+            __m128d max1 = min1;
+            for (; i + 4 <= count; i += 4) {
+                __m128d a = _mm_loadu_pd(values + i);
+                __m128d b = _mm_loadu_pd(values + i + 2);
+                sum0 = _mm_add_pd(sum0, a);
+                sum1 = _mm_add_pd(sum1, b);
+                min0 = _mm_min_pd(min0, a);
+                min1 = _mm_min_pd(min1, b);
+                max0 = _mm_max_pd(max0, a);
+                max1 = _mm_max_pd(max1, b);
+            }
+            double lanes[2];
+            _mm_storeu_pd(lanes, _mm_add_pd(sum0, sum1));
+            sum = lanes[0] + lanes[1];
+            _mm_storeu_pd(lanes, _mm_min_pd(min0, min1));
+            min = std::min(lanes[0], lanes[1]);
+            _mm_storeu_pd(lanes, _mm_max_pd(max0, max1));
+            max = std::max(lanes[0], lanes[1]);
+        } else {
+#endif
+            sum = 0;
+            min = values[0];
+            max = values[0];
+#ifdef SMCAPI_SSE2
+        }
+#endif
+        for (; i < count; i++) {
+            sum += values[i];
+            min = std::min(min, values[i]);
+            max = std::max(max, values[i]);
+        }
+    }
+
+    double squaredDeviation(const double* values, size_t count, double mean) {
+        size_t i = 0;
+        double result = 0;
+#ifdef SMCAPI_SSE2
+        __m128d meanVector = _mm_set1_pd(mean);
+        __m128d sum0 = _mm_setzero_pd();
+        __m128d sum1 = _mm_setzero_pd();
+        for (; i + 4 <= count; i += 4) {
+            __m128d a = _mm_sub_pd(_mm_loadu_pd(values + i), meanVector);
+            __m128d b = _mm_sub_pd(_mm_loadu_pd(values + i + 2), meanVector);
+            sum0 = _mm_add_pd(sum0, _mm_mul_pd(a, a));
+            sum1 = _mm_add_pd(sum1, _mm_mul_pd(b, b));
+        }
+        double lanes[2];
+        _mm_storeu_pd(lanes, _mm_add_pd(sum0, sum1));
+        result = lanes[0] + lanes[1];
+#endif
+        for (; i < count; i++) {
+            double delta = values[i] - mean;
+            result += delta * delta;
+        }
+        return result;
+    }
+
+    /**
+     * collect values in block and add block to aggregation when it is full
+     */
+    class BlockCollector {
+    private:
+        SMCApi::Aggregation& aggregation;
+        double values[BLOCK_SIZE];
+        size_t count;
+
+    public:
+        explicit BlockCollector(SMCApi::Aggregation& aggregation) : aggregation(aggregation), count(0) {
+        }
+
+        void add(const SMCApi::Number* value) {
+            values[count++] = const_cast<SMCApi::Number*>(value)->doubleValue();
+            if (count == BLOCK_SIZE)
+                flush();
+        }
+
+        void flush() {
+            aggregation.add(values, count);
+            count = 0;
+        }
+    };
+
+    struct NumberVisitor {
+        BlockCollector& collector;
+
+        void operator()(int, const SMCApi::Number* value, size_t) {
+            if (value)
+                collector.add(value);
+        }
+
+        template<typename T>
+        void operator()(int, const T*, size_t) {
+        }
+    };
+
+    class FieldPathVisitor {
+    private:
+        BlockCollector& collector;
+        FieldPath& path;
+
+    public:
+        FieldPathVisitor(BlockCollector& collector, FieldPath& path) : collector(collector), path(path) {
+        }
+
+        void operator()(int, const SMCApi::ObjectElement* element, size_t) {
+            const SMCApi::ObjectField* field = path.find(element);
+            const SMCApi::Number* value = field ? field->tryGetValueNumber() : nullptr;
+            if (value)
+                collector.add(value);
+        }
+
+        template<typename T>
+        void operator()(int, const T*, size_t) {
+        }
+    };
+
+    /**
+     * tags of values in binary key of group
+     */
+    enum KeyTag {
+        KEY_NULL,
+        KEY_STRING,
+        KEY_INTEGER,
+        KEY_FLOAT,
+        KEY_BIG_NUMBER,
+        KEY_BOOLEAN,
+        KEY_BYTES
+    };
+
+    void appendSized(std::string& key, KeyTag tag, const char* data, size_t size) {
+        key.push_back((char)tag);
+        auto length = (unsigned int)size;
+        key.append((const char*)&length, sizeof(length));
+        key.append(data, size);
+    }
+
+    void appendInteger(std::string& key, long long int number) {
+        key.push_back((char)KEY_INTEGER);
+        key.append((const char*)&number, sizeof(number));
+    }
+
+    /**
+     * append value of field to binary key, field may be null
+     */
+    void appendKey(std::string& key, const SMCApi::ObjectField* field) {
+        const void* value = field ? field->getStoredValue() : nullptr;
+        if (value == nullptr) {
+            key.push_back((char)KEY_NULL);
+            return;
+        }
+        switch (field->getType()) {
+        case SMCApi::OT_STRING: {
+            const std::string& text = ((const SMCApi::Utf8String*)value)->getValue();
+            appendSized(key, KEY_STRING, text.data(), text.size());
+            break;
+        }
+        case SMCApi::OT_BYTE:
+        case SMCApi::OT_SHORT:
+        case SMCApi::OT_INTEGER:
+        case SMCApi::OT_LONG: {
+            appendInteger(key, ((SMCApi::Number*)value)->longValue());
+            break;
+        }
+        case SMCApi::OT_FLOAT:
+        case SMCApi::OT_DOUBLE: {
+            double number = ((SMCApi::Number*)value)->doubleValue();
+            if (number == 0)
+                number = 0;
+            key.push_back((char)KEY_FLOAT);
+            key.append((const char*)&number, sizeof(number));
+            break;
+        }
+        case SMCApi::OT_BIG_INTEGER:
+        case SMCApi::OT_BIG_DECIMAL: {
+            std::string text = ((SMCApi::Number*)value)->toString();
+            appendSized(key, KEY_BIG_NUMBER, text.data(), text.size());
+            break;
+        }
+        case SMCApi::OT_BOOLEAN:
+            key.push_back((char)KEY_BOOLEAN);
+            key.push_back(*(const bool*)value ? 1 : 0);
+            break;
+        case SMCApi::OT_BYTES: {
+            auto buffer = (const SMCApi::ByteBuffer*)value;
+            appendSized(key, KEY_BYTES, (const char*)buffer->getData(), buffer->getSize());
+            break;
+        }
+        default:
+            throw SMCApi::ModuleException(L"wrong key type");
+        }
+    }
+
+    /**
+     * append values of fields of paths to binary key
+     *
+     * @return false if some value is null
+     */
+    bool appendKeys(std::string& key, std::vector<FieldPath>& paths, const SMCApi::ObjectElement* element) {
+        bool result = true;
+        for (auto& path : paths) {
+            const SMCApi::ObjectField* field = path.find(element);
+            if (field == nullptr || field->getStoredValue() == nullptr)
+                result = false;
+            appendKey(key, field);
+        }
+        return result;
+    }
+
+    std::vector<FieldPath> makePaths(const std::vector<std::wstring>& paths) {
+        std::vector<FieldPath> result;
+        result.reserve(paths.size());
+        for (auto& path : paths)
+            result.emplace_back(splitPath(path));
+        return result;
+    }
+
+    unsigned long long hashBytes(const char* data, size_t size) {
+        unsigned long long hash = 0x9E3779B97F4A7C15ULL ^ size;
+        size_t i = 0;
+        for (; i + 8 <= size; i += 8) {
+            unsigned long long word;
+            memcpy(&word, data + i, 8);
+            hash = (hash ^ word) * 0xFF51AFD7ED558CCDULL;
+            hash ^= hash >> 32;
+        }
+        unsigned long long word = 0;
+        memcpy(&word, data + i, size - i);
+        hash = (hash ^ word) * 0xC4CEB9FE1A85EC53ULL;
+        return hash ^ (hash >> 29);
+    }
+
+    struct Group {
+        unsigned long long hash;
+        size_t keyOffset;
+        size_t keyLength;
+        /**
+         * first record of group
+         */
+        size_t row;
+        size_t rows;
+    };
+
+    /**
+     * open addressing table of groups, keys are kept in one string
+     */
+    class GroupTable {
+    private:
+        std::vector<unsigned int> slots;
+        std::string keys;
+
+        void grow() {
+            std::vector<unsigned int> newSlots(slots.size() * 2, 0);
+            size_t mask = newSlots.size() - 1;
+            for (size_t id = 0; id < groups.size(); id++) {
+                size_t i = (size_t)groups[id].hash & mask;
+                while (newSlots[i] != 0)
+                    i = (i + 1) & mask;
+                newSlots[i] = (unsigned int)id + 1;
+            }
+            slots.swap(newSlots);
+        }
+
+    public:
+        std::vector<Group> groups;
+        /**
+         * aggregations of values, countValues for each group
+         */
+        std::vector<SMCApi::Aggregation> values;
+        const size_t countValues;
+
+        explicit GroupTable(size_t countValues) : slots(16, 0), countValues(countValues) {
+        }
+
+        /**
+         * find group or add new one
+         *
+         * @return group id
+         */
+        size_t find(const char* key, size_t length, unsigned long long hash, size_t row) {
+            size_t mask = slots.size() - 1;
+            for (size_t i = (size_t)hash & mask;; i = (i + 1) & mask) {
+                unsigned int slot = slots[i];
+                if (slot == 0) {
+                    groups.push_back({hash, keys.size(), length, row, 0});
+                    keys.append(key, length);
+                    values.resize(values.size() + countValues);
+                    slots[i] = (unsigned int)groups.size();
+                    if (groups.size() * 2 > slots.size())
+                        grow();
+                    return groups.size() - 1;
+                }
+                const Group& group = groups[slot - 1];
+                if (group.hash == hash && group.keyLength == length && memcmp(keys.data() + group.keyOffset, key, length) == 0)
+                    return slot - 1;
+            }
+        }
+
+        /**
+         * find group without change of table
+         *
+         * @return group id or -1
+         */
+        size_t lookup(const char* key, size_t length, unsigned long long hash) const {
+            size_t mask = slots.size() - 1;
+            for (size_t i = (size_t)hash & mask;; i = (i + 1) & mask) {
+                unsigned int slot = slots[i];
+                if (slot == 0)
+                    return (size_t)-1;
+                const Group& group = groups[slot - 1];
+                if (group.hash == hash && group.keyLength == length && memcmp(keys.data() + group.keyOffset, key, length) == 0)
+                    return slot - 1;
+            }
+        }
+
+        void merge(const GroupTable& other) {
+            for (size_t i = 0; i < other.groups.size(); i++) {
+                const Group& source = other.groups[i];
+                size_t id = find(other.keys.data() + source.keyOffset, source.keyLength, source.hash, source.row);
+                Group& group = groups[id];
+                group.rows += source.rows;
+                group.row = std::min(group.row, source.row);
+                for (size_t v = 0; v < countValues; v++)
+                    values[id * countValues + v].merge(other.values[i * countValues + v]);
+            }
+        }
+    };
+
+    /**
+     * run function(thread id) in count threads, current thread is used as one of them, first exception is thrown
+     */
+    template<typename Function>
+    void runThreads(size_t count, Function function) {
+        std::vector<std::exception_ptr> errors(count);
+        std::vector<std::thread> threads;
+        threads.reserve(count - 1);
+        for (size_t t = 1; t < count; t++) {
+            threads.emplace_back([&errors, &function, t]() {
+                try {
+                    function(t);
+                } catch (...) {
+                    errors[t] = std::current_exception();
+                }
+            });
+        }
+        try {
+            function(0);
+        } catch (...) {
+            errors[0] = std::current_exception();
+        }
+        for (auto& thread : threads)
+            thread.join();
+        for (auto& error : errors) {
+            if (error)
+                std::rethrow_exception(error);
+        }
+    }
+
+    /**
+     * records of one thread at least, smaller arrays use less threads
+     */
+    const size_t MIN_ROWS_PER_THREAD = 16384;
+
+    size_t countThreads(size_t threads, size_t size) {
+        if (threads == 0)
+            threads = std::max<size_t>(1, std::thread::hardware_concurrency());
+        return std::max<size_t>(1, std::min(threads, size / MIN_ROWS_PER_THREAD));
+    }
+
+    /**
+     * kinds of sort values in order of sort
+     */
+    enum SortKind {
+        SORT_NUMBER,
+        SORT_STRING,
+        SORT_BOOLEAN,
+        SORT_BYTES,
+        SORT_NULL
+    };
+
+    /**
+     * value of key of one item, strings and bytes point to values of array
+     */
+    struct SortValue {
+        unsigned char kind;
+        bool integer;
+        union {
+            long long int integerValue;
+            double floatValue;
+        };
+        const char* data;
+        size_t size;
+    };
+
+    SortValue makeSortValue(const SMCApi::Number* value) {
+        SortValue result = {SORT_NUMBER, false, {0}, nullptr, 0};
+        auto number = const_cast<SMCApi::Number*>(value);
+        switch (number->getType()) {
+        case SMCApi::NT_BYTE:
+        case SMCApi::NT_SHORT:
+        case SMCApi::NT_INTEGER:
+        case SMCApi::NT_LONG:
+            result.integer = true;
+            result.integerValue = number->longValue();
+            break;
+        default:
+            result.floatValue = number->doubleValue();
+            break;
+        }
+        return result;
+    }
+
+    SortValue makeSortValue(const SMCApi::Utf8String* value) {
+        return {SORT_STRING, false, {0}, value->getData(), value->getSize()};
+    }
+
+    SortValue makeSortValue(const SMCApi::ByteBuffer* value) {
+        return {SORT_BYTES, false, {0}, (const char*)value->getData(), value->getSize()};
+    }
+
+    SortValue makeSortValue(const bool* value) {
+        return {SORT_BOOLEAN, true, {*value ? 1 : 0}, nullptr, 0};
+    }
+
+    template<typename T>
+    SortValue makeSortValue(const T*) {
+        return {SORT_NULL, false, {0}, nullptr, 0};
+    }
+
+    SortValue makeSortValue(const SMCApi::ObjectField* field) {
+        SortValue result = {SORT_NULL, false, {0}, nullptr, 0};
+        if (field == nullptr || field->getStoredValue() == nullptr)
+            return result;
+        SMCApi::dispatchObjectType(field->getType(), [&](auto tag) {
+            typedef typename decltype(tag)::Type T;
+            result = makeSortValue((const T*)field->getStoredValue());
+        });
+        return result;
+    }
+
+    int compareNumbers(double a, double b) {
+        if (a < b)
+            return -1;
+        if (b < a)
+            return 1;
+        // NaN is after all numbers
+        bool nanA = a != a;
+        bool nanB = b != b;
+        return nanA == nanB ? 0 : nanA ? 1 : -1;
+    }
+
+    /**
+     * compare values, null is last also in descending order
+     */
+    int compareSortValues(const SortValue& a, const SortValue& b, bool descending) {
+        if (a.kind != b.kind) {
+            if (a.kind == SORT_NULL || b.kind == SORT_NULL)
+                return a.kind == SORT_NULL ? 1 : -1;
+            return (a.kind < b.kind) != descending ? -1 : 1;
+        }
+        int result;
+        switch (a.kind) {
+        case SORT_NULL:
+            return 0;
+        case SORT_NUMBER:
+        case SORT_BOOLEAN:
+            if (a.integer && b.integer)
+                result = a.integerValue < b.integerValue ? -1 : a.integerValue > b.integerValue ? 1 : 0;
+            else
+                result = compareNumbers(a.integer ? (double)a.integerValue : a.floatValue, b.integer ? (double)b.integerValue : b.floatValue);
+            break;
+        default:
+            result = std::min(a.size, b.size) > 0 ? memcmp(a.data, b.data, std::min(a.size, b.size)) : 0;
+            if (result == 0)
+                result = a.size < b.size ? -1 : a.size > b.size ? 1 : 0;
+            break;
+        }
+        return descending ? -result : result;
+    }
+
+    struct SortEntry {
+        SortValue first;
+        size_t id;
+    };
+
+    /**
+     * value of key with own copy of string or bytes
+     */
+    struct IndexKey {
+        SortValue value;
+        std::string text;
+
+        SortValue view() const {
+            SortValue result = value;
+            result.data = text.data();
+            return result;
+        }
+    };
+
+    IndexKey makeIndexKey(const SortValue& value) {
+        return {value, value.data ? std::string(value.data, value.size) : std::string()};
+    }
+
+    struct IndexKeyLess {
+        bool operator()(const IndexKey& a, const IndexKey& b) const {
+            return compareSortValues(a.view(), b.view(), false) < 0;
+        }
+    };
+
+    struct KeyHash {
+        size_t operator()(const std::string& key) const {
+            return (size_t)hashBytes(key.data(), key.size());
+        }
+    };
+
+    /**
+     * extract values of keys of items: first key in entries, all keys in values (only if there are several keys)
+     */
+    class SortKeyVisitor {
+    private:
+        std::vector<FieldPath>& paths;
+        const std::vector<bool>& itemKeys;
+        std::vector<SortEntry>& entries;
+        std::vector<SortValue>& values;
+
+        void set(size_t id, size_t k, const SortValue& value) {
+            if (k == 0)
+                entries[id] = {value, id};
+            if (!values.empty())
+                values[id * paths.size() + k] = value;
+        }
+
+    public:
+        SortKeyVisitor(std::vector<FieldPath>& paths, const std::vector<bool>& itemKeys, std::vector<SortEntry>& entries,
+                       std::vector<SortValue>& values)
+            : paths(paths), itemKeys(itemKeys), entries(entries), values(values) {
+        }
+
+        void operator()(int id, const SMCApi::ObjectElement* element, size_t) {
+            for (size_t k = 0; k < paths.size(); k++)
+                set((size_t)id, k, itemKeys[k] ? makeSortValue(element) : makeSortValue(paths[k].find(element)));
+        }
+
+        template<typename T>
+        void operator()(int id, const T* value, size_t) {
+            for (size_t k = 0; k < paths.size(); k++)
+                set((size_t)id, k, itemKeys[k] && value ? makeSortValue(value) : makeSortValue((const void*)nullptr));
+        }
+    };
+
+    /**
+     * sort in chunks in parallel, chunks are merged in pairs in parallel
+     */
+    template<typename Compare>
+    void parallelSort(std::vector<SortEntry>& entries, size_t threads, Compare compare) {
+        if (threads <= 1) {
+            std::sort(entries.begin(), entries.end(), compare);
+            return;
+        }
+        std::vector<size_t> bounds;
+        for (size_t t = 0; t <= threads; t++)
+            bounds.push_back(entries.size() * t / threads);
+        runThreads(threads, [&](size_t t) {
+            std::sort(entries.begin() + bounds[t], entries.begin() + bounds[t + 1], compare);
+        });
+        std::vector<SortEntry> buffer(entries.size());
+        for (size_t width = 1; width < threads; width *= 2) {
+            size_t countPairs = (threads + 2 * width - 1) / (2 * width);
+            runThreads(countPairs, [&](size_t pair) {
+                size_t begin = bounds[pair * 2 * width];
+                size_t middle = bounds[std::min(pair * 2 * width + width, threads)];
+                size_t end = bounds[std::min(pair * 2 * width + 2 * width, threads)];
+                std::merge(entries.begin() + begin, entries.begin() + middle, entries.begin() + middle, entries.begin() + end,
+                           buffer.begin() + begin, compare);
+            });
+            entries.swap(buffer);
+        }
+    }
+
+    /**
+     * first limit entries in order, every thread selects own top (nth_element, linear), results are merged
+     */
+    template<typename Compare>
+    void parallelTop(std::vector<SortEntry>& entries, size_t limit, size_t threads, Compare compare) {
+        if (threads > 1) {
+            std::vector<size_t> bounds;
+            for (size_t t = 0; t <= threads; t++)
+                bounds.push_back(entries.size() * t / threads);
+            runThreads(threads, [&](size_t t) {
+                size_t end = std::min(bounds[t] + limit, bounds[t + 1]);
+                std::nth_element(entries.begin() + bounds[t], entries.begin() + end, entries.begin() + bounds[t + 1], compare);
+            });
+            size_t count = 0;
+            for (size_t t = 0; t < threads; t++) {
+                size_t end = std::min(bounds[t] + limit, bounds[t + 1]);
+                for (size_t i = bounds[t]; i < end; i++)
+                    entries[count++] = entries[i];
+            }
+            entries.resize(count);
+        }
+        limit = std::min(limit, entries.size());
+        std::nth_element(entries.begin(), entries.begin() + limit, entries.end(), compare);
+        entries.resize(limit);
+        std::sort(entries.begin(), entries.end(), compare);
+    }
+}
+
+SMCApi::Aggregation::Aggregation() : countValues(0), sumValue(0), minValue(0), maxValue(0), m2(0) {
+}
+
+void SMCApi::Aggregation::add(double value) {
+    if (countValues == 0) {
+        minValue = value;
+        maxValue = value;
+    } else {
+        minValue = std::min(minValue, value);
+        maxValue = std::max(maxValue, value);
+    }
+    double delta = value - mean();
+    countValues++;
+    sumValue += value;
+    m2 += delta * (value - mean());
+}
+
+void SMCApi::Aggregation::add(const double* values, size_t count) {
+    for (size_t offset = 0; offset < count; offset += BLOCK_SIZE) {
+        size_t size = std::min(BLOCK_SIZE, count - offset);
+        Aggregation block;
+        reduceBlock(values + offset, size, block.sumValue, block.minValue, block.maxValue);
+        block.countValues = size;
+        block.m2 = squaredDeviation(values + offset, size, block.sumValue / (double)size);
+        merge(block);
+    }
+}
+
+void SMCApi::Aggregation::merge(const SMCApi::Aggregation& other) {
+    if (other.countValues == 0)
+        return;
+    if (countValues == 0) {
+        *this = other;
+        return;
+    }
+    double delta = other.mean() - mean();
+    double total = (double)(countValues + other.countValues);
+    m2 += other.m2 + delta * delta * (double)countValues * (double)other.countValues / total;
+    countValues += other.countValues;
+    sumValue += other.sumValue;
+    minValue = std::min(minValue, other.minValue);
+    maxValue = std::max(maxValue, other.maxValue);
+}
+
+size_t SMCApi::Aggregation::count() const {
+    return countValues;
+}
+
+double SMCApi::Aggregation::sum() const {
+    return sumValue;
+}
+
+double SMCApi::Aggregation::min() const {
+    return minValue;
+}
+
+double SMCApi::Aggregation::max() const {
+    return maxValue;
+}
+
+double SMCApi::Aggregation::mean() const {
+    return countValues > 0 ? sumValue / (double)countValues : 0;
+}
+
+double SMCApi::Aggregation::variance() const {
+    return countValues > 0 ? m2 / (double)countValues : 0;
+}
+
+SMCApi::Aggregation SMCApi::aggregate(const SMCApi::ObjectArray* array) {
+    Aggregation result;
+    BlockCollector collector(result);
+    array->visit(NumberVisitor{collector});
+    collector.flush();
+    return result;
+}
+
+SMCApi::Aggregation SMCApi::aggregate(const SMCApi::ObjectArray* array, const std::vector<std::wstring>& path) {
+    Aggregation result;
+    FieldPath fieldPath(path);
+    if (!fieldPath.isValid())
+        return result;
+    BlockCollector collector(result);
+    array->visit(FieldPathVisitor(collector, fieldPath));
+    collector.flush();
+    return result;
+}
+
+SMCApi::Aggregation SMCApi::aggregate(const SMCApi::ObjectArray* array, const std::wstring& path) {
+    return aggregate(array, splitPath(path));
+}
+
+SMCApi::GroupBy& SMCApi::GroupBy::key(const std::wstring& path) {
+    keys.push_back(path);
+    return *this;
+}
+
+SMCApi::GroupBy& SMCApi::GroupBy::aggregate(SMCApi::AggregateFunction function, const std::wstring& path, const std::wstring& name) {
+    if (path.empty() && function != AF_COUNT)
+        throw ModuleException(L"wrong path");
+    specs.push_back({function, path, name});
+    return *this;
+}
+
+SMCApi::ObjectArray* SMCApi::GroupBy::execute(const SMCApi::ObjectArray* array, size_t threads) const {
+    // distinct paths of values, AF_COUNT without path counts records (-1)
+    std::vector<std::wstring> valuePaths;
+    std::vector<int> specValues;
+    for (auto& spec : specs) {
+        if (spec.path.empty()) {
+            specValues.push_back(-1);
+            continue;
+        }
+        auto it = std::find(valuePaths.begin(), valuePaths.end(), spec.path);
+        specValues.push_back((int)(it - valuePaths.begin()));
+        if (it == valuePaths.end())
+            valuePaths.push_back(spec.path);
+    }
+    std::vector<std::vector<std::wstring>> keyNames;
+    for (auto& path : keys)
+        keyNames.push_back(splitPath(path));
+    std::vector<std::vector<std::wstring>> valueNames;
+    for (auto& path : valuePaths)
+        valueNames.push_back(splitPath(path));
+
+    size_t size = array->size();
+    threads = countThreads(threads, size);
+    size_t partitions = threads;
+
+    // every thread groups own range of records in own table for each partition
+    std::vector<std::vector<GroupTable>> tables(threads, std::vector<GroupTable>(partitions, GroupTable(valuePaths.size())));
+    runThreads(threads, [&](size_t t) {
+        std::vector<FieldPath> keyPaths;
+        for (auto& names : keyNames)
+            keyPaths.emplace_back(names);
+        std::vector<FieldPath> valueFieldPaths;
+        for (auto& names : valueNames)
+            valueFieldPaths.emplace_back(names);
+        std::vector<GroupTable>& partitionTables = tables[t];
+        std::string key;
+        size_t end = size * (t + 1) / threads;
+        for (size_t row = size * t / threads; row < end; row++) {
+            const ObjectElement* element = array->tryGetObjectElement((int)row);
+            if (element == nullptr)
+                continue;
+            key.clear();
+            appendKeys(key, keyPaths, element);
+            unsigned long long hash = hashBytes(key.data(), key.size());
+            GroupTable& table = partitionTables[partitions > 1 ? (size_t)(hash >> 40) % partitions : 0];
+            size_t id = table.find(key.data(), key.size(), hash, row);
+            table.groups[id].rows++;
+            for (size_t v = 0; v < valueFieldPaths.size(); v++) {
+                const ObjectField* field = valueFieldPaths[v].find(element);
+                const Number* number = field ? field->tryGetValueNumber() : nullptr;
+                if (number)
+                    table.values[id * table.countValues + v].add(const_cast<Number*>(number)->doubleValue());
+            }
+        }
+    });
+
+    // partitions are merged in parallel, partition has the same keys in all threads
+    runThreads(partitions, [&](size_t p) {
+        for (size_t t = 1; t < threads; t++)
+            tables[0][p].merge(tables[t][p]);
+    });
+
+    std::vector<std::pair<size_t, const Group*>> order;
+    for (size_t p = 0; p < partitions; p++) {
+        for (auto& group : tables[0][p].groups)
+            order.emplace_back(p, &group);
+    }
+    std::sort(order.begin(), order.end(), [](const std::pair<size_t, const Group*>& a, const std::pair<size_t, const Group*>& b) {
+        return a.second->row < b.second->row;
+    });
+
+    std::vector<unsigned int> keyNameIds;
+    for (auto& path : keys)
+        keyNameIds.push_back(SymbolTable::intern(path));
+    std::vector<unsigned int> specNameIds;
+    for (auto& spec : specs)
+        specNameIds.push_back(SymbolTable::intern(spec.name));
+    std::vector<FieldPath> keyPaths;
+    for (auto& names : keyNames)
+        keyPaths.emplace_back(names);
+
+    auto result = new ObjectArray(OT_OBJECT_ELEMENT);
+    try {
+        result->reserve(order.size());
+        for (auto& item : order) {
+            const GroupTable& table = tables[0][item.first];
+            const Group& group = *item.second;
+            size_t id = (size_t)(&group - table.groups.data());
+            auto element = new ObjectElement();
+            result->add(element);
+            element->reserve(keys.size() + specs.size());
+            const ObjectElement* first = array->getObjectElement((int)group.row);
+            for (size_t k = 0; k < keys.size(); k++) {
+                const ObjectField* field = keyPaths[k].find(first);
+                if (field) {
+                    ObjectField keyField(*field);
+                    keyField.setNameId(keyNameIds[k]);
+                    element->add(std::move(keyField));
+                } else {
+                    element->add(ObjectField(keyNameIds[k], OT_VALUE_ANY));
+                }
+            }
+            for (size_t s = 0; s < specs.size(); s++) {
+                int v = specValues[s];
+                if (specs[s].function == AF_COUNT) {
+                    size_t count = v < 0 ? group.rows : table.values[id * table.countValues + v].count();
+                    ObjectField field(specNameIds[s], OT_LONG);
+                    field.setValue(Number((long long int)count));
+                    element->add(std::move(field));
+                    continue;
+                }
+                const Aggregation& aggregation = table.values[id * table.countValues + v];
+                ObjectField field(specNameIds[s], OT_DOUBLE);
+                if (aggregation.count() > 0) {
+                    switch (specs[s].function) {
+                    case AF_SUM:
+                        field.setValue(Number(aggregation.sum()));
+                        break;
+                    case AF_MIN:
+                        field.setValue(Number(aggregation.min()));
+                        break;
+                    case AF_MAX:
+                        field.setValue(Number(aggregation.max()));
+                        break;
+                    case AF_MEAN:
+                        field.setValue(Number(aggregation.mean()));
+                        break;
+                    default:
+                        field.setValue(Number(aggregation.variance()));
+                        break;
+                    }
+                }
+                element->add(std::move(field));
+            }
+        }
+    } catch (...) {
+        delete result;
+        throw;
+    }
+    return result;
+}
+
+SMCApi::OrderBy& SMCApi::OrderBy::key(const std::wstring& path, bool descending) {
+    keys.push_back({path, descending});
+    return *this;
+}
+
+std::vector<size_t> SMCApi::OrderBy::order(const SMCApi::ObjectArray* array, size_t limit, size_t threads) const {
+    size_t size = array->size();
+    std::vector<SortEntry> entries(size);
+    std::vector<SortValue> values;
+    if (keys.empty()) {
+        for (size_t i = 0; i < size; i++)
+            entries[i].id = i;
+    } else {
+        std::vector<FieldPath> paths;
+        std::vector<bool> itemKeys;
+        for (auto& key : keys) {
+            paths.emplace_back(splitPath(key.path));
+            itemKeys.push_back(key.path.empty());
+        }
+        if (keys.size() > 1)
+            values.resize(size * keys.size());
+        array->visit(SortKeyVisitor(paths, itemKeys, entries, values));
+    }
+
+    size_t countKeys = keys.size();
+    auto compare = [&](const SortEntry& a, const SortEntry& b) {
+        if (countKeys > 0) {
+            int result = compareSortValues(a.first, b.first, keys[0].descending);
+            for (size_t k = 1; result == 0 && k < countKeys; k++)
+                result = compareSortValues(values[a.id * countKeys + k], values[b.id * countKeys + k], keys[k].descending);
+            if (result != 0)
+                return result < 0;
+        }
+        return a.id < b.id;
+    };
+    threads = countThreads(threads, size);
+    if (limit < size)
+        parallelTop(entries, limit, threads, compare);
+    else if (countKeys > 0)
+        parallelSort(entries, threads, compare);
+
+    std::vector<size_t> result;
+    result.reserve(entries.size());
+    for (auto& entry : entries)
+        result.push_back(entry.id);
+    return result;
+}
+
+void SMCApi::OrderBy::sort(SMCApi::ObjectArray* array, size_t threads) const {
+    array->reorder(order(array, (size_t)-1, threads));
+}
+
+void SMCApi::OrderBy::top(SMCApi::ObjectArray* array, size_t count, size_t threads) const {
+    array->reorder(order(array, count, threads));
+}
+
+/**
+ * groups of keys of reference array, items of group are rows[offsets[group] .. offsets[group + 1]]
+ */
+struct SMCApi::HashJoin::Index {
+    GroupTable table;
+    std::vector<size_t> offsets;
+    std::vector<size_t> rows;
+
+    Index() : table(0) {
+    }
+};
+
+const size_t SMCApi::HashJoin::NO_MATCH;
+
+SMCApi::HashJoin::HashJoin(const SMCApi::ObjectArray* array, const std::vector<std::wstring>& keys)
+    : array(array), index(new Index()), countKeys(keys.size()) {
+    if (keys.empty()) {
+        delete index;
+        throw ModuleException(L"wrong keys");
+    }
+    std::vector<FieldPath> paths = makePaths(keys);
+    std::vector<size_t> groupOfRow(array->size(), NO_MATCH);
+    std::string key;
+    for (size_t row = 0; row < array->size(); row++) {
+        const ObjectElement* element = array->tryGetObjectElement((int)row);
+        if (element == nullptr)
+            continue;
+        key.clear();
+        if (!appendKeys(key, paths, element))
+            continue;
+        size_t id = index->table.find(key.data(), key.size(), hashBytes(key.data(), key.size()), row);
+        index->table.groups[id].rows++;
+        groupOfRow[row] = id;
+    }
+    // rows of each group one after another, in order of array
+    std::vector<Group>& groups = index->table.groups;
+    index->offsets.assign(groups.size() + 1, 0);
+    for (size_t id = 0; id < groups.size(); id++)
+        index->offsets[id + 1] = index->offsets[id] + groups[id].rows;
+    index->rows.resize(index->offsets.back());
+    std::vector<size_t> positions(index->offsets.begin(), index->offsets.end() - 1);
+    for (size_t row = 0; row < groupOfRow.size(); row++) {
+        if (groupOfRow[row] != NO_MATCH)
+            index->rows[positions[groupOfRow[row]]++] = row;
+    }
+}
+
+size_t SMCApi::HashJoin::size() const {
+    return index->table.groups.size();
+}
+
+std::vector<std::pair<size_t, size_t>> SMCApi::HashJoin::match(const SMCApi::ObjectArray* probe, const std::vector<std::wstring>& keys,
+                                                               SMCApi::JoinType type, size_t threads) const {
+    if (keys.size() != countKeys)
+        throw ModuleException(L"wrong keys");
+    size_t size = probe->size();
+    threads = countThreads(threads, size);
+    std::vector<std::vector<std::pair<size_t, size_t>>> results(threads);
+    runThreads(threads, [&](size_t t) {
+        std::vector<FieldPath> paths = makePaths(keys);
+        std::vector<std::pair<size_t, size_t>>& result = results[t];
+        std::string key;
+        size_t end = size * (t + 1) / threads;
+        for (size_t row = size * t / threads; row < end; row++) {
+            const ObjectElement* element = probe->tryGetObjectElement((int)row);
+            if (element == nullptr)
+                continue;
+            key.clear();
+            size_t id = (size_t)-1;
+            if (appendKeys(key, paths, element))
+                id = index->table.lookup(key.data(), key.size(), hashBytes(key.data(), key.size()));
+            if (id == (size_t)-1) {
+                if (type == JT_LEFT)
+                    result.emplace_back(row, NO_MATCH);
+                continue;
+            }
+            for (size_t i = index->offsets[id]; i < index->offsets[id + 1]; i++)
+                result.emplace_back(row, index->rows[i]);
+        }
+    });
+    if (threads == 1)
+        return std::move(results[0]);
+    std::vector<std::pair<size_t, size_t>> result;
+    size_t count = 0;
+    for (auto& part : results)
+        count += part.size();
+    result.reserve(count);
+    for (auto& part : results)
+        result.insert(result.end(), part.begin(), part.end());
+    return result;
+}
+
+void SMCApi::HashJoin::enrich(SMCApi::ObjectArray* probe, const std::vector<std::wstring>& keys, const std::wstring& name, SMCApi::JoinType type,
+                              size_t threads) const {
+    std::vector<std::pair<size_t, size_t>> pairs = match(probe, keys, type, threads);
+    unsigned int nameId = SymbolTable::intern(name);
+    std::vector<size_t> matched;
+    matched.reserve(pairs.size());
+    for (size_t i = 0; i < pairs.size(); i++) {
+        size_t row = pairs[i].first;
+        if (i > 0 && pairs[i - 1].first == row)
+            continue;
+        auto element = const_cast<ObjectElement*>(probe->getObjectElement((int)row));
+        ObjectField* field = element->findField(nameId);
+        if (field == nullptr)
+            field = element->add(ObjectField(nameId, OT_OBJECT_ELEMENT));
+        if (pairs[i].second == NO_MATCH)
+            *field = ObjectField(nameId, OT_OBJECT_ELEMENT);
+        else
+            field->setValue(new ObjectElement(array->getObjectElement((int)pairs[i].second)));
+        matched.push_back(row);
+    }
+    if (type == JT_INNER && matched.size() != probe->size())
+        probe->reorder(matched);
+}
+
+SMCApi::HashJoin::~HashJoin() {
+    delete index;
+}
+
+struct SMCApi::HashIndex::Table {
+    FieldPath path;
+    std::unordered_multimap<std::string, const ObjectElement*, KeyHash> elements;
+    std::string key;
+
+    explicit Table(const std::wstring& path) : path(splitPath(path), true) {
+    }
+
+    /**
+     * key of element
+     *
+     * @return false if value is null
+     */
+    bool makeKey(const ObjectElement* element) {
+        key.clear();
+        const ObjectField* field = path.find(element);
+        if (field == nullptr || field->getStoredValue() == nullptr)
+            return false;
+        appendKey(key, field);
+        return true;
+    }
+
+    const ObjectElement* findFirst(const std::string& value) const {
+        auto it = elements.find(value);
+        return it != elements.end() ? it->second : nullptr;
+    }
+};
+
+SMCApi::HashIndex::HashIndex(SMCApi::ObjectArray* array, const std::wstring& path) : array(array), table(new Table(path)) {
+    for (size_t i = 0; i < array->size(); i++) {
+        const ObjectElement* element = array->tryGetObjectElement((int)i);
+        if (element)
+            insert(element);
+    }
+    array->addObserver(this);
+}
+
+void SMCApi::HashIndex::insert(const SMCApi::ObjectElement* element) {
+    if (table->makeKey(element))
+        table->elements.emplace(table->key, element);
+}
+
+void SMCApi::HashIndex::erase(const SMCApi::ObjectElement* element) {
+    if (!table->makeKey(element))
+        return;
+    auto range = table->elements.equal_range(table->key);
+    for (auto it = range.first; it != range.second; ++it) {
+        if (it->second == element) {
+            table->elements.erase(it);
+            return;
+        }
+    }
+}
+
+size_t SMCApi::HashIndex::size() const {
+    return table->elements.size();
+}
+
+std::vector<const SMCApi::ObjectElement*> SMCApi::HashIndex::find(const SMCApi::ObjectField* value) const {
+    std::vector<const ObjectElement*> result;
+    if (value == nullptr || value->getStoredValue() == nullptr)
+        return result;
+    std::string key;
+    appendKey(key, value);
+    auto range = table->elements.equal_range(key);
+    for (auto it = range.first; it != range.second; ++it)
+        result.push_back(it->second);
+    return result;
+}
+
+const SMCApi::ObjectElement* SMCApi::HashIndex::findFirst(const SMCApi::ObjectField* value) const {
+    if (value == nullptr || value->getStoredValue() == nullptr)
+        return nullptr;
+    std::string key;
+    appendKey(key, value);
+    return table->findFirst(key);
+}
+
+const SMCApi::ObjectElement* SMCApi::HashIndex::findFirst(long long int value) const {
+    std::string key;
+    appendInteger(key, value);
+    return table->findFirst(key);
+}
+
+const SMCApi::ObjectElement* SMCApi::HashIndex::findFirst(const std::wstring& value) const {
+    std::string text = toUtf8(value);
+    std::string key;
+    appendSized(key, KEY_STRING, text.data(), text.size());
+    return table->findFirst(key);
+}
+
+void SMCApi::HashIndex::added(SMCApi::ObjectType type, const void* value) {
+    if (type == OT_OBJECT_ELEMENT && value)
+        insert((const ObjectElement*)value);
+}
+
+void SMCApi::HashIndex::removed(SMCApi::ObjectType type, const void* value) {
+    if (type == OT_OBJECT_ELEMENT && value)
+        erase((const ObjectElement*)value);
+}
+
+void SMCApi::HashIndex::cleared() {
+    table->elements.clear();
+}
+
+void SMCApi::HashIndex::detached() {
+    array = nullptr;
+    table->elements.clear();
+}
+
+SMCApi::HashIndex::~HashIndex() {
+    if (array)
+        array->removeObserver(this);
+    delete table;
+}
+
+struct SMCApi::SortedIndex::Tree {
+    FieldPath path;
+    std::multimap<IndexKey, const ObjectElement*, IndexKeyLess> elements;
+
+    explicit Tree(const std::wstring& path) : path(splitPath(path), true) {
+    }
+
+    std::vector<const ObjectElement*> range(const IndexKey* from, const IndexKey* to, size_t limit) const {
+        std::vector<const ObjectElement*> result;
+        IndexKeyLess less;
+        for (auto it = from ? elements.lower_bound(*from) : elements.begin(); it != elements.end() && result.size() < limit; ++it) {
+            if (to && !less(it->first, *to))
+                break;
+            result.push_back(it->second);
+        }
+        return result;
+    }
+};
+
+SMCApi::SortedIndex::SortedIndex(SMCApi::ObjectArray* array, const std::wstring& path) : array(array), tree(new Tree(path)) {
+    for (size_t i = 0; i < array->size(); i++) {
+        const ObjectElement* element = array->tryGetObjectElement((int)i);
+        if (element)
+            insert(element);
+    }
+    array->addObserver(this);
+}
+
+void SMCApi::SortedIndex::insert(const SMCApi::ObjectElement* element) {
+    SortValue value = makeSortValue(tree->path.find(element));
+    if (value.kind != SORT_NULL)
+        tree->elements.emplace(makeIndexKey(value), element);
+}
+
+void SMCApi::SortedIndex::erase(const SMCApi::ObjectElement* element) {
+    SortValue value = makeSortValue(tree->path.find(element));
+    if (value.kind == SORT_NULL)
+        return;
+    auto range = tree->elements.equal_range(makeIndexKey(value));
+    for (auto it = range.first; it != range.second; ++it) {
+        if (it->second == element) {
+            tree->elements.erase(it);
+            return;
+        }
+    }
+}
+
+size_t SMCApi::SortedIndex::size() const {
+    return tree->elements.size();
+}
+
+std::vector<const SMCApi::ObjectElement*> SMCApi::SortedIndex::range(const SMCApi::ObjectField* from, const SMCApi::ObjectField* to,
+                                                                      size_t limit) const {
+    IndexKey fromKey = makeIndexKey(makeSortValue(from));
+    IndexKey toKey = makeIndexKey(makeSortValue(to));
+    return tree->range(from ? &fromKey : nullptr, to ? &toKey : nullptr, limit);
+}
+
+std::vector<const SMCApi::ObjectElement*> SMCApi::SortedIndex::range(double from, double to, size_t limit) const {
+    IndexKey fromKey = {{SORT_NUMBER, false, {0}, nullptr, 0}, std::string()};
+    fromKey.value.floatValue = from;
+    IndexKey toKey = fromKey;
+    toKey.value.floatValue = to;
+    return tree->range(&fromKey, &toKey, limit);
+}
+
+const SMCApi::ObjectElement* SMCApi::SortedIndex::first() const {
+    return tree->elements.empty() ? nullptr : tree->elements.begin()->second;
+}
+
+const SMCApi::ObjectElement* SMCApi::SortedIndex::last() const {
+    return tree->elements.empty() ? nullptr : tree->elements.rbegin()->second;
+}
+
+void SMCApi::SortedIndex::added(SMCApi::ObjectType type, const void* value) {
+    if (type == OT_OBJECT_ELEMENT && value)
+        insert((const ObjectElement*)value);
+}
+
+void SMCApi::SortedIndex::removed(SMCApi::ObjectType type, const void* value) {
+    if (type == OT_OBJECT_ELEMENT && value)
+        erase((const ObjectElement*)value);
+}
+
+void SMCApi::SortedIndex::cleared() {
+    tree->elements.clear();
+}
+
+void SMCApi::SortedIndex::detached() {
+    array = nullptr;
+    tree->elements.clear();
+}
+
+SMCApi::SortedIndex::~SortedIndex() {
+    if (array)
+        array->removeObserver(this);
+    delete tree;
+}
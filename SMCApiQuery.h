@@ -0,0 +1,492 @@
+/*
+Library (provider c++), is a part of the platform Shelf MK (Shell for modular structures, SMC platform).
+The author and copyright holder of the software package (application) Shelf MK (Shell for modular structures, SMC platform) is Ulyanov Nikolay Vladimirovich (ulianownv@mail.ru).
+The following are prohibited: changing and distributing the program code, selling/reselling it, as well as other actions and rights not expressly permitted.
+*/
+
+#include "SMCApi.h"
+#include <vector>
+
+#ifndef SMCMODULEDEFINITIONPROVIDER_SMCAPIQUERY_H
+#define SMCMODULEDEFINITIONPROVIDER_SMCAPIQUERY_H
+
+namespace SMCApi {
+    /**
+     * statistics of numeric values: count, sum, min, max, mean, variance
+     * values are reduced in blocks (SSE2 where available), blocks are merged with pairwise update of variance
+     * NaN values give not defined min and max
+     *
+     * @version 1.0.0
+     */
+    class CLASS_DECLSPEC Aggregation {
+    private:
+        size_t countValues;
+        double sumValue;
+        double minValue;
+        double maxValue;
+        /**
+         * sum of squared differences from mean
+         */
+        double m2;
+
+    public:
+        Aggregation();
+
+        void add(double value);
+
+        /**
+         * add values of contiguous array
+         *
+         * @param values                values
+         * @param count                 count of values
+         */
+        void add(const double* values, size_t count);
+
+        /**
+         * add all values of other aggregation (example: result of other thread)
+         *
+         * @param other                 Aggregation
+         */
+        void merge(const Aggregation& other);
+
+        /**
+         * count of values, null values and values of other types are not counted
+         *
+         * @return size_t
+         */
+        size_t count() const;
+
+        double sum() const;
+
+        /**
+         * @return min value or 0 if empty
+         */
+        double min() const;
+
+        /**
+         * @return max value or 0 if empty
+         */
+        double max() const;
+
+        /**
+         * @return mean value or 0 if empty
+         */
+        double mean() const;
+
+        /**
+         * population variance
+         *
+         * @return variance or 0 if empty
+         */
+        double variance() const;
+    };
+
+    /**
+     * aggregate numbers of array, items of other types are skipped
+     *
+     * @param array                 ObjectArray
+     * @return Aggregation
+     */
+    CLASS_DECLSPEC Aggregation aggregate(const ObjectArray* array);
+
+    /**
+     * aggregate numeric field of elements of array
+     * names of path are resolved in SymbolTable once, position of field is reused while elements have the same order of fields
+     * elements without field, with null or not numeric value are skipped
+     *
+     * @param array                 ObjectArray with elements
+     * @param path                  names of fields, all except last should be fields with ObjectElement
+     * @return Aggregation
+     */
+    CLASS_DECLSPEC Aggregation aggregate(const ObjectArray* array, const std::vector<std::wstring>& path);
+
+    /**
+     * aggregate numeric field of elements of array
+     *
+     * @param array                 ObjectArray with elements
+     * @param path                  names of fields separated by '.' (example: L"order.price")
+     * @return Aggregation
+     */
+    CLASS_DECLSPEC Aggregation aggregate(const ObjectArray* array, const std::wstring& path);
+
+    /**
+     * function of aggregate of group
+     */
+    enum AggregateFunction {
+        /**
+         * count of records (empty path) or of numeric values of field, Long
+         */
+        AF_COUNT,
+        AF_SUM,
+        AF_MIN,
+        AF_MAX,
+        AF_MEAN,
+        /**
+         * population variance
+         */
+        AF_VARIANCE
+    };
+
+    /**
+     * group by and hash aggregation over array of elements
+     * example:
+     *  GroupBy groupBy;
+     *  groupBy.key(L"region").aggregate(AF_COUNT, L"", L"orders").aggregate(AF_SUM, L"order.price", L"total");
+     *  ObjectArray* result = groupBy.execute(orders, 0);
+     * records are split between threads, every thread groups own records in open addressing tables (one per partition of hash),
+     * after it partitions are merged in parallel, without locks and without copy of records
+     * keys are compared by type and value: integer numbers (Byte - Long), float numbers, strings (UTF-8 bytes), bool, bytes, null
+     * (field is not found or has null value), big numbers by text; keys with ObjectArray or ObjectElement are not supported
+     *
+     * @version 1.0.0
+     */
+    class CLASS_DECLSPEC GroupBy {
+    private:
+        struct Spec {
+            AggregateFunction function;
+            std::wstring path;
+            std::wstring name;
+        };
+
+        std::vector<std::wstring> keys;
+        std::vector<Spec> specs;
+
+    public:
+        /**
+         * add key field, key fields of result have name equal to path
+         *
+         * @param path                  names of fields separated by '.'
+         * @return this
+         */
+        GroupBy& key(const std::wstring& path);
+
+        /**
+         * add aggregate, aggregate of group without numeric values is null (except AF_COUNT)
+         *
+         * @param function              AggregateFunction
+         * @param path                  names of fields separated by '.', for AF_COUNT may be empty
+         * @param name                  name of field in result
+         * @return this
+         */
+        GroupBy& aggregate(AggregateFunction function, const std::wstring& path, const std::wstring& name);
+
+        /**
+         * group records
+         *
+         * @param array                 ObjectArray with elements, items of other types are skipped
+         * @param threads               count of threads, 0 - count of cores (small arrays use less threads)
+         * @return ObjectArray with one element for each group in order of first record of group, caller owns it
+         */
+        ObjectArray* execute(const ObjectArray* array, size_t threads = 1) const;
+    };
+
+    /**
+     * sort and top-K of array by field paths
+     * example:
+     *  OrderBy().key(L"order.price", true).key(L"id").sort(orders, 0);
+     * values of keys are extracted once in contiguous buffer, items are sorted by it and array is reordered without copy of values
+     * sort is stable: items with equal keys keep order
+     * values are ordered by type: numbers (integers are compared exactly, others as double), strings (by UTF-8 bytes), bool, bytes,
+     * null (field is not found, has null value or is ObjectArray/ObjectElement) is last also in descending order
+     *
+     * @version 1.0.0
+     */
+    class CLASS_DECLSPEC OrderBy {
+    private:
+        struct Key {
+            std::wstring path;
+            bool descending;
+        };
+
+        std::vector<Key> keys;
+
+    public:
+        /**
+         * add key, items are compared by next key if values of previous keys are equal
+         *
+         * @param path                  names of fields separated by '.', empty - item itself (array of simple values)
+         * @param descending            true for descending order
+         * @return this
+         */
+        OrderBy& key(const std::wstring& path, bool descending = false);
+
+        /**
+         * sorted ids of items, array is not changed
+         *
+         * @param array                 ObjectArray
+         * @param limit                 max count of ids (top-K)
+         * @param threads               count of threads, 0 - count of cores (small arrays use less threads)
+         * @return ids of items
+         */
+        std::vector<size_t> order(const ObjectArray* array, size_t limit = (size_t)-1, size_t threads = 1) const;
+
+        /**
+         * sort array
+         *
+         * @param array                 ObjectArray
+         * @param threads               count of threads, 0 - count of cores
+         */
+        void sort(ObjectArray* array, size_t threads = 1) const;
+
+        /**
+         * keep only first count items in sorted order, other items are removed
+         *
+         * @param array                 ObjectArray
+         * @param count                 count of items
+         * @param threads               count of threads, 0 - count of cores
+         */
+        void top(ObjectArray* array, size_t count, size_t threads = 1) const;
+    };
+
+    enum JoinType {
+        /**
+         * only items with match
+         */
+        JT_INNER,
+        /**
+         * all items of probe array, without match - build id NO_MATCH or null field
+         */
+        JT_LEFT
+    };
+
+    /**
+     * hash join of arrays of elements on key field paths
+     * hash table is built once for reference (build) array and is used for any count of probe arrays (example: in each process call)
+     * keys are compared as in GroupBy, items with null key never match
+     * example:
+     *  HashJoin customers(reference, {L"id"});                       // once
+     *  customers.enrich(orders, {L"customerId"}, L"customer", JT_LEFT); // for each message
+     *
+     * @version 1.0.0
+     */
+    class CLASS_DECLSPEC HashJoin {
+    private:
+        struct Index;
+
+        const ObjectArray* array;
+        Index* index;
+        size_t countKeys;
+
+    public:
+        /**
+         * build id of item of probe array without match (JT_LEFT)
+         */
+        static const size_t NO_MATCH = (size_t)-1;
+
+        /**
+         * build hash table
+         *
+         * @param array                 reference array of elements, it must live and must not be changed while HashJoin is used
+         * @param keys                  key field paths (names separated by '.')
+         */
+        HashJoin(const ObjectArray* array, const std::vector<std::wstring>& keys);
+
+        HashJoin(const HashJoin&) = delete;
+
+        HashJoin& operator=(const HashJoin&) = delete;
+
+        /**
+         * count of distinct keys
+         *
+         * @return size_t
+         */
+        size_t size() const;
+
+        /**
+         * pairs of matched items, values are not copied
+         * pairs are ordered by probe id, items of reference array with the same key - in order of array
+         *
+         * @param probe                 array of elements
+         * @param keys                  key field paths of probe elements, the same count as keys of reference array
+         * @param type                  JoinType
+         * @param threads               count of threads, 0 - count of cores (small arrays use less threads)
+         * @return pairs (probe id, build id)
+         */
+        std::vector<std::pair<size_t, size_t>> match(const ObjectArray* probe, const std::vector<std::wstring>& keys, JoinType type,
+                                                     size_t threads = 1) const;
+
+        /**
+         * add to each element of probe array field with copy of first matched element of reference array (bytes are shared)
+         * elements of probe array are not copied, for JT_INNER items without match are removed, for JT_LEFT field is null
+         * cost: each matched probe element gets own deep copy of reference element (one allocation per field, strings and nested
+         * elements are copied), so for many probe elements with the same key use match and read reference array by build id
+         *
+         * @param probe                 array of elements, changed
+         * @param keys                  key field paths of probe elements
+         * @param name                  name of added field (existing field with the name is replaced)
+         * @param type                  JoinType
+         * @param threads               count of threads for match
+         */
+        void enrich(ObjectArray* probe, const std::vector<std::wstring>& keys, const std::wstring& name, JoinType type,
+                    size_t threads = 1) const;
+
+        ~HashJoin();
+    };
+
+    /**
+     * index of array of elements for equality lookups by value of field path, O(1)
+     * index is updated on add and remove of items of array (ObjectArrayObserver), elements with null value are not indexed
+     * values of indexed fields must not be changed while element is in array (remove it, change and add again)
+     * lookups can run in parallel, but not in parallel with changes of array
+     * keys are compared as in GroupBy
+     *
+     * @version 1.0.0
+     */
+    class CLASS_DECLSPEC HashIndex : public ObjectArrayObserver {
+    private:
+        struct Table;
+
+        ObjectArray* array;
+        Table* table;
+
+        void insert(const ObjectElement* element);
+
+        void erase(const ObjectElement* element);
+
+    public:
+        /**
+         * index all elements of array and observe it
+         *
+         * @param array                 array, index is removed from it on delete
+         * @param path                  names of fields separated by '.'
+         */
+        HashIndex(ObjectArray* array, const std::wstring& path);
+
+        HashIndex(const HashIndex&) = delete;
+
+        HashIndex& operator=(const HashIndex&) = delete;
+
+        /**
+         * count of indexed elements
+         *
+         * @return size_t
+         */
+        size_t size() const;
+
+        /**
+         * elements with value
+         *
+         * @param value                 field with value (name is not used)
+         * @return elements in any order
+         */
+        std::vector<const ObjectElement*> find(const ObjectField* value) const;
+
+        /**
+         * any element with value
+         *
+         * @param value                 field with value (name is not used)
+         * @return element or null
+         */
+        const ObjectElement* findFirst(const ObjectField* value) const;
+
+        /**
+         * any element with integer number value (Byte - Long)
+         *
+         * @param value                 value
+         * @return element or null
+         */
+        const ObjectElement* findFirst(long long int value) const;
+
+        /**
+         * any element with string value
+         *
+         * @param value                 value
+         * @return element or null
+         */
+        const ObjectElement* findFirst(const std::wstring& value) const;
+
+        void added(ObjectType type, const void* value) override;
+
+        void removed(ObjectType type, const void* value) override;
+
+        void cleared() override;
+
+        void detached() override;
+
+        ~HashIndex() override;
+    };
+
+    /**
+     * index of array of elements for range lookups by value of field path, O(log n)
+     * values are ordered as in OrderBy, index is updated as HashIndex
+     *
+     * @version 1.0.0
+     */
+    class CLASS_DECLSPEC SortedIndex : public ObjectArrayObserver {
+    private:
+        struct Tree;
+
+        ObjectArray* array;
+        Tree* tree;
+
+        void insert(const ObjectElement* element);
+
+        void erase(const ObjectElement* element);
+
+    public:
+        /**
+         * index all elements of array and observe it
+         *
+         * @param array                 array, index is removed from it on delete
+         * @param path                  names of fields separated by '.'
+         */
+        SortedIndex(ObjectArray* array, const std::wstring& path);
+
+        SortedIndex(const SortedIndex&) = delete;
+
+        SortedIndex& operator=(const SortedIndex&) = delete;
+
+        /**
+         * count of indexed elements
+         *
+         * @return size_t
+         */
+        size_t size() const;
+
+        /**
+         * elements with value in range, in order of value (elements with equal values - in order of add)
+         *
+         * @param from                  field with first value (included), null - from first element
+         * @param to                    field with end value (not included), null - to last element
+         * @param limit                 max count of elements
+         * @return elements
+         */
+        std::vector<const ObjectElement*> range(const ObjectField* from, const ObjectField* to, size_t limit = (size_t)-1) const;
+
+        /**
+         * elements with number value in range [from, to)
+         *
+         * @param from                  first value (included)
+         * @param to                    end value (not included)
+         * @param limit                 max count of elements
+         * @return elements
+         */
+        std::vector<const ObjectElement*> range(double from, double to, size_t limit = (size_t)-1) const;
+
+        /**
+         * element with min value
+         *
+         * @return element or null if empty
+         */
+        const ObjectElement* first() const;
+
+        /**
+         * element with max value
+         *
+         * @return element or null if empty
+         */
+        const ObjectElement* last() const;
+
+        void added(ObjectType type, const void* value) override;
+
+        void removed(ObjectType type, const void* value) override;
+
+        void cleared() override;
+
+        void detached() override;
+
+        ~SortedIndex() override;
+    };
+}
+
+#endif //SMCMODULEDEFINITIONPROVIDER_SMCAPIQUERY_H
@@ -0,0 +1,1223 @@
+/*
+Library (provider c++), is a part of the platform Shelf MK (Shell for modular structures, SMC platform).
+The author and copyright holder of the software package (application) Shelf MK (Shell for modular structures, SMC platform) is Ulyanov Nikolay Vladimirovich (ulianownv@mail.ru).
+The following are prohibited: changing and distributing the program code, selling/reselling it, as well as other actions and rights not expressly permitted.
+*/
+
+#include "SMCApiStream.h"
+#include "SMCApiValue.h"
+#include "SMCApiFieldPath.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <deque>
+#include <limits>
+
+namespace {
+    /**
+     * max size of block of sorted values, insert and erase move at most 2 * SORTED_BLOCK_SIZE values
+     */
+    const size_t SORTED_BLOCK_SIZE = 256;
+
+    /**
+     * multiset of values with select by rank, values are kept in sorted blocks
+     */
+    class SortedValues {
+    private:
+        std::vector<std::vector<double>> blocks;
+
+        /**
+         * first block with last value not less than value, last block if all are less
+         */
+        size_t findBlock(double value) const {
+            auto it = std::lower_bound(blocks.begin(), blocks.end(), value, [](const std::vector<double>& block, double value) {
+                return block.back() < value;
+            });
+            return it == blocks.end() ? blocks.size() - 1 : (size_t)(it - blocks.begin());
+        }
+
+    public:
+        void insert(double value) {
+            if (blocks.empty()) {
+                blocks.emplace_back();
+                blocks.back().reserve(SORTED_BLOCK_SIZE * 2);
+                blocks.back().push_back(value);
+                return;
+            }
+            size_t id = findBlock(value);
+            std::vector<double>& block = blocks[id];
+            block.insert(std::upper_bound(block.begin(), block.end(), value), value);
+            if (block.size() >= SORTED_BLOCK_SIZE * 2) {
+                std::vector<double> second;
+                second.reserve(SORTED_BLOCK_SIZE * 2);
+                second.assign(block.begin() + SORTED_BLOCK_SIZE, block.end());
+                block.resize(SORTED_BLOCK_SIZE);
+                blocks.insert(blocks.begin() + id + 1, std::move(second));
+            }
+        }
+
+        void erase(double value) {
+            if (blocks.empty())
+                return;
+            size_t id = findBlock(value);
+            std::vector<double>& block = blocks[id];
+            auto it = std::lower_bound(block.begin(), block.end(), value);
+            if (it == block.end() || *it != value)
+                return;
+            block.erase(it);
+            if (block.empty())
+                blocks.erase(blocks.begin() + id);
+        }
+
+        /**
+         * value by rank
+         *
+         * @param rank                  from 0, less than count of values
+         */
+        double select(size_t rank) const {
+            for (auto& block : blocks) {
+                if (rank < block.size())
+                    return block[rank];
+                rank -= block.size();
+            }
+            return 0;
+        }
+
+        void clear() {
+            blocks.clear();
+        }
+    };
+
+    struct WindowValue {
+        long long int date;
+        double value;
+    };
+
+    struct Extremum {
+        unsigned long long sequence;
+        double value;
+    };
+
+    bool isNumber(SMCApi::ValueType type) {
+        return type >= SMCApi::VT_BYTE && type <= SMCApi::VT_BIG_DECIMAL;
+    }
+}
+
+struct SMCApi::SlidingWindow::State {
+    WindowType type;
+    long long int size;
+    std::deque<WindowValue> values;
+    /**
+     * sequence of first value in values
+     */
+    unsigned long long firstSequence;
+    /**
+     * values with increasing sequence and increasing (min) or decreasing (max) value
+     */
+    std::deque<Extremum> minValues;
+    std::deque<Extremum> maxValues;
+    /**
+     * sum with compensation of lost low bits (Neumaier), values are added and subtracted without drift
+     */
+    double sumValue;
+    double sumCompensation;
+    SortedValues* sorted;
+    long long int lastDate;
+    /**
+     * count of values added with lastDate, for skip of repeated messages
+     */
+    size_t countLastDate;
+
+    State(WindowType type, long long int size, bool percentiles) : type(type), size(size), firstSequence(0), sumValue(0), sumCompensation(0),
+                                                                   sorted(percentiles ? new SortedValues() : nullptr), lastDate(0), countLastDate(0) {
+    }
+
+    /**
+     * count message with date as seen (also not numeric)
+     */
+    void markDate(long long int date) {
+        if (countLastDate == 0 || date > lastDate) {
+            lastDate = date;
+            countLastDate = 1;
+        } else if (date == lastDate) {
+            countLastDate++;
+        }
+    }
+
+    void addSum(double value) {
+        double sum = sumValue + value;
+        if (std::fabs(sumValue) >= std::fabs(value))
+            sumCompensation += (sumValue - sum) + value;
+        else
+            sumCompensation += (value - sum) + sumValue;
+        sumValue = sum;
+    }
+
+    ~State() {
+        delete sorted;
+    }
+};
+
+SMCApi::SlidingWindow::SlidingWindow(SMCApi::WindowType type, long long int size, bool percentiles) {
+    if (size < 1)
+        throw ModuleException(L"wrong size");
+    state = new State(type, size, percentiles);
+}
+
+void SMCApi::SlidingWindow::evict() {
+    auto& values = state->values;
+    while (!values.empty()) {
+        if (state->type == WT_COUNT) {
+            if ((long long int)values.size() <= state->size)
+                break;
+        } else if (values.front().date > state->lastDate - state->size) {
+            break;
+        }
+        double value = values.front().value;
+        state->addSum(-value);
+        if (state->sorted)
+            state->sorted->erase(value);
+        if (state->minValues.front().sequence == state->firstSequence)
+            state->minValues.pop_front();
+        if (state->maxValues.front().sequence == state->firstSequence)
+            state->maxValues.pop_front();
+        values.pop_front();
+        state->firstSequence++;
+    }
+    if (values.empty()) {
+        state->sumValue = 0;
+        state->sumCompensation = 0;
+    }
+}
+
+void SMCApi::SlidingWindow::add(long long int date, double value) {
+    state->markDate(date);
+    if (std::isnan(value))
+        return;
+    unsigned long long sequence = state->firstSequence + state->values.size();
+    state->values.push_back({date, value});
+    state->addSum(value);
+    if (state->sorted)
+        state->sorted->insert(value);
+    while (!state->minValues.empty() && state->minValues.back().value >= value)
+        state->minValues.pop_back();
+    state->minValues.push_back({sequence, value});
+    while (!state->maxValues.empty() && state->maxValues.back().value <= value)
+        state->maxValues.pop_back();
+    state->maxValues.push_back({sequence, value});
+    evict();
+}
+
+bool SMCApi::SlidingWindow::add(SMCApi::IMessage* message) {
+    if (message == nullptr)
+        return false;
+    Number* number = isNumber(message->getType()) ? message->getValueNumber() : nullptr;
+    if (number == nullptr) {
+        state->markDate(message->getDate());
+        return false;
+    }
+    add(message->getDate(), number->doubleValue());
+    return true;
+}
+
+size_t SMCApi::SlidingWindow::update(const std::vector<SMCApi::IMessage*>* messages) {
+    if (messages == nullptr)
+        return 0;
+    bool started = state->countLastDate == 0;
+    long long int date = state->lastDate;
+    size_t skip = state->countLastDate;
+    size_t count = 0;
+    for (IMessage* message : *messages) {
+        if (message == nullptr)
+            continue;
+        if (!started) {
+            long long int messageDate = message->getDate();
+            if (messageDate < date)
+                continue;
+            if (messageDate == date && skip > 0) {
+                skip--;
+                continue;
+            }
+            started = true;
+        }
+        if (add(message))
+            count++;
+    }
+    return count;
+}
+
+size_t SMCApi::SlidingWindow::update(const std::vector<SMCApi::IAction*>* actions) {
+    if (actions == nullptr)
+        return 0;
+    std::vector<IMessage*> messages;
+    for (IAction* action : *actions) {
+        std::vector<IMessage*>* actionMessages = action ? action->getMessages() : nullptr;
+        if (actionMessages)
+            messages.insert(messages.end(), actionMessages->begin(), actionMessages->end());
+    }
+    return update(&messages);
+}
+
+void SMCApi::SlidingWindow::clear() {
+    state->firstSequence += state->values.size();
+    state->values.clear();
+    state->minValues.clear();
+    state->maxValues.clear();
+    state->sumValue = 0;
+    state->sumCompensation = 0;
+    if (state->sorted)
+        state->sorted->clear();
+}
+
+size_t SMCApi::SlidingWindow::count() const {
+    return state->values.size();
+}
+
+double SMCApi::SlidingWindow::sum() const {
+    return state->sumValue + state->sumCompensation;
+}
+
+double SMCApi::SlidingWindow::min() const {
+    return state->minValues.empty() ? 0 : state->minValues.front().value;
+}
+
+double SMCApi::SlidingWindow::max() const {
+    return state->maxValues.empty() ? 0 : state->maxValues.front().value;
+}
+
+double SMCApi::SlidingWindow::mean() const {
+    return state->values.empty() ? 0 : sum() / (double)state->values.size();
+}
+
+double SMCApi::SlidingWindow::percentile(double percentile) const {
+    if (state->sorted == nullptr)
+        throw ModuleException(L"percentiles are not kept");
+    size_t count = state->values.size();
+    if (count == 0)
+        return 0;
+    double rank = std::ceil(std::max(0.0, std::min(100.0, percentile)) / 100.0 * (double)count);
+    return state->sorted->select(rank < 1 ? 0 : (size_t)rank - 1);
+}
+
+long long int SMCApi::SlidingWindow::lastDate() const {
+    return state->lastDate;
+}
+
+SMCApi::SlidingWindow::~SlidingWindow() {
+    delete state;
+}
+
+namespace {
+    enum SketchTag {
+        TAG_INTEGER = 1,
+        TAG_FLOAT,
+        TAG_STRING,
+        TAG_BYTES,
+        TAG_BOOLEAN
+    };
+
+    /**
+     * first bytes of serialized sketches
+     */
+    const signed char HYPER_LOG_LOG_FORMAT = 'H';
+    const signed char COUNT_MIN_SKETCH_FORMAT = 'C';
+    const signed char T_DIGEST_FORMAT = 'T';
+    const signed char SKETCH_VERSION = 1;
+
+    const double PI = 3.14159265358979323846;
+
+    unsigned long long mix(unsigned long long hash) {
+        hash ^= hash >> 33;
+        hash *= 0xFF51AFD7ED558CCDULL;
+        hash ^= hash >> 33;
+        hash *= 0xC4CEB9FE1A85EC53ULL;
+        return hash ^ (hash >> 33);
+    }
+
+    /**
+     * little endian number of size bytes, so hashes and serialized sketches are the same on all platforms
+     */
+    unsigned long long readFixed(const void* data, size_t size) {
+        auto bytes = (const unsigned char*)data;
+        unsigned long long value = 0;
+        for (size_t i = 0; i < size; i++)
+            value |= (unsigned long long)bytes[i] << (i * 8);
+        return value;
+    }
+
+    unsigned long long hashBytes(SketchTag tag, const void* data, size_t size) {
+        auto bytes = (const char*)data;
+        unsigned long long hash = 0x9E3779B97F4A7C15ULL ^ ((unsigned long long)tag << 56) ^ size;
+        size_t i = 0;
+        for (; i + 8 <= size; i += 8)
+            hash = (hash ^ mix(readFixed(bytes + i, 8))) * 0x9FB21C651E98DF25ULL;
+        return mix(hash ^ readFixed(bytes + i, size - i));
+    }
+
+    /**
+     * hash of 8 bytes of number in little endian
+     */
+    unsigned long long hashFixed(SketchTag tag, unsigned long long value) {
+        unsigned char bytes[8];
+        for (size_t i = 0; i < 8; i++)
+            bytes[i] = (unsigned char)(value >> (i * 8));
+        return hashBytes(tag, bytes, sizeof(bytes));
+    }
+
+    unsigned long long hashNumber(const SMCApi::Number* value) {
+        auto number = const_cast<SMCApi::Number*>(value);
+        switch (number->getType()) {
+        case SMCApi::NT_BYTE:
+        case SMCApi::NT_SHORT:
+        case SMCApi::NT_INTEGER:
+        case SMCApi::NT_LONG:
+            return SMCApi::sketchHash(number->longValue());
+        default:
+            return SMCApi::sketchHash(number->doubleValue());
+        }
+    }
+
+    int leadingZeros(unsigned long long value) {
+#if defined(__GNUC__) || defined(__clang__)
+        return value == 0 ? 64 : __builtin_clzll(value);
+#else
+        int count = 0;
+        for (unsigned long long bit = 1ULL << 63; bit != 0 && (value & bit) == 0; bit >>= 1)
+            count++;
+        return count;
+#endif
+    }
+
+    /**
+     * call consumer for not null values of items of array (path is empty) or of field of elements
+     */
+    template<typename Consumer>
+    void forEachValue(const SMCApi::ObjectArray* array, const std::wstring& path, Consumer& consumer) {
+        if (path.empty()) {
+            array->visit([&](int, const auto* value, size_t) {
+                if (value)
+                    consumer(value);
+            });
+            return;
+        }
+        SMCApi::internal::FieldPath fieldPath(SMCApi::internal::splitPath(path));
+        if (!fieldPath.isValid())
+            return;
+        for (size_t i = 0; i < array->size(); i++) {
+            const SMCApi::ObjectElement* element = array->tryGetObjectElement((int)i);
+            const SMCApi::ObjectField* field = element ? fieldPath.find(element) : nullptr;
+            if (field) {
+                field->visit([&](const auto* value, size_t) {
+                    if (value)
+                        consumer(value);
+                });
+            }
+        }
+    }
+
+    template<typename Sketch>
+    struct HashConsumer {
+        Sketch& sketch;
+
+        void operator()(const SMCApi::Number* value) {
+            sketch.addHash(hashNumber(value));
+        }
+
+        void operator()(const SMCApi::Utf8String* value) {
+            sketch.addHash(hashBytes(TAG_STRING, value->getData(), value->getSize()));
+        }
+
+        void operator()(const SMCApi::ByteBuffer* value) {
+            sketch.addHash(hashBytes(TAG_BYTES, value->getData(), value->getSize()));
+        }
+
+        void operator()(const bool* value) {
+            sketch.addHash(hashBytes(TAG_BOOLEAN, value, 1));
+        }
+
+        template<typename T>
+        void operator()(const T*) {
+        }
+    };
+
+    struct NumberConsumer {
+        SMCApi::TDigest& digest;
+
+        void operator()(const SMCApi::Number* value) {
+            digest.add(const_cast<SMCApi::Number*>(value)->doubleValue());
+        }
+
+        template<typename T>
+        void operator()(const T*) {
+        }
+    };
+
+    class ByteWriter {
+    private:
+        std::vector<signed char> data;
+
+    public:
+        ByteWriter(signed char format, size_t size) {
+            data.reserve(size + 2);
+            data.push_back(format);
+            data.push_back(SKETCH_VERSION);
+        }
+
+        /**
+         * number in little endian
+         */
+        void writeFixed(unsigned long long value, size_t size) {
+            for (size_t i = 0; i < size; i++)
+                data.push_back((signed char)(value >> (i * 8)));
+        }
+
+        void write(unsigned char value) {
+            data.push_back((signed char)value);
+        }
+
+        void write(unsigned int value) {
+            writeFixed(value, 4);
+        }
+
+        void write(unsigned long long value) {
+            writeFixed(value, 8);
+        }
+
+        void write(double value) {
+            unsigned long long bits;
+            memcpy(&bits, &value, sizeof(bits));
+            writeFixed(bits, 8);
+        }
+
+        void write(const void* value, size_t size) {
+            data.insert(data.end(), (const signed char*)value, (const signed char*)value + size);
+        }
+
+        SMCApi::ByteBuffer toBytes() {
+            return SMCApi::ByteBuffer(std::move(data));
+        }
+    };
+
+    /**
+     * reader of serialized sketch, throws ModuleException on wrong format or size
+     */
+    class ByteReader {
+    private:
+        const signed char* data;
+        size_t size;
+        size_t position;
+
+    public:
+        ByteReader(const signed char* data, size_t size, signed char format) : data(data), size(size), position(2) {
+            if (data == nullptr || size < 2 || data[0] != format || data[1] != SKETCH_VERSION)
+                throw SMCApi::ModuleException(L"wrong data");
+        }
+
+        unsigned char readByte() {
+            return (unsigned char)*read(1);
+        }
+
+        unsigned int readInt() {
+            return (unsigned int)readFixed(read(4), 4);
+        }
+
+        unsigned long long readLong() {
+            return readFixed(read(8), 8);
+        }
+
+        double readDouble() {
+            unsigned long long bits = readLong();
+            double value;
+            memcpy(&value, &bits, sizeof(value));
+            return value;
+        }
+
+        const signed char* read(size_t count) {
+            if (count > size - position)
+                throw SMCApi::ModuleException(L"wrong data");
+            const signed char* result = data + position;
+            position += count;
+            return result;
+        }
+
+        size_t remaining() const {
+            return size - position;
+        }
+    };
+}
+
+unsigned long long SMCApi::sketchHash(long long int value) {
+    return hashFixed(TAG_INTEGER, (unsigned long long)value);
+}
+
+unsigned long long SMCApi::sketchHash(double value) {
+    if (value >= -9223372036854775808.0 && value < 9223372036854775808.0 && value == std::floor(value))
+        return sketchHash((long long int)value);
+    if (std::isnan(value))
+        value = std::numeric_limits<double>::quiet_NaN();
+    unsigned long long bits;
+    memcpy(&bits, &value, sizeof(bits));
+    return hashFixed(TAG_FLOAT, bits);
+}
+
+unsigned long long SMCApi::sketchHash(const std::wstring& value) {
+    std::string text = toUtf8(value);
+    return hashBytes(TAG_STRING, text.data(), text.size());
+}
+
+bool SMCApi::sketchHash(SMCApi::IValue* value, unsigned long long& hash) {
+    if (value == nullptr)
+        return false;
+    switch (value->getType()) {
+    case VT_STRING: {
+        std::wstring* text = value->getValueString();
+        if (text == nullptr)
+            return false;
+        hash = sketchHash(*text);
+        return true;
+    }
+    case VT_BYTES: {
+        // Value gives shared bytes without copy (getValueBytes copies them for write)
+        if (auto* typed = dynamic_cast<Value*>(value)) {
+            const ByteBuffer* buffer = typed->getValueByteBuffer();
+            if (buffer->getData() == nullptr)
+                return false;
+            hash = hashBytes(TAG_BYTES, buffer->getData(), buffer->getSize());
+            return true;
+        }
+        signed char* bytes = value->getValueBytes();
+        if (bytes == nullptr)
+            return false;
+        hash = hashBytes(TAG_BYTES, bytes, value->getBytesCount());
+        return true;
+    }
+    case VT_BOOLEAN: {
+        bool flag = value->getValueBoolean();
+        hash = hashBytes(TAG_BOOLEAN, &flag, 1);
+        return true;
+    }
+    case VT_OBJECT_ARRAY:
+        return false;
+    default: {
+        Number* number = value->getValueNumber();
+        if (number == nullptr)
+            return false;
+        hash = hashNumber(number);
+        return true;
+    }
+    }
+}
+
+SMCApi::HyperLogLog::HyperLogLog(int precision) : precision(precision) {
+    if (precision < 4 || precision > 18)
+        throw ModuleException(L"wrong precision");
+    registers.assign((size_t)1 << precision, 0);
+}
+
+void SMCApi::HyperLogLog::addHash(unsigned long long hash) {
+    size_t id = (size_t)(hash >> (64 - precision));
+    auto rank = (unsigned char)(leadingZeros((hash << precision) | (1ULL << (precision - 1))) + 1);
+    if (registers[id] < rank)
+        registers[id] = rank;
+}
+
+bool SMCApi::HyperLogLog::add(SMCApi::IValue* value) {
+    unsigned long long hash;
+    if (!sketchHash(value, hash))
+        return false;
+    addHash(hash);
+    return true;
+}
+
+void SMCApi::HyperLogLog::add(const SMCApi::ObjectArray* array, const std::wstring& path) {
+    HashConsumer<HyperLogLog> consumer{*this};
+    forEachValue(array, path, consumer);
+}
+
+void SMCApi::HyperLogLog::merge(const SMCApi::HyperLogLog& other) {
+    if (other.precision != precision)
+        throw ModuleException(L"wrong precision");
+    for (size_t i = 0; i < registers.size(); i++)
+        registers[i] = std::max(registers[i], other.registers[i]);
+}
+
+double SMCApi::HyperLogLog::estimate() const {
+    auto count = (double)registers.size();
+    double alpha = registers.size() == 16 ? 0.673 : registers.size() == 32 ? 0.697 : registers.size() == 64 ? 0.709 : 0.7213 / (1 + 1.079 / count);
+    double sum = 0;
+    size_t zeros = 0;
+    for (unsigned char value : registers) {
+        sum += std::ldexp(1.0, -(int)value);
+        zeros += value == 0;
+    }
+    double result = alpha * count * count / sum;
+    if (result <= 2.5 * count && zeros > 0)
+        result = count * std::log(count / (double)zeros);
+    return result;
+}
+
+int SMCApi::HyperLogLog::getPrecision() const {
+    return precision;
+}
+
+SMCApi::ByteBuffer SMCApi::HyperLogLog::toBytes() const {
+    ByteWriter writer(HYPER_LOG_LOG_FORMAT, registers.size() + 1);
+    writer.write((unsigned char)precision);
+    writer.write(registers.data(), registers.size());
+    return writer.toBytes();
+}
+
+SMCApi::HyperLogLog SMCApi::HyperLogLog::fromBytes(const signed char* data, size_t size) {
+    ByteReader reader(data, size, HYPER_LOG_LOG_FORMAT);
+    auto precision = (int)reader.readByte();
+    if (precision < 4 || precision > 18)
+        throw ModuleException(L"wrong data");
+    HyperLogLog result(precision);
+    memcpy(result.registers.data(), reader.read(result.registers.size()), result.registers.size());
+    for (unsigned char value : result.registers) {
+        if (value > 65 - precision)
+            throw ModuleException(L"wrong data");
+    }
+    return result;
+}
+
+SMCApi::CountMinSketch::CountMinSketch(size_t width, size_t depth) : width(width), depth(depth), totalCount(0) {
+    if (width < 1 || depth < 1 || depth > 16)
+        throw ModuleException(L"wrong size");
+    counts.assign(width * depth, 0);
+}
+
+void SMCApi::CountMinSketch::addHash(unsigned long long hash, unsigned long long count) {
+    unsigned long long step = mix(hash) | 1;
+    for (size_t row = 0; row < depth; row++)
+        counts[row * width + (size_t)((hash + row * step) % width)] += count;
+    totalCount += count;
+}
+
+bool SMCApi::CountMinSketch::add(SMCApi::IValue* value, unsigned long long count) {
+    unsigned long long hash;
+    if (!sketchHash(value, hash))
+        return false;
+    addHash(hash, count);
+    return true;
+}
+
+void SMCApi::CountMinSketch::add(const SMCApi::ObjectArray* array, const std::wstring& path) {
+    HashConsumer<CountMinSketch> consumer{*this};
+    forEachValue(array, path, consumer);
+}
+
+void SMCApi::CountMinSketch::merge(const SMCApi::CountMinSketch& other) {
+    if (other.width != width || other.depth != depth)
+        throw ModuleException(L"wrong size");
+    for (size_t i = 0; i < counts.size(); i++)
+        counts[i] += other.counts[i];
+    totalCount += other.totalCount;
+}
+
+unsigned long long SMCApi::CountMinSketch::estimateHash(unsigned long long hash) const {
+    unsigned long long step = mix(hash) | 1;
+    unsigned long long result = std::numeric_limits<unsigned long long>::max();
+    for (size_t row = 0; row < depth; row++)
+        result = std::min(result, counts[row * width + (size_t)((hash + row * step) % width)]);
+    return result;
+}
+
+unsigned long long SMCApi::CountMinSketch::total() const {
+    return totalCount;
+}
+
+SMCApi::ByteBuffer SMCApi::CountMinSketch::toBytes() const {
+    ByteWriter writer(COUNT_MIN_SKETCH_FORMAT, 24 + counts.size() * sizeof(unsigned long long));
+    writer.write((unsigned long long)width);
+    writer.write((unsigned long long)depth);
+    writer.write(totalCount);
+    for (unsigned long long count : counts)
+        writer.write(count);
+    return writer.toBytes();
+}
+
+SMCApi::CountMinSketch SMCApi::CountMinSketch::fromBytes(const signed char* data, size_t size) {
+    ByteReader reader(data, size, COUNT_MIN_SKETCH_FORMAT);
+    auto width = reader.readLong();
+    auto depth = reader.readLong();
+    auto totalCount = reader.readLong();
+    if (width < 1 || depth < 1 || depth > 16 || width > reader.remaining() / sizeof(unsigned long long) / depth)
+        throw ModuleException(L"wrong data");
+    CountMinSketch result((size_t)width, (size_t)depth);
+    result.totalCount = totalCount;
+    for (unsigned long long& count : result.counts)
+        count = reader.readLong();
+    return result;
+}
+
+SMCApi::TDigest::TDigest(double compression) : compression(compression), totalWeight(0), minValue(std::numeric_limits<double>::infinity()),
+                                               maxValue(-std::numeric_limits<double>::infinity()) {
+    if (!(compression >= 10 && compression <= 10000))
+        throw ModuleException(L"wrong compression");
+}
+
+std::vector<SMCApi::TDigest::Centroid> SMCApi::TDigest::merged() const {
+    if (buffer.empty())
+        return centroids;
+    std::vector<Centroid> values;
+    values.reserve(centroids.size() + buffer.size());
+    values.insert(values.end(), centroids.begin(), centroids.end());
+    values.insert(values.end(), buffer.begin(), buffer.end());
+    std::sort(values.begin(), values.end(), [](const Centroid& a, const Centroid& b) {
+        return a.mean < b.mean;
+    });
+    // scale function k(q) = compression / PI * asin(2 * q - 1), centroid covers at most 1 of k, so there are at most about compression centroids
+    double normalizer = compression / PI;
+    auto weightLimit = [&](double weightBefore) {
+        double k = normalizer * std::asin(2 * weightBefore / totalWeight - 1) + 1;
+        return k / normalizer >= PI / 2 ? totalWeight : (std::sin(k / normalizer) + 1) / 2 * totalWeight;
+    };
+    std::vector<Centroid> result;
+    result.reserve((size_t)compression + 1);
+    Centroid current = values[0];
+    double weightBefore = 0;
+    double limit = weightLimit(weightBefore);
+    for (size_t i = 1; i < values.size(); i++) {
+        const Centroid& next = values[i];
+        if (weightBefore + current.weight + next.weight <= limit) {
+            current.weight += next.weight;
+            current.mean += (next.mean - current.mean) * next.weight / current.weight;
+        } else {
+            result.push_back(current);
+            weightBefore += current.weight;
+            limit = weightLimit(std::min(weightBefore, totalWeight));
+            current = next;
+        }
+    }
+    result.push_back(current);
+    return result;
+}
+
+void SMCApi::TDigest::flush() {
+    centroids = merged();
+    buffer.clear();
+}
+
+void SMCApi::TDigest::add(double value, double weight) {
+    if (std::isnan(value) || !(weight > 0))
+        return;
+    buffer.push_back({value, weight});
+    totalWeight += weight;
+    minValue = std::min(minValue, value);
+    maxValue = std::max(maxValue, value);
+    if (buffer.size() >= (size_t)(compression * 4))
+        flush();
+}
+
+bool SMCApi::TDigest::add(SMCApi::IValue* value) {
+    Number* number = value && isNumber(value->getType()) ? value->getValueNumber() : nullptr;
+    if (number == nullptr)
+        return false;
+    add(number->doubleValue());
+    return true;
+}
+
+void SMCApi::TDigest::add(const SMCApi::ObjectArray* array, const std::wstring& path) {
+    NumberConsumer consumer{*this};
+    forEachValue(array, path, consumer);
+}
+
+void SMCApi::TDigest::merge(const SMCApi::TDigest& other) {
+    if (other.totalWeight == 0)
+        return;
+    buffer.insert(buffer.end(), other.centroids.begin(), other.centroids.end());
+    buffer.insert(buffer.end(), other.buffer.begin(), other.buffer.end());
+    totalWeight += other.totalWeight;
+    minValue = std::min(minValue, other.minValue);
+    maxValue = std::max(maxValue, other.maxValue);
+    flush();
+}
+
+double SMCApi::TDigest::percentile(double percentile) const {
+    if (totalWeight == 0)
+        return 0;
+    std::vector<Centroid> values = merged();
+    double target = std::max(0.0, std::min(100.0, percentile)) / 100.0 * totalWeight;
+    if (target <= 0)
+        return minValue;
+    if (target >= totalWeight)
+        return maxValue;
+    double weightBefore = 0;
+    for (size_t i = 0; i < values.size(); i++) {
+        double center = weightBefore + values[i].weight / 2;
+        if (target < center) {
+            if (i == 0)
+                return minValue + (values[0].mean - minValue) * target / center;
+            double previousCenter = weightBefore - values[i - 1].weight / 2;
+            return values[i - 1].mean + (values[i].mean - values[i - 1].mean) * (target - previousCenter) / (center - previousCenter);
+        }
+        weightBefore += values[i].weight;
+    }
+    double lastCenter = totalWeight - values.back().weight / 2;
+    return values.back().mean + (maxValue - values.back().mean) * (target - lastCenter) / (totalWeight - lastCenter);
+}
+
+double SMCApi::TDigest::count() const {
+    return totalWeight;
+}
+
+double SMCApi::TDigest::min() const {
+    return totalWeight == 0 ? 0 : minValue;
+}
+
+double SMCApi::TDigest::max() const {
+    return totalWeight == 0 ? 0 : maxValue;
+}
+
+SMCApi::ByteBuffer SMCApi::TDigest::toBytes() const {
+    std::vector<Centroid> values = merged();
+    ByteWriter writer(T_DIGEST_FORMAT, 28 + values.size() * sizeof(Centroid));
+    writer.write(compression);
+    writer.write(minValue);
+    writer.write(maxValue);
+    writer.write((unsigned int)values.size());
+    for (const Centroid& centroid : values) {
+        writer.write(centroid.mean);
+        writer.write(centroid.weight);
+    }
+    return writer.toBytes();
+}
+
+SMCApi::TDigest SMCApi::TDigest::fromBytes(const signed char* data, size_t size) {
+    ByteReader reader(data, size, T_DIGEST_FORMAT);
+    auto compression = reader.readDouble();
+    if (!(compression >= 10 && compression <= 10000))
+        throw ModuleException(L"wrong data");
+    TDigest result(compression);
+    result.minValue = reader.readDouble();
+    result.maxValue = reader.readDouble();
+    auto count = reader.readInt();
+    if (count > reader.remaining() / (2 * sizeof(double)))
+        throw ModuleException(L"wrong data");
+    result.centroids.reserve(count);
+    for (unsigned int i = 0; i < count; i++) {
+        Centroid centroid{};
+        centroid.mean = reader.readDouble();
+        centroid.weight = reader.readDouble();
+        if (std::isnan(centroid.mean) || !(centroid.weight > 0))
+            throw ModuleException(L"wrong data");
+        result.centroids.push_back(centroid);
+        result.totalWeight += centroid.weight;
+    }
+    return result;
+}
+
+namespace {
+    /**
+     * count of points in block of TimeSeries
+     */
+    const size_t SERIES_BLOCK_SIZE = 1024;
+
+    int trailingZeros(unsigned long long value) {
+#if defined(__GNUC__) || defined(__clang__)
+        return value == 0 ? 64 : __builtin_ctzll(value);
+#else
+        int count = 0;
+        for (unsigned long long bit = 1; bit != 0 && (value & bit) == 0; bit <<= 1)
+            count++;
+        return count;
+#endif
+    }
+
+    unsigned long long toBits(double value) {
+        unsigned long long bits;
+        memcpy(&bits, &value, sizeof(bits));
+        return bits;
+    }
+
+    double fromBits(unsigned long long bits) {
+        double value;
+        memcpy(&value, &bits, sizeof(value));
+        return value;
+    }
+
+    /**
+     * block of points, first point is in header, others are in bit stream (most significant bit first)
+     */
+    struct SeriesBlock {
+        long long int firstDate;
+        long long int lastDate;
+        unsigned long long firstValue;
+        size_t count;
+        size_t countBits;
+        std::vector<unsigned long long> words;
+
+        void write(unsigned long long value, int bits) {
+            if (bits == 0)
+                return;
+            if (bits < 64)
+                value &= (1ULL << bits) - 1;
+            size_t offset = countBits & 63;
+            if (offset == 0)
+                words.push_back(0);
+            int free = 64 - (int)offset;
+            if (bits <= free) {
+                words.back() |= value << (free - bits);
+            } else {
+                words.back() |= value >> (bits - free);
+                words.push_back(value << (64 - (bits - free)));
+            }
+            countBits += bits;
+        }
+    };
+
+    class SeriesReader {
+    private:
+        const SeriesBlock& block;
+        size_t position;
+        size_t index;
+        long long int date;
+        long long int delta;
+        unsigned long long value;
+        int leading;
+        int trailing;
+
+        unsigned long long read(int bits) {
+            if (bits == 0)
+                return 0;
+            size_t offset = position & 63;
+            unsigned long long word = block.words[position >> 6];
+            int available = 64 - (int)offset;
+            unsigned long long result;
+            if (bits <= available) {
+                result = (word << offset) >> (64 - bits);
+            } else {
+                unsigned long long high = (word << offset) >> offset;
+                result = (high << (bits - available)) | (block.words[(position >> 6) + 1] >> (64 - (bits - available)));
+            }
+            position += bits;
+            return result;
+        }
+
+        bool readBit() {
+            return read(1) != 0;
+        }
+
+        static long long int signExtend(unsigned long long value, int bits) {
+            return (long long int)(value << (64 - bits)) >> (64 - bits);
+        }
+
+    public:
+        explicit SeriesReader(const SeriesBlock& block) : block(block), position(0), index(0), date(block.firstDate), delta(0), value(block.firstValue),
+                                                          leading(0), trailing(0) {
+        }
+
+        bool next(long long int& resultDate, double& resultValue) {
+            if (index >= block.count)
+                return false;
+            if (index > 0) {
+                long long int deltaOfDelta;
+                if (!readBit())
+                    deltaOfDelta = 0;
+                else if (!readBit())
+                    deltaOfDelta = signExtend(read(7), 7);
+                else if (!readBit())
+                    deltaOfDelta = signExtend(read(9), 9);
+                else if (!readBit())
+                    deltaOfDelta = signExtend(read(12), 12);
+                else
+                    deltaOfDelta = (long long int)read(64);
+                delta += deltaOfDelta;
+                date += delta;
+                if (readBit()) {
+                    if (readBit()) {
+                        leading = (int)read(5);
+                        int length = (int)read(6);
+                        trailing = 64 - leading - (length == 0 ? 64 : length);
+                    }
+                    value ^= read(64 - leading - trailing) << trailing;
+                }
+            }
+            index++;
+            resultDate = date;
+            resultValue = fromBits(value);
+            return true;
+        }
+    };
+}
+
+struct SMCApi::TimeSeries::State {
+    std::vector<SeriesBlock> blocks;
+    size_t countPoints;
+    long long int previousDelta;
+    unsigned long long previousValue;
+    int previousLeading;
+    int previousTrailing;
+
+    State() : countPoints(0), previousDelta(0), previousValue(0), previousLeading(-1), previousTrailing(0) {
+    }
+
+    /**
+     * first block with last date not less than date
+     */
+    size_t findBlock(long long int date) const {
+        return (size_t)(std::lower_bound(blocks.begin(), blocks.end(), date, [](const SeriesBlock& block, long long int date) {
+            return block.lastDate < date;
+        }) - blocks.begin());
+    }
+
+    template<typename Consumer>
+    size_t scan(long long int from, long long int to, Consumer consumer) const {
+        size_t count = 0;
+        for (size_t i = findBlock(from); i < blocks.size() && blocks[i].firstDate <= to; i++) {
+            SeriesReader reader(blocks[i]);
+            long long int date;
+            double value;
+            while (reader.next(date, value) && date <= to) {
+                if (date >= from) {
+                    consumer(date, value);
+                    count++;
+                }
+            }
+        }
+        return count;
+    }
+};
+
+SMCApi::TimeSeries::TimeSeries() : state(new State()) {
+}
+
+void SMCApi::TimeSeries::add(long long int date, double value) {
+    auto& blocks = state->blocks;
+    unsigned long long bits = toBits(value);
+    if (!blocks.empty() && date < blocks.back().lastDate)
+        throw ModuleException(L"wrong date");
+    if (blocks.empty() || blocks.back().count == SERIES_BLOCK_SIZE) {
+        if (!blocks.empty())
+            blocks.back().words.shrink_to_fit();
+        blocks.push_back({date, date, bits, 1, 0, {}});
+        state->previousDelta = 0;
+        state->previousValue = bits;
+        state->previousLeading = -1;
+        state->countPoints++;
+        return;
+    }
+    SeriesBlock& block = blocks.back();
+    long long int delta = date - block.lastDate;
+    long long int deltaOfDelta = delta - state->previousDelta;
+    if (deltaOfDelta == 0) {
+        block.write(0, 1);
+    } else if (deltaOfDelta >= -64 && deltaOfDelta < 64) {
+        block.write(2, 2);
+        block.write((unsigned long long)deltaOfDelta, 7);
+    } else if (deltaOfDelta >= -256 && deltaOfDelta < 256) {
+        block.write(6, 3);
+        block.write((unsigned long long)deltaOfDelta, 9);
+    } else if (deltaOfDelta >= -2048 && deltaOfDelta < 2048) {
+        block.write(14, 4);
+        block.write((unsigned long long)deltaOfDelta, 12);
+    } else {
+        block.write(15, 4);
+        block.write((unsigned long long)deltaOfDelta, 64);
+    }
+    unsigned long long difference = bits ^ state->previousValue;
+    if (difference == 0) {
+        block.write(0, 1);
+    } else {
+        int leading = std::min(leadingZeros(difference), 31);
+        int trailing = trailingZeros(difference);
+        if (state->previousLeading >= 0 && leading >= state->previousLeading && trailing >= state->previousTrailing) {
+            block.write(2, 2);
+            block.write(difference >> state->previousTrailing, 64 - state->previousLeading - state->previousTrailing);
+        } else {
+            int length = 64 - leading - trailing;
+            block.write(3, 2);
+            block.write((unsigned long long)leading, 5);
+            block.write((unsigned long long)(length & 63), 6);
+            block.write(difference >> trailing, length);
+            state->previousLeading = leading;
+            state->previousTrailing = trailing;
+        }
+    }
+    block.lastDate = date;
+    block.count++;
+    state->previousDelta = delta;
+    state->previousValue = bits;
+    state->countPoints++;
+}
+
+bool SMCApi::TimeSeries::add(SMCApi::IMessage* message) {
+    Number* number = message && isNumber(message->getType()) ? message->getValueNumber() : nullptr;
+    if (number == nullptr)
+        return false;
+    add(message->getDate(), number->doubleValue());
+    return true;
+}
+
+size_t SMCApi::TimeSeries::size() const {
+    return state->countPoints;
+}
+
+long long int SMCApi::TimeSeries::firstDate() const {
+    return state->blocks.empty() ? 0 : state->blocks.front().firstDate;
+}
+
+long long int SMCApi::TimeSeries::lastDate() const {
+    return state->blocks.empty() ? 0 : state->blocks.back().lastDate;
+}
+
+size_t SMCApi::TimeSeries::scan(long long int from, long long int to, std::vector<long long int>& dates, std::vector<double>& values) const {
+    return state->scan(from, to, [&](long long int date, double value) {
+        dates.push_back(date);
+        values.push_back(value);
+    });
+}
+
+size_t SMCApi::TimeSeries::decode(long long int from, long long int to, SMCApi::ObjectArray* dates, SMCApi::ObjectArray* values) const {
+    if ((dates->getType() != OT_LONG && dates->getType() != OT_VALUE_ANY) || (values->getType() != OT_DOUBLE && values->getType() != OT_VALUE_ANY))
+        throw ModuleException(L"wrong type");
+    std::vector<Number*> dateNumbers;
+    std::vector<Number*> valueNumbers;
+    state->scan(from, to, [&](long long int date, double value) {
+        dateNumbers.push_back(new Number(date));
+        valueNumbers.push_back(new Number(value));
+    });
+    bool datesAdded = false;
+    try {
+        dates->add((const Number* const*)dateNumbers.data(), dateNumbers.size());
+        datesAdded = true;
+        values->add((const Number* const*)valueNumbers.data(), valueNumbers.size());
+    } catch (...) {
+        if (!datesAdded) {
+            for (Number* number : dateNumbers)
+                delete number;
+        }
+        for (Number* number : valueNumbers)
+            delete number;
+        throw;
+    }
+    return dateNumbers.size();
+}
+
+size_t SMCApi::TimeSeries::removeBefore(long long int date) {
+    auto& blocks = state->blocks;
+    size_t count = 0;
+    size_t end = 0;
+    while (end < blocks.size() && blocks[end].lastDate < date)
+        count += blocks[end++].count;
+    blocks.erase(blocks.begin(), blocks.begin() + end);
+    state->countPoints -= count;
+    return count;
+}
+
+void SMCApi::TimeSeries::clear() {
+    state->blocks.clear();
+    state->countPoints = 0;
+}
+
+size_t SMCApi::TimeSeries::getMemorySize() const {
+    size_t size = sizeof(State) + state->blocks.capacity() * sizeof(SeriesBlock);
+    for (auto& block : state->blocks)
+        size += block.words.capacity() * sizeof(unsigned long long);
+    return size;
+}
+
+SMCApi::TimeSeries::~TimeSeries() {
+    delete state;
+}
@@ -0,0 +1,453 @@
+/*
+Library (provider c++), is a part of the platform Shelf MK (Shell for modular structures, SMC platform).
+The author and copyright holder of the software package (application) Shelf MK (Shell for modular structures, SMC platform) is Ulyanov Nikolay Vladimirovich (ulianownv@mail.ru).
+The following are prohibited: changing and distributing the program code, selling/reselling it, as well as other actions and rights not expressly permitted.
+*/
+
+#include "SMCApi.h"
+#include <vector>
+
+#ifndef SMCMODULEDEFINITIONPROVIDER_SMCAPISTREAM_H
+#define SMCMODULEDEFINITIONPROVIDER_SMCAPISTREAM_H
+
+namespace SMCApi {
+    enum WindowType {
+        /**
+         * last N values
+         */
+        WT_COUNT,
+        /**
+         * values with date in (last date - N, last date]
+         */
+        WT_TIME
+    };
+
+    /**
+     * sliding window of numeric values of message stream, state is kept between calls of process
+     * add and eviction are O(1) amortized for count, sum, min, max, mean
+     * percentiles are optional, add and eviction are O(log n + 256) for them (values are kept in sorted blocks)
+     * dates of values should not decrease, value with older date is evicted after values added before it
+     *
+     * @version 1.0.0
+     */
+    class CLASS_DECLSPEC SlidingWindow {
+    private:
+        struct State;
+
+        State* state;
+
+        void evict();
+
+    public:
+        /**
+         * @param type                  type of window
+         * @param size                  count of values for WT_COUNT or duration in milliseconds (as IMessage::getDate) for WT_TIME, minimum 1
+         * @param percentiles           keep values sorted for percentile
+         */
+        SlidingWindow(WindowType type, long long int size, bool percentiles = false);
+
+        SlidingWindow(const SlidingWindow&) = delete;
+
+        SlidingWindow& operator=(const SlidingWindow&) = delete;
+
+        /**
+         * add value, NaN is skipped
+         *
+         * @param date                  date of value
+         * @param value                 value
+         */
+        void add(long long int date, double value);
+
+        /**
+         * add number value of message
+         *
+         * @param message               IMessage
+         * @return false if value is not number (skipped)
+         */
+        bool add(IMessage* message);
+
+        /**
+         * add messages not added before
+         * for SGT_LAST sources the same messages are returned by several calls of process, they are found by date:
+         * messages with date before last added date are skipped, with last added date - skipped while count is not greater than count added with this date
+         *
+         * @param messages              IMessage list in order of dates
+         * @return count of added messages
+         */
+        size_t update(const std::vector<IMessage*>* messages);
+
+        /**
+         * add messages of actions not added before, as update(messages)
+         *
+         * @param actions               IAction list (example: result of IExecutionContextTool::getMessages)
+         * @return count of added messages
+         */
+        size_t update(const std::vector<IAction*>* actions);
+
+        /**
+         * remove all values
+         */
+        void clear();
+
+        size_t count() const;
+
+        double sum() const;
+
+        /**
+         * @return min value or 0 if empty
+         */
+        double min() const;
+
+        /**
+         * @return max value or 0 if empty
+         */
+        double max() const;
+
+        /**
+         * @return mean value or 0 if empty
+         */
+        double mean() const;
+
+        /**
+         * value at percentile (nearest rank), only if window is created with percentiles
+         *
+         * @param percentile            from 0 to 100
+         * @return value or 0 if empty
+         */
+        double percentile(double percentile) const;
+
+        /**
+         * date of last added value
+         *
+         * @return date or 0 if nothing was added
+         */
+        long long int lastDate() const;
+
+        ~SlidingWindow();
+    };
+
+    /**
+     * 64 bit hash of value for sketches, the same in all processes and on all platforms (byte order does not change it)
+     * numbers with integer value have the same hash for all number types (example: 5 and 5.0), strings are hashed as UTF-8
+     *
+     * @param value                 value
+     * @return hash
+     */
+    CLASS_DECLSPEC unsigned long long sketchHash(long long int value);
+
+    CLASS_DECLSPEC unsigned long long sketchHash(double value);
+
+    CLASS_DECLSPEC unsigned long long sketchHash(const std::wstring& value);
+
+    /**
+     * @param value                 value of message or other IValue
+     * @param hash                  result
+     * @return false if value is null or ObjectArray
+     */
+    CLASS_DECLSPEC bool sketchHash(IValue* value, unsigned long long& hash);
+
+    /**
+     * estimate of count of distinct values (HyperLogLog), memory is 2^precision bytes
+     * standard error is 1.04 / sqrt(2^precision) (0.8% for precision 14)
+     *
+     * @version 1.0.0
+     */
+    class CLASS_DECLSPEC HyperLogLog {
+    private:
+        int precision;
+        std::vector<unsigned char> registers;
+
+    public:
+        /**
+         * @param precision             from 4 to 18
+         */
+        explicit HyperLogLog(int precision = 14);
+
+        void addHash(unsigned long long hash);
+
+        /**
+         * add value of message
+         *
+         * @param value                 IValue
+         * @return false if value is skipped (null or ObjectArray)
+         */
+        bool add(IValue* value);
+
+        /**
+         * add items of array or values of field of elements, null values, arrays and elements are skipped
+         *
+         * @param array                 ObjectArray
+         * @param path                  empty for items or names of fields separated by '.'
+         */
+        void add(const ObjectArray* array, const std::wstring& path = std::wstring());
+
+        /**
+         * add all values of other sketch (example: result of other thread)
+         *
+         * @param other                 HyperLogLog with the same precision
+         */
+        void merge(const HyperLogLog& other);
+
+        double estimate() const;
+
+        int getPrecision() const;
+
+        /**
+         * serialize for OT_BYTES value, numbers are little endian, so bytes are the same on all platforms
+         * (sketches of all platforms can be merged, hashes do not depend on byte order too)
+         *
+         * @return ByteBuffer
+         */
+        ByteBuffer toBytes() const;
+
+        /**
+         * @param data                  bytes from toBytes
+         * @param size                  count of bytes
+         * @return HyperLogLog
+         */
+        static HyperLogLog fromBytes(const signed char* data, size_t size);
+    };
+
+    /**
+     * estimate of count of each value (Count-Min), estimate is never less than real count
+     * with width w and depth d the estimate is greater than real count by more than 2.72 * total / w with probability 1 / 2.72^d
+     *
+     * @version 1.0.0
+     */
+    class CLASS_DECLSPEC CountMinSketch {
+    private:
+        size_t width;
+        size_t depth;
+        unsigned long long totalCount;
+        std::vector<unsigned long long> counts;
+
+    public:
+        /**
+         * @param width                 count of counters in row, minimum 1
+         * @param depth                 count of rows, from 1 to 16
+         */
+        explicit CountMinSketch(size_t width = 2048, size_t depth = 4);
+
+        void addHash(unsigned long long hash, unsigned long long count = 1);
+
+        /**
+         * add value of message
+         *
+         * @param value                 IValue
+         * @param count                 count
+         * @return false if value is skipped (null or ObjectArray)
+         */
+        bool add(IValue* value, unsigned long long count = 1);
+
+        /**
+         * add items of array or values of field of elements, null values, arrays and elements are skipped
+         *
+         * @param array                 ObjectArray
+         * @param path                  empty for items or names of fields separated by '.'
+         */
+        void add(const ObjectArray* array, const std::wstring& path = std::wstring());
+
+        /**
+         * @param other                 CountMinSketch with the same width and depth
+         */
+        void merge(const CountMinSketch& other);
+
+        /**
+         * estimate of count of value
+         *
+         * @param hash                  sketchHash of value
+         * @return count
+         */
+        unsigned long long estimateHash(unsigned long long hash) const;
+
+        /**
+         * sum of all counts
+         *
+         * @return count
+         */
+        unsigned long long total() const;
+
+        ByteBuffer toBytes() const;
+
+        static CountMinSketch fromBytes(const signed char* data, size_t size);
+    };
+
+    /**
+     * estimate of percentiles (merging t-digest), accuracy is best near 0 and 100
+     * at most about compression centroids and 4 * compression buffered values are kept
+     *
+     * @version 1.0.0
+     */
+    class CLASS_DECLSPEC TDigest {
+    public:
+        struct Centroid {
+            double mean;
+            double weight;
+        };
+
+    private:
+        double compression;
+        std::vector<Centroid> centroids;
+        std::vector<Centroid> buffer;
+        double totalWeight;
+        double minValue;
+        double maxValue;
+
+        void flush();
+
+        std::vector<Centroid> merged() const;
+
+    public:
+        /**
+         * @param compression           from 10 to 10000, more is more accurate
+         */
+        explicit TDigest(double compression = 100);
+
+        /**
+         * add value, NaN is skipped
+         *
+         * @param value                 value
+         * @param weight                weight (count) of value, greater than 0
+         */
+        void add(double value, double weight = 1);
+
+        /**
+         * add number value of message
+         *
+         * @param value                 IValue
+         * @return false if value is not number
+         */
+        bool add(IValue* value);
+
+        /**
+         * add number items of array or number values of field of elements, other values are skipped
+         *
+         * @param array                 ObjectArray
+         * @param path                  empty for items or names of fields separated by '.'
+         */
+        void add(const ObjectArray* array, const std::wstring& path = std::wstring());
+
+        void merge(const TDigest& other);
+
+        /**
+         * value at percentile, interpolated between centroids
+         *
+         * @param percentile            from 0 to 100
+         * @return value or 0 if empty
+         */
+        double percentile(double percentile) const;
+
+        /**
+         * sum of weights
+         *
+         * @return double
+         */
+        double count() const;
+
+        /**
+         * @return min value or 0 if empty
+         */
+        double min() const;
+
+        /**
+         * @return max value or 0 if empty
+         */
+        double max() const;
+
+        ByteBuffer toBytes() const;
+
+        static TDigest fromBytes(const signed char* data, size_t size);
+    };
+
+    /**
+     * compressed series of numeric values with dates (Gorilla): dates are stored as delta of delta, values as XOR with previous value
+     * points are kept in blocks of 1024 points, regular dates and slowly changing values take 1 - 3 bytes per point
+     * dates should not decrease
+     *
+     * @version 1.0.0
+     */
+    class CLASS_DECLSPEC TimeSeries {
+    private:
+        struct State;
+
+        State* state;
+
+    public:
+        TimeSeries();
+
+        TimeSeries(const TimeSeries&) = delete;
+
+        TimeSeries& operator=(const TimeSeries&) = delete;
+
+        /**
+         * add point
+         *
+         * @param date                  date, not less than date of last point
+         * @param value                 value
+         */
+        void add(long long int date, double value);
+
+        /**
+         * add number value of message with date of message
+         *
+         * @param message               IMessage
+         * @return false if value is not number (skipped)
+         */
+        bool add(IMessage* message);
+
+        size_t size() const;
+
+        /**
+         * @return date of first point or 0 if empty
+         */
+        long long int firstDate() const;
+
+        /**
+         * @return date of last point or 0 if empty
+         */
+        long long int lastDate() const;
+
+        /**
+         * points with date in range, only blocks which intersect range are decoded
+         *
+         * @param from                  first date
+         * @param to                    last date (included)
+         * @param dates                 result, points are appended
+         * @param values                result, points are appended
+         * @return count of points
+         */
+        size_t scan(long long int from, long long int to, std::vector<long long int>& dates, std::vector<double>& values) const;
+
+        /**
+         * points with date in range as columns
+         *
+         * @param from                  first date
+         * @param to                    last date (included)
+         * @param dates                 ObjectArray with type OT_LONG, dates are appended
+         * @param values                ObjectArray with type OT_DOUBLE, values are appended
+         * @return count of points
+         */
+        size_t decode(long long int from, long long int to, ObjectArray* dates, ObjectArray* values) const;
+
+        /**
+         * remove blocks with all points before date (retention), points of block with newer points are kept
+         *
+         * @param date                  date
+         * @return count of removed points
+         */
+        size_t removeBefore(long long int date);
+
+        void clear();
+
+        /**
+         * size of compressed data and headers of blocks
+         *
+         * @return size in bytes
+         */
+        size_t getMemorySize() const;
+
+        ~TimeSeries();
+    };
+}
+
+#endif //SMCMODULEDEFINITIONPROVIDER_SMCAPISTREAM_H
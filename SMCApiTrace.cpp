@@ -0,0 +1,265 @@
+/*
+Library (provider c++), is a part of the platform Shelf MK (Shell for modular structures, SMC platform).
+The author and copyright holder of the software package (application) Shelf MK (Shell for modular structures, SMC platform) is Ulyanov Nikolay Vladimirovich (ulianownv@mail.ru).
+The following are prohibited: changing and distributing the program code, selling/reselling it, as well as other actions and rights not expressly permitted.
+*/
+
+#include "SMCApiTrace.h"
+#include <chrono>
+#include <cstdio>
+#include <functional>
+
+/**
+ * ring buffer of one thread
+ * written only by owner thread, every slot is protected by sequence (even - ready, odd - in write)
+ */
+struct SMCApi::TraceRecorder::ThreadBuffer {
+    struct Slot {
+        std::atomic<unsigned long long> sequence;
+        TraceEvent event;
+    };
+
+    const long long int threadNumber;
+    const size_t nativeId;
+    Slot* slots;
+    const size_t capacity;
+    std::atomic<unsigned long long> written;
+
+    ThreadBuffer(long long int threadNumber, size_t capacity)
+        : threadNumber(threadNumber), nativeId(std::hash<std::thread::id>()(std::this_thread::get_id())), slots(new Slot[capacity]),
+          capacity(capacity), written(0) {
+        for (size_t i = 0; i < capacity; i++)
+            slots[i].sequence.store(0, std::memory_order_relaxed);
+    }
+
+    void write(const TraceEvent& event) {
+        unsigned long long number = written.load(std::memory_order_relaxed);
+        Slot& slot = slots[number % capacity];
+        slot.sequence.store(number * 2 + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        slot.event = event;
+        slot.sequence.store(number * 2 + 2, std::memory_order_release);
+        written.store(number + 1, std::memory_order_release);
+    }
+
+    /**
+     * copy ready events, events overwritten in time of read are skipped
+     */
+    template<typename Function>
+    void read(Function function) const {
+        unsigned long long end = written.load(std::memory_order_acquire);
+        unsigned long long begin = end > capacity ? end - capacity : 0;
+        for (unsigned long long number = begin; number < end; number++) {
+            const Slot& slot = slots[number % capacity];
+            if (slot.sequence.load(std::memory_order_acquire) != number * 2 + 2)
+                continue;
+            TraceEvent event = slot.event;
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (slot.sequence.load(std::memory_order_relaxed) != number * 2 + 2)
+                continue;
+            function(event);
+        }
+    }
+
+    ~ThreadBuffer() {
+        delete[] slots;
+    }
+};
+
+namespace {
+    struct ThreadBufferCache {
+        unsigned long long owner;
+        void* buffer;
+    };
+
+    thread_local ThreadBufferCache threadBufferCache = {0, nullptr};
+    thread_local unsigned int sampleCounter = 0;
+
+    std::atomic<unsigned long long> lastRecorderId(0);
+
+    void appendJsonString(std::string& result, const std::wstring& value) {
+        result.push_back('"');
+        for (char c : SMCApi::toUtf8(value)) {
+            if (c == '"' || c == '\\') {
+                result.push_back('\\');
+                result.push_back(c);
+            } else if ((unsigned char)c < 0x20) {
+                char buffer[8];
+                snprintf(buffer, sizeof(buffer), "\\u%04x", (unsigned int)(unsigned char)c);
+                result.append(buffer);
+            } else {
+                result.push_back(c);
+            }
+        }
+        result.push_back('"');
+    }
+
+    void appendEvent(std::string& result, const SMCApi::TraceEvent& event, char phase, long long int time, long long int duration,
+                     long long int threadNumber) {
+        if (result.back() != '[')
+            result.push_back(',');
+        result.append("{\"name\":");
+        appendJsonString(result, event.name);
+        char buffer[256];
+        if (phase == 'X') {
+            snprintf(buffer, sizeof(buffer), ",\"cat\":\"smc\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":%lld", time / 1000.0,
+                     duration / 1000.0, threadNumber);
+        } else {
+            snprintf(buffer, sizeof(buffer), ",\"cat\":\"smc\",\"ph\":\"%c\",\"id\":%lld,\"ts\":%.3f,\"pid\":1,\"tid\":%lld", phase, event.id,
+                     time / 1000.0, threadNumber);
+        }
+        result.append(buffer);
+        result.append(",\"args\":{");
+        if (event.context) {
+            result.append("\"context\":");
+            appendJsonString(result, *event.context);
+        }
+        if (event.id != 0 && phase == 'X') {
+            snprintf(buffer, sizeof(buffer), "%s\"id\":%lld", event.context ? "," : "", event.id);
+            result.append(buffer);
+        }
+        result.append("}}");
+    }
+}
+
+long long int SMCApi::nowNanoseconds() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+SMCApi::TraceRecorder::TraceRecorder(size_t eventsPerThread)
+    : countPending(0), eventsPerThread(eventsPerThread > 0 ? eventsPerThread : 1), enable(true), sampling(1), startTime(nowNanoseconds()),
+      id(++lastRecorderId) {
+}
+
+SMCApi::TraceRecorder::ThreadBuffer* SMCApi::TraceRecorder::getThreadBuffer() {
+    if (threadBufferCache.owner == id)
+        return (ThreadBuffer*)threadBufferCache.buffer;
+    ThreadBuffer* buffer;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = threads.find(std::this_thread::get_id());
+        if (it != threads.end()) {
+            buffer = it->second;
+        } else {
+            buffer = new ThreadBuffer((long long int)threads.size() + 1, eventsPerThread);
+            threads[std::this_thread::get_id()] = buffer;
+        }
+    }
+    threadBufferCache = {id, buffer};
+    return buffer;
+}
+
+bool SMCApi::TraceRecorder::isEnable() const {
+    return enable.load(std::memory_order_relaxed);
+}
+
+void SMCApi::TraceRecorder::setEnable(bool enable) {
+    TraceRecorder::enable.store(enable, std::memory_order_relaxed);
+}
+
+void SMCApi::TraceRecorder::setSampling(unsigned int every) {
+    sampling.store(every, std::memory_order_relaxed);
+}
+
+bool SMCApi::TraceRecorder::sample() {
+    unsigned int every = sampling.load(std::memory_order_relaxed);
+    if (every == 0 || !isEnable())
+        return false;
+    return sampleCounter++ % every == 0;
+}
+
+void SMCApi::TraceRecorder::record(const wchar_t* name, const std::wstring* context, long long int start, long long int end, long long int id) {
+    if (!isEnable())
+        return;
+    getThreadBuffer()->write({name, context, start, end - start, id, 'X'});
+}
+
+void SMCApi::TraceRecorder::startAsync(const wchar_t* name, const std::wstring* context, long long int id) {
+    if (!isEnable())
+        return;
+    std::lock_guard<std::mutex> lock(mutex);
+    // spans which are never finished should not grow memory, the oldest (smallest id) is dropped
+    if (pending.size() >= eventsPerThread && pending.find(id) == pending.end())
+        pending.erase(pending.begin());
+    pending[id] = {name, context, nowNanoseconds(), 0, id, 'A'};
+    countPending.store(pending.size(), std::memory_order_relaxed);
+}
+
+void SMCApi::TraceRecorder::finishAsync(long long int id) {
+    if (countPending.load(std::memory_order_relaxed) == 0)
+        return;
+    TraceEvent event;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = pending.find(id);
+        if (it == pending.end())
+            return;
+        event = it->second;
+        pending.erase(it);
+        countPending.store(pending.size(), std::memory_order_relaxed);
+    }
+    event.duration = nowNanoseconds() - event.start;
+    if (isEnable())
+        getThreadBuffer()->write(event);
+}
+
+size_t SMCApi::TraceRecorder::countEvents() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    size_t result = 0;
+    for (auto& thread : threads)
+        result += (size_t)std::min<unsigned long long>(thread.second->written.load(std::memory_order_relaxed), thread.second->capacity);
+    return result;
+}
+
+std::string SMCApi::TraceRecorder::toJson() const {
+    std::string result("{\"displayTimeUnit\":\"ns\",\"traceEvents\":[");
+    std::lock_guard<std::mutex> lock(mutex);
+    for (auto& thread : threads) {
+        const ThreadBuffer* buffer = thread.second;
+        if (result.back() != '[')
+            result.push_back(',');
+        char text[256];
+        snprintf(text, sizeof(text), "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%lld,\"args\":{\"name\":\"thread %zu\"}}",
+                 buffer->threadNumber, buffer->nativeId);
+        result.append(text);
+        buffer->read([&](const TraceEvent& event) {
+            long long int time = event.start - startTime;
+            if (event.phase == 'A') {
+                appendEvent(result, event, 'b', time, 0, buffer->threadNumber);
+                appendEvent(result, event, 'e', time + event.duration, 0, buffer->threadNumber);
+            } else {
+                appendEvent(result, event, 'X', time, event.duration, buffer->threadNumber);
+            }
+        });
+    }
+    result.append("]}");
+    return result;
+}
+
+bool SMCApi::TraceRecorder::save(const std::wstring& path) const {
+    std::string json = toJson();
+#ifdef _WIN32
+    FILE* file = _wfopen(path.c_str(), L"wb");
+#else
+    FILE* file = fopen(toUtf8(path).c_str(), "wb");
+#endif
+    if (file == nullptr)
+        return false;
+    bool result = fwrite(json.data(), 1, json.size(), file) == json.size();
+    return fclose(file) == 0 && result;
+}
+
+SMCApi::TraceRecorder::~TraceRecorder() {
+    for (auto& thread : threads)
+        delete thread.second;
+    threads.clear();
+}
+
+SMCApi::TraceSpan::TraceSpan(SMCApi::TraceRecorder* recorder, const wchar_t* name, const std::wstring* context)
+    : recorder(recorder), name(name), context(context), start(recorder ? nowNanoseconds() : 0) {
+}
+
+SMCApi::TraceSpan::~TraceSpan() {
+    if (recorder)
+        recorder->record(name, context, start, nowNanoseconds());
+}
@@ -0,0 +1,175 @@
+/*
+Library (provider c++), is a part of the platform Shelf MK (Shell for modular structures, SMC platform).
+The author and copyright holder of the software package (application) Shelf MK (Shell for modular structures, SMC platform) is Ulyanov Nikolay Vladimirovich (ulianownv@mail.ru).
+The following are prohibited: changing and distributing the program code, selling/reselling it, as well as other actions and rights not expressly permitted.
+*/
+
+#include "SMCApi.h"
+#include <atomic>
+#include <map>
+#include <mutex>
+#include <thread>
+
+#ifndef SMCMODULEDEFINITIONPROVIDER_SMCAPITRACE_H
+#define SMCMODULEDEFINITIONPROVIDER_SMCAPITRACE_H
+
+namespace SMCApi {
+    /**
+     * current time of monotonic clock
+     *
+     * @return nanoseconds
+     */
+    CLASS_DECLSPEC long long int nowNanoseconds();
+
+    /**
+     * one span of trace
+     * name must be a string literal, context must live as long as recorder
+     *
+     * @version 1.0.0
+     */
+    struct CLASS_DECLSPEC TraceEvent {
+        const wchar_t* name;
+        const std::wstring* context;
+        long long int start;
+        long long int duration;
+        long long int id;
+        /**
+         * 'X' - span on recording thread, 'A' - async span (example: wait of executeParallel thread)
+         */
+        char phase;
+    };
+
+    /**
+     * recorder of spans in Chrome trace format (chrome://tracing, Perfetto)
+     * every thread writes in own ring buffer of fixed size without locks, old events are overwritten
+     * process calls are sampled (see setSampling), other calls are recorded always while enabled
+     *
+     * @version 1.0.0
+     */
+    class CLASS_DECLSPEC TraceRecorder {
+    private:
+        struct ThreadBuffer;
+
+        std::map<std::thread::id, ThreadBuffer*> threads;
+        std::map<long long int, TraceEvent> pending;
+        std::atomic<size_t> countPending;
+        mutable std::mutex mutex;
+        const size_t eventsPerThread;
+        std::atomic<bool> enable;
+        std::atomic<unsigned int> sampling;
+        const long long int startTime;
+        const unsigned long long id;
+
+        ThreadBuffer* getThreadBuffer();
+
+    public:
+        /**
+         * @param eventsPerThread       size of ring buffer of each thread and max count of not finished async spans
+         */
+        explicit TraceRecorder(size_t eventsPerThread = 16384);
+
+        TraceRecorder(const TraceRecorder&) = delete;
+
+        TraceRecorder& operator=(const TraceRecorder&) = delete;
+
+        bool isEnable() const;
+
+        void setEnable(bool enable);
+
+        /**
+         * record one of every N process calls
+         *
+         * @param every                 N, 1 - record all, 0 - record none
+         */
+        void setSampling(unsigned int every);
+
+        /**
+         * decide if current process call is recorded, counter is kept per thread
+         *
+         * @return true if recorded
+         */
+        bool sample();
+
+        /**
+         * add span
+         *
+         * @param name                  string literal
+         * @param context               context name or null
+         * @param start                 start time (nowNanoseconds)
+         * @param end                   end time (nowNanoseconds)
+         * @param id                    additional id, 0 if none
+         */
+        void record(const wchar_t* name, const std::wstring* context, long long int start, long long int end, long long int id = 0);
+
+        /**
+         * start async span, it is recorded on finishAsync
+         * at most eventsPerThread spans wait for finish, if there are more the span with the smallest id is dropped
+         *
+         * @param name                  string literal
+         * @param context               context name or null
+         * @param id                    unique id (example: thread id of executeParallel)
+         */
+        void startAsync(const wchar_t* name, const std::wstring* context, long long int id);
+
+        /**
+         * finish async span, if it was started
+         *
+         * @param id                    id
+         */
+        void finishAsync(long long int id);
+
+        /**
+         * count of events in buffers
+         *
+         * @return size_t
+         */
+        size_t countEvents() const;
+
+        /**
+         * trace in Chrome trace JSON format
+         * events, written in the moment of call, may be skipped
+         *
+         * @return UTF-8 string
+         */
+        std::string toJson() const;
+
+        /**
+         * write toJson to file
+         *
+         * @param path                  file path
+         * @return true if written
+         */
+        bool save(const std::wstring& path) const;
+
+        virtual ~TraceRecorder();
+    };
+
+    /**
+     * record span from construction to destruction
+     *
+     * @version 1.0.0
+     */
+    class CLASS_DECLSPEC TraceSpan {
+    private:
+        TraceRecorder* recorder;
+        const wchar_t* name;
+        const std::wstring* context;
+        long long int start;
+
+    public:
+        /**
+         * @param recorder              TraceRecorder, if null - nothing is recorded
+         * @param name                  string literal
+         * @param context               context name or null
+         */
+        TraceSpan(TraceRecorder* recorder, const wchar_t* name, const std::wstring* context);
+
+        TraceSpan(const TraceSpan&) = delete;
+
+        TraceSpan& operator=(const TraceSpan&) = delete;
+
+        ~TraceSpan();
+    };
+}
+
+#endif //SMCMODULEDEFINITIONPROVIDER_SMCAPITRACE_H
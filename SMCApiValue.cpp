@@ -0,0 +1,348 @@
+/*
+Library (provider c++), is a part of the platform Shelf MK (Shell for modular structures, SMC platform).
+The author and copyright holder of the software package (application) Shelf MK (Shell for modular structures, SMC platform) is Ulyanov Nikolay Vladimirovich (ulianownv@mail.ru).
+The following are prohibited: changing and distributing the program code, selling/reselling it, as well as other actions and rights not expressly permitted.
+*/
+
+#include "SMCApiValue.h"
+
+SMCApi::Value::Value() : type(ValueType::VT_STRING), stringUtf8(false), pNumber(nullptr), valueBoolean(false), pObjectArray(nullptr),
+                         pFrozenObjectArray(nullptr) {
+}
+
+void SMCApi::Value::setValue(const std::wstring& value) {
+    clear();
+    type = ValueType::VT_STRING;
+    valueString.assign(value);
+}
+
+void SMCApi::Value::setValue(std::wstring&& value) {
+    clear();
+    type = ValueType::VT_STRING;
+    valueString.swap(value);
+}
+
+void SMCApi::Value::setValueUtf8(const std::string& value) {
+    clear();
+    type = ValueType::VT_STRING;
+    valueUtf8.assign(value);
+    stringUtf8 = true;
+}
+
+void SMCApi::Value::setValueUtf8(std::string&& value) {
+    clear();
+    type = ValueType::VT_STRING;
+    valueUtf8.swap(value);
+    stringUtf8 = true;
+}
+
+void SMCApi::Value::setValue(const SMCApi::Number* value) {
+    clear();
+    type = convertToValue(((Number*)value)->getType());
+    pNumber = new Number(value);
+}
+
+void SMCApi::Value::setValue(const signed char* value, size_t size) {
+    clear();
+    type = ValueType::VT_BYTES;
+    valueBytes = ByteBuffer(value, size);
+}
+
+void SMCApi::Value::setValue(std::vector<signed char>&& value) {
+    clear();
+    type = ValueType::VT_BYTES;
+    valueBytes = ByteBuffer(std::move(value));
+}
+
+void SMCApi::Value::setValue(const SMCApi::ByteBuffer& value) {
+    ByteBuffer buffer(value);
+    clear();
+    type = ValueType::VT_BYTES;
+    valueBytes = std::move(buffer);
+}
+
+void SMCApi::Value::setValue(const bool value) {
+    clear();
+    type = ValueType::VT_BOOLEAN;
+    valueBoolean = value;
+}
+
+void SMCApi::Value::setValue(std::unique_ptr<ObjectArray> value) {
+    clear();
+    type = ValueType::VT_OBJECT_ARRAY;
+    pObjectArray = value.release();
+}
+
+void SMCApi::Value::setValue(SMCApi::FrozenObjectArray* value) {
+    value->retain();
+    clear();
+    type = ValueType::VT_OBJECT_ARRAY;
+    pFrozenObjectArray = value;
+}
+
+void SMCApi::Value::setValue(SMCApi::IValue* value) {
+    switch (value->getType()) {
+    case VT_STRING: {
+        auto* pValue = dynamic_cast<Value*>(value);
+        if (pValue && pValue->stringUtf8)
+            setValueUtf8(pValue->valueUtf8);
+        else
+            setValue(*value->getValueString());
+        break;
+    }
+    case VT_BYTE:
+    case VT_SHORT:
+    case VT_INTEGER:
+    case VT_LONG:
+    case VT_BIG_INTEGER:
+    case VT_FLOAT:
+    case VT_DOUBLE:
+    case VT_BIG_DECIMAL:
+        setValue(value->getValueNumber());
+        break;
+    case VT_BYTES: {
+        auto* pValue = dynamic_cast<Value*>(value);
+        if (pValue)
+            setValue(pValue->valueBytes);
+        else
+            setValue(value->getValueBytes(), value->getBytesCount());
+        break;
+    }
+    case VT_OBJECT_ARRAY: {
+        auto* pValue = dynamic_cast<Value*>(value);
+        if (pValue && pValue->pFrozenObjectArray)
+            setValue(pValue->pFrozenObjectArray);
+        else
+            setValue(std::unique_ptr<ObjectArray>(new ObjectArray(value->getValueObjectArray())));
+        break;
+    }
+    case VT_BOOLEAN:
+        setValue(value->getValueBoolean());
+        break;
+    }
+}
+
+void SMCApi::Value::clear() {
+    valueString.clear();
+    valueUtf8.clear();
+    stringUtf8 = false;
+    valueBytes = ByteBuffer();
+    delete pNumber;
+    pNumber = nullptr;
+    delete pObjectArray;
+    pObjectArray = nullptr;
+    if (pFrozenObjectArray)
+        pFrozenObjectArray->release();
+    pFrozenObjectArray = nullptr;
+    valueBoolean = false;
+}
+
+SMCApi::ValueType SMCApi::Value::getType() {
+    return type;
+}
+
+std::wstring* SMCApi::Value::getValueString() {
+    if (type != ValueType::VT_STRING) {
+        throw ModuleException(L"wrong type");
+    }
+    if (stringUtf8) {
+        fromUtf8(valueUtf8.data(), valueUtf8.size(), valueString);
+        stringUtf8 = false;
+    }
+    return &valueString;
+}
+
+const std::string* SMCApi::Value::getValueUtf8() {
+    if (type != ValueType::VT_STRING) {
+        throw ModuleException(L"wrong type");
+    }
+    if (!stringUtf8) {
+        valueUtf8.clear();
+        toUtf8(valueString.data(), valueString.size(), valueUtf8);
+    }
+    return &valueUtf8;
+}
+
+SMCApi::Number* SMCApi::Value::getValueNumber() {
+    if (pNumber == nullptr) {
+        throw ModuleException(L"wrong type");
+    }
+    return pNumber;
+}
+
+signed char* SMCApi::Value::getValueBytes() {
+    if (type != ValueType::VT_BYTES) {
+        throw ModuleException(L"wrong type");
+    }
+    // caller may write in bytes, bytes shared with copies of value are copied before (copy on write)
+    if (valueBytes.countReferences() > 1)
+        valueBytes = ByteBuffer(valueBytes.getData(), valueBytes.getSize());
+    return valueBytes.getWritableData();
+}
+
+size_t SMCApi::Value::getBytesCount() {
+    if (type != ValueType::VT_BYTES) {
+        throw ModuleException(L"wrong type");
+    }
+    return valueBytes.getSize();
+}
+
+const SMCApi::ByteBuffer* SMCApi::Value::getValueByteBuffer() const {
+    if (type != ValueType::VT_BYTES) {
+        throw ModuleException(L"wrong type");
+    }
+    return &valueBytes;
+}
+
+bool SMCApi::Value::getValueBoolean() {
+    if (type != ValueType::VT_BOOLEAN) {
+        throw ModuleException(L"wrong type");
+    }
+    return valueBoolean;
+}
+
+SMCApi::ObjectArray* SMCApi::Value::getValueObjectArray() {
+    if (type != ValueType::VT_OBJECT_ARRAY) {
+        throw ModuleException(L"wrong type");
+    }
+    if (pObjectArray == nullptr && pFrozenObjectArray)
+        pObjectArray = pFrozenObjectArray->thaw();
+    return pObjectArray;
+}
+
+SMCApi::FrozenObjectArray* SMCApi::Value::getValueFrozenObjectArray() {
+    return pFrozenObjectArray;
+}
+
+SMCApi::Value::~Value() {
+    clear();
+}
+
+SMCApi::ValuePool::ValuePool() : countAllocated(0) {
+}
+
+SMCApi::Value* SMCApi::ValuePool::next() {
+    Value* value;
+    if (freeValues.empty()) {
+        value = new Value();
+        countAllocated++;
+    }
+    else {
+        value = freeValues.back();
+        freeValues.pop_back();
+    }
+    usedValues.push_back(value);
+    return value;
+}
+
+SMCApi::IValue* SMCApi::ValuePool::createData(const std::wstring& value) {
+    Value* result = next();
+    result->setValue(value);
+    return result;
+}
+
+SMCApi::IValue* SMCApi::ValuePool::createData(const std::string& value) {
+    Value* result = next();
+    result->setValueUtf8(value);
+    return result;
+}
+
+SMCApi::IValue* SMCApi::ValuePool::createData(const signed char* value, long size) {
+    Value* result = next();
+    result->setValue(value, (size_t)size);
+    return result;
+}
+
+SMCApi::IValue* SMCApi::ValuePool::createData(const SMCApi::Number* value) {
+    Value* result = next();
+    result->setValue(value);
+    return result;
+}
+
+SMCApi::IValue* SMCApi::ValuePool::createData(const SMCApi::IValue* value) {
+    Value* result = next();
+    result->setValue((IValue*)value);
+    return result;
+}
+
+SMCApi::IValue* SMCApi::ValuePool::createData(const SMCApi::ObjectArray* value) {
+    Value* result = next();
+    result->setValue(std::unique_ptr<ObjectArray>(new ObjectArray(value)));
+    return result;
+}
+
+SMCApi::IValue* SMCApi::ValuePool::createData(const bool value) {
+    Value* result = next();
+    result->setValue(value);
+    return result;
+}
+
+SMCApi::IValue* SMCApi::ValuePool::createData(std::wstring&& value) {
+    Value* result = next();
+    result->setValue(std::move(value));
+    return result;
+}
+
+SMCApi::IValue* SMCApi::ValuePool::createData(std::vector<signed char>&& value) {
+    Value* result = next();
+    result->setValue(std::move(value));
+    return result;
+}
+
+SMCApi::IValue* SMCApi::ValuePool::createData(const SMCApi::ByteBuffer& value) {
+    Value* result = next();
+    result->setValue(value);
+    return result;
+}
+
+SMCApi::IValue* SMCApi::ValuePool::createData(std::unique_ptr<ObjectArray> value) {
+    Value* result = next();
+    result->setValue(std::move(value));
+    return result;
+}
+
+SMCApi::IValue* SMCApi::ValuePool::createData(SMCApi::FrozenObjectArray* value) {
+    Value* result = next();
+    result->setValue(value);
+    return result;
+}
+
+void SMCApi::ValuePool::release(SMCApi::IValue* value) {
+    for (size_t i = usedValues.size(); i > 0; --i) {
+        if (usedValues[i - 1] == value) {
+            usedValues[i - 1]->clear();
+            freeValues.push_back(usedValues[i - 1]);
+            usedValues[i - 1] = usedValues.back();
+            usedValues.pop_back();
+            return;
+        }
+    }
+}
+
+void SMCApi::ValuePool::reset() {
+    for (auto value : usedValues) {
+        value->clear();
+        freeValues.push_back(value);
+    }
+    usedValues.clear();
+}
+
+size_t SMCApi::ValuePool::countUsed() const {
+    return usedValues.size();
+}
+
+size_t SMCApi::ValuePool::countCreated() const {
+    return countAllocated;
+}
+
+void SMCApi::ValuePool::shrink() {
+    for (auto value : freeValues)
+        delete value;
+    freeValues.clear();
+    freeValues.shrink_to_fit();
+}
+
+SMCApi::ValuePool::~ValuePool() {
+    reset();
+    shrink();
+}
@@ -0,0 +1,261 @@
+/*
+Library (provider c++), is a part of the platform Shelf MK (Shell for modular structures, SMC platform).
+The author and copyright holder of the software package (application) Shelf MK (Shell for modular structures, SMC platform) is Ulyanov Nikolay Vladimirovich (ulianownv@mail.ru).
+The following are prohibited: changing and distributing the program code, selling/reselling it, as well as other actions and rights not expressly permitted.
+*/
+
+#include "SMCApi.h"
+#include "SMCApiFrozen.h"
+
+#ifndef SMCMODULEDEFINITIONPROVIDER_SMCAPIVALUE_H
+#define SMCMODULEDEFINITIONPROVIDER_SMCAPIVALUE_H
+
+namespace SMCApi {
+    /**
+     * IValue implementation
+     * value owns its data, string buffers are kept between set calls, bytes are shared with ByteBuffer copies
+     *
+     * @version 1.0.0
+     */
+    class CLASS_DECLSPEC Value : public IValue {
+    private:
+        ValueType type;
+        std::wstring valueString;
+        std::string valueUtf8;
+        bool stringUtf8;
+        Number* pNumber;
+        ByteBuffer valueBytes;
+        bool valueBoolean;
+        ObjectArray* pObjectArray;
+        FrozenObjectArray* pFrozenObjectArray;
+
+    public:
+        Value();
+
+        void setValue(const std::wstring& value);
+
+        void setValue(std::wstring&& value);
+
+        /**
+         * set string in UTF-8, wide string is created on first getValueString
+         *
+         * @param value                 UTF-8 string
+         */
+        void setValueUtf8(const std::string& value);
+
+        void setValueUtf8(std::string&& value);
+
+        void setValue(const Number* value);
+
+        void setValue(const signed char* value, size_t size);
+
+        void setValue(std::vector<signed char>&& value);
+
+        /**
+         * set bytes without copy
+         *
+         * @param value                 ByteBuffer, shared
+         */
+        void setValue(const ByteBuffer& value);
+
+        void setValue(bool value);
+
+        /**
+         * pointers of strings and arrays are not accepted (without these overloads they are converted to bool)
+         * use setValue(const std::wstring&), setValueUtf8 and setValue(std::unique_ptr<ObjectArray>)
+         */
+        void setValue(const std::wstring* value) = delete;
+
+        void setValue(const wchar_t* value) = delete;
+
+        void setValue(const char* value) = delete;
+
+        void setValue(const ObjectArray* value) = delete;
+
+        /**
+         * set ObjectArray
+         * value owns array and delete it
+         *
+         * @param value                 ObjectArray
+         */
+        void setValue(std::unique_ptr<ObjectArray> value);
+
+        /**
+         * set FrozenObjectArray without copy
+         * value adds reference and releases it on clear
+         *
+         * @param value                 FrozenObjectArray
+         */
+        void setValue(FrozenObjectArray* value);
+
+        /**
+         * copy value from other
+         *
+         * @param value                 IValue
+         */
+        void setValue(IValue* value);
+
+        /**
+         * delete data, but keep string buffers
+         */
+        void clear();
+
+        ValueType getType() override;
+
+        std::wstring* getValueString() override;
+
+        /**
+         * string in UTF-8, if string was set as wide string, it is converted on each call
+         *
+         * @return UTF-8 string, valid until next call
+         */
+        const std::string* getValueUtf8();
+
+        Number* getValueNumber() override;
+
+        /**
+         * bytes for write, bytes shared with other values are copied before (copy on write), use getValueByteBuffer for read
+         *
+         * @return bytes
+         */
+        signed char* getValueBytes() override;
+
+        size_t getBytesCount() override;
+
+        /**
+         * bytes, may be shared without copy
+         *
+         * @return ByteBuffer
+         */
+        const ByteBuffer* getValueByteBuffer() const;
+
+        bool getValueBoolean() override;
+
+        /**
+         * for frozen value mutable copy is created on first call and kept until clear
+         *
+         * @return ObjectArray
+         */
+        ObjectArray* getValueObjectArray() override;
+
+        /**
+         * frozen value, shared without copy
+         *
+         * @return FrozenObjectArray or null if value is not frozen
+         */
+        FrozenObjectArray* getValueFrozenObjectArray();
+
+        virtual ~Value();
+    };
+
+    /**
+     * IValueFactory implementation which recycle created values
+     * created values are valid until reset or release, after it they are reused by next createData
+     * usually reset is called after each process call
+     * not thread safe, use one pool per thread
+     *
+     * @version 1.0.0
+     */
+    class CLASS_DECLSPEC ValuePool : public IValueFactory {
+    private:
+        std::vector<Value*> freeValues;
+        std::vector<Value*> usedValues;
+        size_t countAllocated;
+
+        Value* next();
+
+    public:
+        ValuePool();
+
+        IValue* createData(const std::wstring& value) override;
+
+        IValue* createData(const std::string& value) override;
+
+        IValue* createData(const signed char* value, long size) override;
+
+        IValue* createData(const Number* value) override;
+
+        IValue* createData(const IValue* value) override;
+
+        IValue* createData(const ObjectArray* value) override;
+
+        IValue* createData(bool value) override;
+
+        /**
+         * create string value without copy
+         *
+         * @param value                 string
+         * @return IValue
+         */
+        IValue* createData(std::wstring&& value);
+
+        /**
+         * create bytes value without copy
+         *
+         * @param value                 bytes
+         * @return IValue
+         */
+        IValue* createData(std::vector<signed char>&& value);
+
+        /**
+         * create bytes value without copy
+         *
+         * @param value                 ByteBuffer, shared
+         * @return IValue
+         */
+        IValue* createData(const ByteBuffer& value);
+
+        /**
+         * create ObjectArray value without copy
+         * value owns array
+         *
+         * @param value                 ObjectArray
+         * @return IValue
+         */
+        IValue* createData(std::unique_ptr<ObjectArray> value);
+
+        /**
+         * create ObjectArray value without copy
+         * value adds reference to frozen array
+         *
+         * @param value                 FrozenObjectArray
+         * @return IValue
+         */
+        IValue* createData(FrozenObjectArray* value);
+
+        /**
+         * return value in pool
+         *
+         * @param value                 value created by this pool
+         */
+        void release(IValue* value);
+
+        /**
+         * return all created values in pool
+         */
+        void reset();
+
+        /**
+         * count of values in use
+         *
+         * @return size_t
+         */
+        size_t countUsed() const;
+
+        /**
+         * count of values created by new for all time
+         *
+         * @return size_t
+         */
+        size_t countCreated() const;
+
+        /**
+         * delete free values
+         */
+        void shrink();
+
+        virtual ~ValuePool();
+    };
+}
+
+#endif //SMCMODULEDEFINITIONPROVIDER_SMCAPIVALUE_H
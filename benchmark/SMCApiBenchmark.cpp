@@ -0,0 +1,606 @@
+/*
+Library (provider c++), is a part of the platform Shelf MK (Shell for modular structures, SMC platform).
+The author and copyright holder of the software package (application) Shelf MK (Shell for modular structures, SMC platform) is Ulyanov Nikolay Vladimirovich (ulianownv@mail.ru).
+The following are prohibited: changing and distributing the program code, selling/reselling it, as well as other actions and rights not expressly permitted.
+*/
+
+/*
+ micro benchmarks for data model
+ each result is printed as one JSON object per line:
+ {"name":"...","size":1000,"iterations":10,"nsPerOp":12.5,"allocsPerOp":1.0}
+ usage: SMCApiBenchmark [--max-size N] [--min-time MS] [--filter TEXT]
+*/
+
+#include "SMCApi.h"
+#include "SMCApiMessageLog.h"
+#include "SMCApiMetrics.h"
+#include "SMCApiQuery.h"
+#include "SMCApiStream.h"
+#include "SMCApiValue.h"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <new>
+
+static std::atomic<unsigned long long> countAllocations(0);
+
+void* operator new(size_t size) {
+    countAllocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size ? size : 1))
+        return p;
+    throw std::bad_alloc();
+}
+
+void* operator new[](size_t size) {
+    countAllocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size ? size : 1))
+        return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete[](void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+    std::free(p);
+}
+
+void operator delete[](void* p, size_t) noexcept {
+    std::free(p);
+}
+
+using namespace SMCApi;
+
+namespace {
+    /**
+     * one benchmark pass
+     * setup is not measured, run is measured, teardown is not measured
+     */
+    struct Benchmark {
+        const char* name;
+        size_t maxSize;
+        std::function<void*(size_t)> setup;
+        std::function<void(size_t, void*)> run;
+        std::function<void(void*)> teardown;
+    };
+
+    size_t maxSize = 1000000;
+    long long minTimeNs = 200000000LL;
+    const char* filter = nullptr;
+
+    // keeps results alive so the compiler does not drop measured code
+    volatile double sink = 0;
+
+    long long now() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    void execute(const Benchmark& benchmark) {
+        if (filter && !strstr(benchmark.name, filter))
+            return;
+        for (size_t size = 1000; size <= maxSize && size <= benchmark.maxSize; size *= 10) {
+            long long timeNs = 0;
+            unsigned long long allocations = 0;
+            size_t iterations = 0;
+            while (timeNs < minTimeNs || iterations == 0) {
+                void* state = benchmark.setup ? benchmark.setup(size) : nullptr;
+                unsigned long long allocationsStart = countAllocations.load();
+                long long start = now();
+                benchmark.run(size, state);
+                timeNs += now() - start;
+                allocations += countAllocations.load() - allocationsStart;
+                if (benchmark.teardown)
+                    benchmark.teardown(state);
+                iterations++;
+            }
+            double ops = (double)size * iterations;
+            printf("{\"name\":\"%s\",\"size\":%zu,\"iterations\":%zu,\"nsPerOp\":%.3f,\"allocsPerOp\":%.3f}\n",
+                   benchmark.name, size, iterations, timeNs / ops, allocations / ops);
+            fflush(stdout);
+        }
+    }
+
+    ObjectArray* createNumbers(size_t size) {
+        auto array = new ObjectArray(ObjectType::OT_LONG);
+        for (size_t i = 0; i < size; i++)
+            array->add(new Number((long long int)i));
+        return array;
+    }
+
+    ObjectArray* createStrings(size_t size) {
+        auto array = new ObjectArray(ObjectType::OT_STRING);
+        for (size_t i = 0; i < size; i++)
+            array->add(new std::wstring(L"value " + std::to_wstring(i)));
+        return array;
+    }
+
+    ObjectArray* createMixed(size_t size) {
+        auto array = new ObjectArray(ObjectType::OT_VALUE_ANY);
+        for (size_t i = 0; i < size; i++) {
+            if (i % 2 == 0)
+                array->add(new Number((long long int)i));
+            else
+                array->add(new std::wstring(L"value " + std::to_wstring(i)));
+        }
+        return array;
+    }
+
+    ObjectArray* createBytes(size_t size) {
+        auto array = new ObjectArray(ObjectType::OT_BYTES);
+        for (size_t i = 0; i < size; i++)
+            array->add(ByteBuffer(4096));
+        return array;
+    }
+
+    struct SumVisitor {
+        double sum;
+
+        void operator()(int, const Number* value, size_t) {
+            sum += ((Number*)value)->doubleValue();
+        }
+
+        void operator()(int, const Utf8String* value, size_t) {
+            sum += (double)value->getSize();
+        }
+
+        template<typename T>
+        void operator()(int, const T*, size_t) {
+        }
+    };
+
+    ObjectElement* createElement(size_t i) {
+        auto element = new ObjectElement();
+        element->reserve(8);
+        element->add(ObjectField(L"id", Number((long long int)i)));
+        element->add(ObjectField(L"name", Utf8String(L"name " + std::to_wstring(i))));
+        element->add(ObjectField(L"value", Number((double)i * 0.5)));
+        element->add(ObjectField(L"count", Number((long)i)));
+        element->add(ObjectField(L"enable", i % 2 == 0));
+        element->add(ObjectField(L"category", Utf8String(L"category")));
+        element->add(ObjectField(L"weight", Number((float)i)));
+        element->add(ObjectField(L"timestamp", Number((long long int)i * 1000)));
+        return element;
+    }
+
+    ObjectArray* createElements(size_t size) {
+        auto array = new ObjectArray(ObjectType::OT_OBJECT_ELEMENT);
+        for (size_t i = 0; i < size; i++)
+            array->add(createElement(i));
+        return array;
+    }
+
+    void deleteArray(void* state) {
+        delete (ObjectArray*)state;
+    }
+
+    template<typename Index>
+    struct IndexState {
+        ObjectArray* array;
+        Index* index;
+    };
+
+    template<typename Index>
+    void* createIndex(size_t size, const wchar_t* path) {
+        auto array = createElements(size);
+        return new IndexState<Index>{array, new Index(array, path)};
+    }
+
+    template<typename Index>
+    void deleteIndex(void* state) {
+        auto indexState = (IndexState<Index>*)state;
+        delete indexState->index;
+        delete indexState->array;
+        delete indexState;
+    }
+
+    std::vector<Benchmark> benchmarks() {
+        std::vector<Benchmark> result;
+
+        result.push_back({"Number/construct", 10000000, nullptr, [](size_t size, void*) {
+            for (size_t i = 0; i < size; i++) {
+                Number number((long long int)i);
+                sink = sink + (double)number.getType();
+            }
+        }, nullptr});
+        result.push_back({"Number/copy", 10000000, nullptr, [](size_t size, void*) {
+            Number source(1.5);
+            for (size_t i = 0; i < size; i++) {
+                Number number(&source);
+                sink = sink + (double)number.getType();
+            }
+        }, nullptr});
+        result.push_back({"Number/longToDouble", 10000000, [](size_t size) -> void* { return createNumbers(size); }, [](size_t size, void* state) {
+            auto array = (ObjectArray*)state;
+            double sum = 0;
+            for (size_t i = 0; i < size; i++)
+                sum += ((Number*)array->getNumber((int)i))->doubleValue();
+            sink = sum;
+        }, deleteArray});
+        result.push_back({"Number/bigDecimalToDouble", 1000000, nullptr, [](size_t size, void*) {
+            const char text[] = "12345.678";
+            double sum = 0;
+            for (size_t i = 0; i < size; i++) {
+                auto valueString = new char[sizeof(text)];
+                memcpy(valueString, text, sizeof(text));
+                Number number(NumberType::NT_BIG_DECIMAL, valueString);
+                sum += number.doubleValue();
+            }
+            sink = sum;
+        }, nullptr});
+        result.push_back({"Number/toString", 1000000, nullptr, [](size_t size, void*) {
+            size_t length = 0;
+            for (size_t i = 0; i < size; i++) {
+                Number number((long long int)i);
+                length += number.toString().size();
+            }
+            sink = (double)length;
+        }, nullptr});
+
+        result.push_back({"String/toUtf8", 10000000, [](size_t size) -> void* { return new std::wstring(size, L'a'); }, [](size_t, void* state) {
+            sink = (double)toUtf8(*(std::wstring*)state).size();
+        }, [](void* state) {
+            delete (std::wstring*)state;
+        }});
+        result.push_back({"String/fromUtf8", 10000000, [](size_t size) -> void* { return new std::string(size, 'a'); }, [](size_t, void* state) {
+            sink = (double)fromUtf8(*(std::string*)state).size();
+        }, [](void* state) {
+            delete (std::string*)state;
+        }});
+        result.push_back({"ObjectField/construct", 10000000, nullptr, [](size_t size, void*) {
+            for (size_t i = 0; i < size; i++) {
+                ObjectField field(L"field", new Number((long long int)i));
+                sink = sink + (double)field.getType();
+            }
+        }, nullptr});
+        result.push_back({"ObjectField/copy", 10000000, nullptr, [](size_t size, void*) {
+            ObjectField source(L"field", new std::wstring(L"value"));
+            for (size_t i = 0; i < size; i++) {
+                ObjectField field(&source);
+                sink = sink + (double)field.getType();
+            }
+        }, nullptr});
+        result.push_back({"ObjectField/getValueNumber", 10000000, nullptr, [](size_t size, void*) {
+            ObjectField field(L"field", new Number(2.5));
+            double sum = 0;
+            for (size_t i = 0; i < size; i++)
+                sum += ((Number*)field.getValueNumber())->doubleValue();
+            sink = sum;
+        }, nullptr});
+
+        result.push_back({"ObjectElement/construct", 1000000, nullptr, [](size_t size, void*) {
+            for (size_t i = 0; i < size; i++)
+                delete createElement(i);
+        }, nullptr});
+        result.push_back({"ObjectElement/findField", 1000000, [](size_t size) -> void* { return createElements(size); }, [](size_t size, void* state) {
+            auto array = (ObjectArray*)state;
+            const std::wstring name(L"timestamp");
+            double sum = 0;
+            for (size_t i = 0; i < size; i++)
+                sum += ((Number*)((ObjectElement*)array->getObjectElement((int)i))->findField(name)->getValueNumber())->doubleValue();
+            sink = sum;
+        }, deleteArray});
+        result.push_back({"ObjectElement/findFieldId", 1000000, [](size_t size) -> void* { return createElements(size); }, [](size_t size, void* state) {
+            auto array = (ObjectArray*)state;
+            const unsigned int nameId = SymbolTable::intern(L"timestamp");
+            double sum = 0;
+            for (size_t i = 0; i < size; i++)
+                sum += ((Number*)((ObjectElement*)array->getObjectElement((int)i))->findField(nameId)->getValueNumber())->doubleValue();
+            sink = sum;
+        }, deleteArray});
+        result.push_back({"ObjectElement/scanFields", 1000000, [](size_t size) -> void* { return createElements(size); }, [](size_t size, void* state) {
+            auto array = (ObjectArray*)state;
+            double sum = 0;
+            for (size_t i = 0; i < size; i++) {
+                const ObjectElement* element = array->getObjectElement((int)i);
+                for (size_t j = 0; j < element->size(); j++) {
+                    const Number* number = element->getField((int)j)->tryGetValueNumber();
+                    if (number)
+                        sum += ((Number*)number)->doubleValue();
+                }
+            }
+            sink = sum;
+        }, deleteArray});
+
+        result.push_back({"ObjectArray/addNumber", 10000000, nullptr, [](size_t size, void*) {
+            delete createNumbers(size);
+        }, nullptr});
+        result.push_back({"ObjectArray/addString", 10000000, nullptr, [](size_t size, void*) {
+            delete createStrings(size);
+        }, nullptr});
+        result.push_back({"ObjectArray/addUtf8", 10000000, nullptr, [](size_t size, void*) {
+            ObjectArray array(ObjectType::OT_STRING);
+            for (size_t i = 0; i < size; i++)
+                array.add(Utf8String("value " + std::to_string(i)));
+            sink = (double)array.getMemorySize();
+        }, nullptr});
+        result.push_back({"ObjectArray/addElement", 1000000, nullptr, [](size_t size, void*) {
+            delete createElements(size);
+        }, nullptr});
+        result.push_back({"ObjectArray/copyNumbers", 10000000, [](size_t size) -> void* { return createNumbers(size); }, [](size_t, void* state) {
+            ObjectArray copy((ObjectArray*)state);
+            sink = (double)copy.size();
+        }, deleteArray});
+        result.push_back({"ObjectArray/copyElements", 1000000, [](size_t size) -> void* { return createElements(size); }, [](size_t, void* state) {
+            ObjectArray copy((ObjectArray*)state);
+            sink = (double)copy.size();
+        }, deleteArray});
+        result.push_back({"ObjectArray/copyBytes", 100000, [](size_t size) -> void* { return createBytes(size); }, [](size_t, void* state) {
+            ObjectArray copy((ObjectArray*)state);
+            sink = (double)copy.getBytesCount(0);
+        }, deleteArray});
+        result.push_back({"ObjectArray/destroyElements", 1000000, [](size_t size) -> void* { return createElements(size); }, [](size_t, void* state) {
+            delete (ObjectArray*)state;
+        }, nullptr});
+        result.push_back({"ObjectArray/getString", 10000000, [](size_t size) -> void* { return createStrings(size); }, [](size_t size, void* state) {
+            auto array = (ObjectArray*)state;
+            size_t length = 0;
+            for (size_t i = 0; i < size; i++)
+                length += array->getString((int)i)->size();
+            sink = (double)length;
+        }, deleteArray});
+        result.push_back({"ObjectArray/visitMixed", 10000000, [](size_t size) -> void* { return createMixed(size); }, [](size_t, void* state) {
+            SumVisitor visitor = {0};
+            ((ObjectArray*)state)->visit(visitor);
+            sink = visitor.sum;
+        }, deleteArray});
+        result.push_back({"ObjectArray/probeException", 100000, [](size_t size) -> void* { return createMixed(size); }, [](size_t size, void* state) {
+            auto array = (ObjectArray*)state;
+            size_t count = 0;
+            for (size_t i = 0; i < size; i++) {
+                try {
+                    count += array->getString((int)i)->size();
+                } catch (ModuleException&) {
+                    count++;
+                }
+            }
+            sink = (double)count;
+        }, deleteArray});
+        result.push_back({"ObjectArray/probeTryGet", 10000000, [](size_t size) -> void* { return createMixed(size); }, [](size_t size, void* state) {
+            auto array = (ObjectArray*)state;
+            size_t count = 0;
+            for (size_t i = 0; i < size; i++) {
+                const std::wstring* value = array->tryGetString((int)i);
+                count += value ? value->size() : 1;
+            }
+            sink = (double)count;
+        }, deleteArray});
+        result.push_back({"ObjectArray/addFirst", 100000, nullptr, [](size_t size, void*) {
+            ObjectArray array(ObjectType::OT_LONG);
+            for (size_t i = 0; i < size; i++)
+                array.add(new Number((long long int)i), 0);
+            sink = (double)array.size();
+        }, nullptr});
+        result.push_back({"ObjectArray/removeFirst", 100000, [](size_t size) -> void* { return createNumbers(size); }, [](size_t size, void* state) {
+            auto array = (ObjectArray*)state;
+            for (size_t i = 0; i < size; i++)
+                array->remove(0);
+            sink = (double)array->size();
+        }, deleteArray});
+        result.push_back({"ObjectArray/removeLast", 10000000, [](size_t size) -> void* { return createNumbers(size); }, [](size_t size, void* state) {
+            auto array = (ObjectArray*)state;
+            for (size_t i = size; i > 0; i--)
+                array->remove((int)i - 1);
+            sink = (double)array->size();
+        }, deleteArray});
+        result.push_back({"ObjectArray/addFirstBulk", 10000000, nullptr, [](size_t size, void*) {
+            ObjectArray array(ObjectType::OT_LONG);
+            std::vector<Number*> values(size);
+            for (size_t i = 0; i < size; i++)
+                values[i] = new Number((long long int)i);
+            array.add(values.data(), values.size(), 0);
+            sink = (double)array.size();
+        }, nullptr});
+        result.push_back({"ObjectArray/removeFirstHalf", 10000000, [](size_t size) -> void* { return createNumbers(size); }, [](size_t size, void* state) {
+            auto array = (ObjectArray*)state;
+            array->remove(0, (int)(size / 2));
+            sink = (double)array->size();
+        }, deleteArray});
+
+        result.push_back({"ValueFactory/new", 10000000, nullptr, [](size_t size, void*) {
+            for (size_t i = 0; i < size; i++) {
+                auto value = new Value();
+                value->setValue(std::wstring(L"message value"));
+                sink = sink + (double)value->getValueString()->size();
+                delete value;
+            }
+        }, nullptr});
+        result.push_back({"ValueFactory/pool", 10000000, [](size_t) -> void* {
+            auto pool = new ValuePool();
+            for (int i = 0; i < 100; i++)
+                pool->createData(std::wstring(L"message value"));
+            pool->reset();
+            return pool;
+        }, [](size_t size, void* state) {
+            auto pool = (ValuePool*)state;
+            const std::wstring text(L"message value");
+            for (size_t i = 0; i < size; i++) {
+                IValue* value = pool->createData(text);
+                sink = sink + (double)value->getValueString()->size();
+                if (i % 100 == 99)
+                    pool->reset();
+            }
+        }, [](void* state) {
+            delete (ValuePool*)state;
+        }});
+
+        result.push_back({"LatencyHistogram/record", 10000000, [](size_t) -> void* { return new LatencyHistogram(); }, [](size_t size, void* state) {
+            auto histogram = (LatencyHistogram*)state;
+            for (size_t i = 0; i < size; i++)
+                histogram->record((long long int)(i * 7919 % 1000000));
+            sink = (double)histogram->count();
+        }, [](void* state) {
+            delete (LatencyHistogram*)state;
+        }});
+
+        result.push_back({"Query/aggregate", 10000000, [](size_t size) -> void* { return createNumbers(size); }, [](size_t, void* state) {
+            sink = aggregate((ObjectArray*)state).variance();
+        }, deleteArray});
+        result.push_back({"Query/aggregateField", 1000000, [](size_t size) -> void* { return createElements(size); }, [](size_t, void* state) {
+            sink = aggregate((ObjectArray*)state, L"value").variance();
+        }, deleteArray});
+        result.push_back({"Query/groupBy", 1000000, [](size_t size) -> void* { return createElements(size); }, [](size_t, void* state) {
+            GroupBy groupBy;
+            groupBy.key(L"enable").aggregate(AF_COUNT, L"", L"count").aggregate(AF_SUM, L"value", L"sum");
+            ObjectArray* groups = groupBy.execute((ObjectArray*)state);
+            sink = (double)groups->size();
+            delete groups;
+        }, deleteArray});
+        result.push_back({"Query/groupByParallel", 1000000, [](size_t size) -> void* { return createElements(size); }, [](size_t, void* state) {
+            GroupBy groupBy;
+            groupBy.key(L"id").aggregate(AF_COUNT, L"", L"count").aggregate(AF_SUM, L"value", L"sum");
+            ObjectArray* groups = groupBy.execute((ObjectArray*)state, 0);
+            sink = (double)groups->size();
+            delete groups;
+        }, deleteArray});
+        result.push_back({"Query/sort", 1000000, [](size_t size) -> void* { return createElements(size); }, [](size_t, void* state) {
+            OrderBy().key(L"weight", true).sort((ObjectArray*)state);
+            sink = (double)((ObjectArray*)state)->size();
+        }, deleteArray});
+        result.push_back({"Query/top", 1000000, [](size_t size) -> void* { return createElements(size); }, [](size_t, void* state) {
+            sink = (double)OrderBy().key(L"value", true).order((ObjectArray*)state, 100).size();
+        }, deleteArray});
+        result.push_back({"Query/hashJoin", 1000000, [](size_t size) -> void* { return createElements(size); }, [](size_t, void* state) {
+            static ObjectArray* reference = createElements(1000);
+            static HashJoin join(reference, {L"id"});
+            sink = (double)join.match((ObjectArray*)state, {L"count"}, JT_INNER).size();
+        }, deleteArray});
+        result.push_back({"Query/hashIndexFind", 1000000, [](size_t size) -> void* { return createIndex<HashIndex>(size, L"id"); }, [](size_t size, void* state) {
+            auto index = ((IndexState<HashIndex>*)state)->index;
+            size_t count = 0;
+            for (size_t i = 0; i < size; i++)
+                count += index->findFirst((long long int)((i * 7919) % size)) != nullptr;
+            sink = (double)count;
+        }, deleteIndex<HashIndex>});
+        result.push_back({"Query/sortedIndexRange", 1000000, [](size_t size) -> void* { return createIndex<SortedIndex>(size, L"value"); }, [](size_t size, void* state) {
+            auto index = ((IndexState<SortedIndex>*)state)->index;
+            size_t count = 0;
+            for (size_t i = 0; i < size; i += 10)
+                count += index->range((double)i * 0.5, (double)(i + 10) * 0.5).size();
+            sink = (double)count;
+        }, deleteIndex<SortedIndex>});
+        result.push_back({"Query/indexMaintain", 1000000, [](size_t size) -> void* { return createIndex<HashIndex>(size, L"id"); }, [](size_t size, void* state) {
+            auto array = ((IndexState<HashIndex>*)state)->array;
+            array->remove(0, (int)(size / 10));
+            for (size_t i = 0; i < size / 10; i++)
+                array->add(createElement(i));
+            sink = (double)((IndexState<HashIndex>*)state)->index->size();
+        }, deleteIndex<HashIndex>});
+        result.push_back({"Stream/slidingWindow", 10000000, nullptr, [](size_t size, void*) {
+            SlidingWindow window(WT_TIME, 10000);
+            for (size_t i = 0; i < size; i++)
+                window.add((long long int)i, (double)((i * 7919) % 1000));
+            sink = window.mean() + window.max() - window.min();
+        }, nullptr});
+        result.push_back({"Stream/slidingWindowPercentile", 1000000, nullptr, [](size_t size, void*) {
+            SlidingWindow window(WT_COUNT, 10000, true);
+            for (size_t i = 0; i < size; i++)
+                window.add((long long int)i, (double)((i * 7919) % 1000));
+            sink = window.percentile(99);
+        }, nullptr});
+        result.push_back({"Stream/hyperLogLog", 10000000, nullptr, [](size_t size, void*) {
+            HyperLogLog sketch;
+            for (size_t i = 0; i < size; i++)
+                sketch.addHash(sketchHash((long long int)i));
+            sink = sketch.estimate();
+        }, nullptr});
+        result.push_back({"Stream/countMinSketch", 10000000, nullptr, [](size_t size, void*) {
+            CountMinSketch sketch;
+            for (size_t i = 0; i < size; i++)
+                sketch.addHash(sketchHash((long long int)(i % 1000)));
+            sink = (double)sketch.estimateHash(sketchHash(1LL));
+        }, nullptr});
+        result.push_back({"Stream/tDigest", 10000000, nullptr, [](size_t size, void*) {
+            TDigest digest;
+            for (size_t i = 0; i < size; i++)
+                digest.add((double)((i * 7919) % 100000));
+            sink = digest.percentile(99);
+        }, nullptr});
+        result.push_back({"Stream/timeSeriesAdd", 10000000, nullptr, [](size_t size, void*) {
+            TimeSeries series;
+            for (size_t i = 0; i < size; i++)
+                series.add((long long int)i * 1000, (double)(i % 100));
+            sink = (double)series.getMemorySize();
+        }, nullptr});
+        result.push_back({"Stream/timeSeriesScan", 10000000, [](size_t size) -> void* {
+            auto series = new TimeSeries();
+            for (size_t i = 0; i < size; i++)
+                series->add((long long int)i * 1000, (double)(i % 100));
+            return series;
+        }, [](size_t size, void* state) {
+            std::vector<long long int> dates;
+            std::vector<double> values;
+            sink = (double)((TimeSeries*)state)->scan(0, (long long int)size * 1000, dates, values);
+        }, [](void* state) {
+            delete (TimeSeries*)state;
+        }});
+        result.push_back({"MessageLog/append", 1000000, nullptr, [](size_t size, void*) {
+            removeMessageLog(L"SMCApiBenchmarkLog");
+            MessageLogOptions options;
+            options.syncPolicy = LSP_NONE;
+            MessageLogWriter writer(L"SMCApiBenchmarkLog", options);
+            Number number(0.5);
+            Value value;
+            value.setValue(&number);
+            for (size_t i = 0; i < size; i++)
+                writer.append(MESSAGE_DATA, (long long int)i, &value);
+            writer.flush();
+            sink = (double)writer.nextSequence();
+        }, [](void*) {
+            removeMessageLog(L"SMCApiBenchmarkLog");
+        }});
+        result.push_back({"MessageLog/replay", 1000000, [](size_t size) -> void* {
+            removeMessageLog(L"SMCApiBenchmarkLog");
+            MessageLogOptions options;
+            options.syncPolicy = LSP_NONE;
+            MessageLogWriter writer(L"SMCApiBenchmarkLog", options);
+            Value value;
+            value.setValue(std::wstring(L"value"));
+            for (size_t i = 0; i < size; i++)
+                writer.append(MESSAGE_DATA, (long long int)i, &value);
+            return nullptr;
+        }, [](size_t, void*) {
+            MessageLogReader reader(L"SMCApiBenchmarkLog");
+            long long int sum = 0;
+            while (reader.next())
+                sum += reader.getMessage()->getDate();
+            sink = (double)sum;
+        }, [](void*) {
+            removeMessageLog(L"SMCApiBenchmarkLog");
+        }});
+        result.push_back({"Query/aggregateDoubles", 10000000, [](size_t size) -> void* {
+            auto values = new std::vector<double>(size);
+            for (size_t i = 0; i < size; i++)
+                (*values)[i] = (double)(i % 1000);
+            return values;
+        }, [](size_t size, void* state) {
+            Aggregation aggregation;
+            aggregation.add(((std::vector<double>*)state)->data(), size);
+            sink = aggregation.variance();
+        }, [](void* state) {
+            delete (std::vector<double>*)state;
+        }});
+        return result;
+    }
+}
+
+int main(int argc, char** argv) {
+    for (int i = 1; i + 1 < argc; i += 2) {
+        if (strcmp(argv[i], "--max-size") == 0)
+            maxSize = (size_t)std::strtoull(argv[i + 1], nullptr, 10);
+        else if (strcmp(argv[i], "--min-time") == 0)
+            minTimeNs = std::strtoll(argv[i + 1], nullptr, 10) * 1000000LL;
+        else if (strcmp(argv[i], "--filter") == 0)
+            filter = argv[i + 1];
+    }
+    for (const Benchmark& benchmark : benchmarks())
+        execute(benchmark);
+    return 0;
+}
@@ -0,0 +1,920 @@
+/*
+Library (provider c++), is a part of the platform Shelf MK (Shell for modular structures, SMC platform).
+The author and copyright holder of the software package (application) Shelf MK (Shell for modular structures, SMC platform) is Ulyanov Nikolay Vladimirovich (ulianownv@mail.ru).
+The following are prohibited: changing and distributing the program code, selling/reselling it, as well as other actions and rights not expressly permitted.
+*/
+
+#include "SMCApiMock.h"
+#include <chrono>
+#include <cstdio>
+
+namespace {
+    long long int currentDate() {
+        return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+    }
+
+    void log(int level, int logLevel, const wchar_t* prefix, const std::wstring& text) {
+        if (level >= logLevel)
+            fprintf(stderr, "%ls %s\n", prefix, SMCApi::toUtf8(text).c_str());
+    }
+
+    SMCApi::Value* copyValue(SMCApi::IValue* value) {
+        auto result = new SMCApi::Value();
+        result->setValue(value);
+        return result;
+    }
+}
+
+SMCApi::MockMessage::MockMessage(long long int date, SMCApi::MessageType messageType) : date(date), messageType(messageType) {
+}
+
+SMCApi::Value& SMCApi::MockMessage::getValue() {
+    return value;
+}
+
+SMCApi::ValueType SMCApi::MockMessage::getType() {
+    return value.getType();
+}
+
+std::wstring* SMCApi::MockMessage::getValueString() {
+    return value.getValueString();
+}
+
+SMCApi::Number* SMCApi::MockMessage::getValueNumber() {
+    return value.getValueNumber();
+}
+
+signed char* SMCApi::MockMessage::getValueBytes() {
+    return value.getValueBytes();
+}
+
+size_t SMCApi::MockMessage::getBytesCount() {
+    return value.getBytesCount();
+}
+
+bool SMCApi::MockMessage::getValueBoolean() {
+    return value.getValueBoolean();
+}
+
+SMCApi::ObjectArray* SMCApi::MockMessage::getValueObjectArray() {
+    return value.getValueObjectArray();
+}
+
+long long int SMCApi::MockMessage::getDate() {
+    return date;
+}
+
+SMCApi::MessageType SMCApi::MockMessage::getMessageType() {
+    return messageType;
+}
+
+SMCApi::MockMessage::~MockMessage() {
+}
+
+SMCApi::MockAction::MockAction(SMCApi::ActionType type) : type(type) {
+}
+
+std::vector<SMCApi::IMessage*>* SMCApi::MockAction::getMessages() {
+    return &messages;
+}
+
+SMCApi::ActionType SMCApi::MockAction::getType() {
+    return type;
+}
+
+SMCApi::MockAction::~MockAction() {
+    messages.clear();
+}
+
+SMCApi::MockCommand::MockCommand(SMCApi::CommandType type) : type(type) {
+}
+
+std::vector<SMCApi::IAction*>* SMCApi::MockCommand::getActions() {
+    return &actions;
+}
+
+SMCApi::CommandType SMCApi::MockCommand::getType() {
+    return type;
+}
+
+SMCApi::MockCommand::~MockCommand() {
+    for (auto action : actions)
+        delete (MockAction*)action;
+    actions.clear();
+}
+
+SMCApi::MockModule::MockModule(const std::wstring& name) : name(name) {
+}
+
+std::wstring SMCApi::MockModule::getName() {
+    return name;
+}
+
+long SMCApi::MockModule::countTypes() {
+    return 1;
+}
+
+std::wstring SMCApi::MockModule::getTypeName(long) {
+    return L"default";
+}
+
+long SMCApi::MockModule::getMinCountSources(long) {
+    return 0;
+}
+
+long SMCApi::MockModule::getMaxCountSources(long) {
+    return -1;
+}
+
+long SMCApi::MockModule::getMinCountExecutionContexts(long) {
+    return 0;
+}
+
+long SMCApi::MockModule::getMaxCountExecutionContexts(long) {
+    return -1;
+}
+
+long SMCApi::MockModule::getMinCountManagedConfigurations(long) {
+    return 0;
+}
+
+long SMCApi::MockModule::getMaxCountManagedConfigurations(long) {
+    return -1;
+}
+
+SMCApi::MockConfiguration::MockConfiguration(const std::wstring& moduleName, const std::wstring& name)
+    : module(moduleName), name(name), bufferSize(1), threadBufferSize(1), enable(true), active(false) {
+}
+
+SMCApi::CFGIModule* SMCApi::MockConfiguration::getModule() {
+    return &module;
+}
+
+std::wstring SMCApi::MockConfiguration::getName() {
+    return name;
+}
+
+std::wstring SMCApi::MockConfiguration::getDescription() {
+    return description;
+}
+
+long SMCApi::MockConfiguration::getBufferSize() {
+    return bufferSize;
+}
+
+int long long SMCApi::MockConfiguration::getThreadBufferSize() {
+    return threadBufferSize;
+}
+
+bool SMCApi::MockConfiguration::isEnable() {
+    return enable;
+}
+
+bool SMCApi::MockConfiguration::isActive() {
+    return active;
+}
+
+SMCApi::MockSource::MockSource(SMCApi::SourceGetType getType, long countLast, long messagesPerCall, const SMCApi::MockGenerator& generator)
+    : sourceGetType(getType), countLast(countLast < 1 ? 1 : countLast), eventDriven(false), messagesPerCall(messagesPerCall),
+      generator(generator), counter(0), pAction(nullptr) {
+}
+
+long SMCApi::MockSource::generate(long long int date) {
+    if (sourceGetType == SourceGetType::SGT_NEW || sourceGetType == SourceGetType::SGT_NEW_ALL) {
+        for (auto message : messages)
+            delete message;
+        messages.clear();
+    }
+    for (long i = 0; i < messagesPerCall; i++) {
+        auto message = new MockMessage(date, MessageType::MESSAGE_DATA);
+        generator(counter++, message->getValue());
+        messages.push_back(message);
+    }
+    if (sourceGetType == SourceGetType::SGT_LAST || sourceGetType == SourceGetType::SGT_LAST_ALL) {
+        while (messages.size() > (size_t)countLast) {
+            delete messages.front();
+            messages.pop_front();
+        }
+    }
+    delete pAction;
+    pAction = nullptr;
+    if (!messages.empty()) {
+        pAction = new MockAction(ActionType::ACTION_EXECUTE);
+        pAction->getMessages()->assign(messages.begin(), messages.end());
+    }
+    return messagesPerCall;
+}
+
+SMCApi::MockAction* SMCApi::MockSource::getAction() {
+    return pAction;
+}
+
+SMCApi::SourceType SMCApi::MockSource::getType() {
+    return SourceType::ST_MODULE_CONFIGURATION;
+}
+
+long SMCApi::MockSource::countParams() {
+    return 4;
+}
+
+void* SMCApi::MockSource::getParam(long id) {
+    switch (id) {
+    case 1:
+        return &sourceGetType;
+    case 2:
+        return &countLast;
+    case 3:
+        return &eventDriven;
+    default:
+        return nullptr;
+    }
+}
+
+long SMCApi::MockSource::countFilters() {
+    return 0;
+}
+
+SMCApi::CFGISourceFilter* SMCApi::MockSource::getFilter(long) {
+    return nullptr;
+}
+
+SMCApi::MockSource::~MockSource() {
+    delete pAction;
+    pAction = nullptr;
+    for (auto message : messages)
+        delete message;
+    messages.clear();
+}
+
+SMCApi::MockExecutionContext::MockExecutionContext(SMCApi::MockConfiguration* pConfiguration, const std::wstring& name)
+    : pConfiguration(pConfiguration), name(name), maxWorkInterval(-1), enable(true), active(false) {
+}
+
+long SMCApi::MockExecutionContext::countSource() {
+    return (long)sources.size();
+}
+
+SMCApi::CFGISource* SMCApi::MockExecutionContext::getSource(long id) {
+    return id >= 0 && (size_t)id < sources.size() ? sources[id] : nullptr;
+}
+
+SMCApi::CFGIConfiguration* SMCApi::MockExecutionContext::getConfiguration() {
+    return pConfiguration;
+}
+
+std::wstring SMCApi::MockExecutionContext::getName() {
+    return name;
+}
+
+long SMCApi::MockExecutionContext::getMaxWorkInterval() {
+    return maxWorkInterval;
+}
+
+bool SMCApi::MockExecutionContext::isEnable() {
+    return enable;
+}
+
+bool SMCApi::MockExecutionContext::isActive() {
+    return active;
+}
+
+std::wstring SMCApi::MockExecutionContext::getType() {
+    return type;
+}
+
+SMCApi::MockExecutionContext::~MockExecutionContext() {
+    for (auto source : sources)
+        delete source;
+    sources.clear();
+}
+
+SMCApi::MockConfigurationTool::MockConfigurationTool(SMCApi::MockConfiguration* pConfiguration, SMCApi::MockExecutionContext* pExecutionContext,
+                                                     const std::wstring& homeFolder, const std::wstring& workDirectory)
+    : pConfiguration(pConfiguration), pExecutionContext(pExecutionContext), pHomeFolder(new FileTool(homeFolder)), workDirectory(workDirectory),
+      logLevel(2) {
+}
+
+void SMCApi::MockConfigurationTool::setSetting(const std::wstring& key, SMCApi::IValue* value) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = settings.find(key);
+    if (it != settings.end())
+        delete it->second;
+    settings[key] = copyValue(value);
+}
+
+void SMCApi::MockConfigurationTool::setVariableExternal(const std::wstring& key, SMCApi::IValue* value) {
+    setVariable(key, value);
+    std::lock_guard<std::mutex> lock(mutex);
+    changedVariables[key] = true;
+}
+
+void SMCApi::MockConfigurationTool::setInfo(const std::wstring& key, const std::function<void(Value&)>& provider) {
+    std::lock_guard<std::mutex> lock(mutex);
+    infoProviders[key] = provider;
+}
+
+std::vector<std::wstring> SMCApi::MockConfigurationTool::getAllSettingNames() {
+    std::lock_guard<std::mutex> lock(mutex);
+    std::vector<std::wstring> result;
+    for (auto& setting : settings)
+        result.push_back(setting.first);
+    return result;
+}
+
+SMCApi::IValue* SMCApi::MockConfigurationTool::getSetting(const std::wstring& key) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = settings.find(key);
+    return it != settings.end() ? it->second : nullptr;
+}
+
+std::vector<std::wstring> SMCApi::MockConfigurationTool::getAllVariableNames() {
+    std::lock_guard<std::mutex> lock(mutex);
+    std::vector<std::wstring> result;
+    for (auto& variable : variables)
+        result.push_back(variable.first);
+    return result;
+}
+
+SMCApi::IValue* SMCApi::MockConfigurationTool::getVariable(const std::wstring& key) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = variables.find(key);
+    return it != variables.end() ? it->second : nullptr;
+}
+
+void SMCApi::MockConfigurationTool::setVariable(const std::wstring& key, SMCApi::IValue* value) {
+    Value* copy = copyValue(value);
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = variables.find(key);
+    if (it != variables.end())
+        delete it->second;
+    variables[key] = copy;
+}
+
+bool SMCApi::MockConfigurationTool::isVariableChanged(const std::wstring& key) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = changedVariables.find(key);
+    if (it == changedVariables.end() || !it->second)
+        return false;
+    it->second = false;
+    return true;
+}
+
+void SMCApi::MockConfigurationTool::removeVariable(const std::wstring& key) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = variables.find(key);
+    if (it == variables.end())
+        return;
+    delete it->second;
+    variables.erase(it);
+}
+
+SMCApi::IFileTool* SMCApi::MockConfigurationTool::getHomeFolder() {
+    return pHomeFolder;
+}
+
+std::wstring SMCApi::MockConfigurationTool::getWorkDirectory() {
+    return workDirectory;
+}
+
+long SMCApi::MockConfigurationTool::countExecutionContexts() {
+    return 1;
+}
+
+SMCApi::CFGIExecutionContext* SMCApi::MockConfigurationTool::getExecutionContext(long id) {
+    return id == 0 ? pExecutionContext : nullptr;
+}
+
+SMCApi::CFGIConfiguration* SMCApi::MockConfigurationTool::getConfiguration() {
+    return pConfiguration;
+}
+
+SMCApi::CFGIContainerManaged* SMCApi::MockConfigurationTool::getContainer() {
+    return nullptr;
+}
+
+void SMCApi::MockConfigurationTool::loggerTrace(const std::wstring& text) {
+    log(0, logLevel, L"TRACE", text);
+}
+
+void SMCApi::MockConfigurationTool::loggerDebug(const std::wstring& text) {
+    log(1, logLevel, L"DEBUG", text);
+}
+
+void SMCApi::MockConfigurationTool::loggerInfo(const std::wstring& text) {
+    log(2, logLevel, L"INFO", text);
+}
+
+void SMCApi::MockConfigurationTool::loggerWarn(const std::wstring& text) {
+    log(3, logLevel, L"WARN", text);
+}
+
+void SMCApi::MockConfigurationTool::loggerError(const std::wstring& text) {
+    log(4, logLevel, L"ERROR", text);
+}
+
+SMCApi::IValue* SMCApi::MockConfigurationTool::getInfo(const std::wstring& key) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = infoProviders.find(key);
+    if (it == infoProviders.end())
+        return nullptr;
+    it->second(info);
+    return &info;
+}
+
+SMCApi::MockConfigurationTool::~MockConfigurationTool() {
+    for (auto& setting : settings)
+        delete setting.second;
+    settings.clear();
+    for (auto& variable : variables)
+        delete variable.second;
+    variables.clear();
+    delete pHomeFolder;
+    pHomeFolder = nullptr;
+}
+
+struct SMCApi::MockFlowControlTool::Managed {
+    MockExecutionContext executionContext;
+    MockManagedHandler handler;
+    std::vector<MockMessage*> messages;
+    std::vector<IAction*> actions;
+    std::vector<ICommand*> commands;
+
+    Managed(MockConfiguration* pConfiguration, const std::wstring& name, const MockManagedHandler& handler)
+        : executionContext(pConfiguration, name), handler(handler) {
+    }
+
+    void clear() {
+        for (auto command : commands)
+            delete (MockCommand*)command;
+        commands.clear();
+        actions.clear();
+        for (auto message : messages)
+            delete message;
+        messages.clear();
+    }
+
+    /**
+     * execute handler and save result as one action
+     */
+    void execute(CommandType type, std::vector<IValue*>* values) {
+        clear();
+        ValuePool pool;
+        std::vector<IValue*> result;
+        executionContext.active = true;
+        try {
+            handler(type, values, &pool, result);
+        } catch (...) {
+            executionContext.active = false;
+            throw;
+        }
+        executionContext.active = false;
+        auto command = new MockCommand(type);
+        auto action = new MockAction(ActionType::ACTION_EXECUTE);
+        long long int date = currentDate();
+        for (auto value : result) {
+            auto message = new MockMessage(date, MessageType::MESSAGE_DATA);
+            message->getValue().setValue(value);
+            messages.push_back(message);
+            action->getMessages()->push_back(message);
+        }
+        command->getActions()->push_back(action);
+        commands.push_back(command);
+        actions.push_back(action);
+    }
+
+    /**
+     * save exception of handler as one action with error message
+     */
+    void fail(CommandType type, const std::wstring& text) {
+        clear();
+        auto command = new MockCommand(type);
+        auto action = new MockAction(ActionType::ACTION_EXECUTE);
+        auto message = new MockMessage(currentDate(), MessageType::MESSAGE_ERROR);
+        message->getValue().setValue(text);
+        messages.push_back(message);
+        action->getMessages()->push_back(message);
+        command->getActions()->push_back(action);
+        commands.push_back(command);
+        actions.push_back(action);
+    }
+
+    ~Managed() {
+        clear();
+    }
+};
+
+struct SMCApi::MockFlowControlTool::Thread {
+    std::thread thread;
+    std::atomic<bool> active;
+    long managedId;
+    Managed* pManaged;
+    std::vector<Value*> values;
+    std::vector<IAction*> empty;
+    std::vector<ICommand*> emptyCommands;
+
+    Thread(Managed* pManaged, long managedId, CommandType type, std::vector<IValue*>* values, long waitingMilliseconds,
+           std::atomic<long long int>& countExceptions)
+        : active(true), managedId(managedId),
+          pManaged(new Managed((MockConfiguration*)pManaged->executionContext.getConfiguration(), pManaged->executionContext.getName(),
+                               pManaged->handler)) {
+        if (values) {
+            for (auto value : *values)
+                Thread::values.push_back(copyValue(value));
+        }
+        thread = std::thread([this, type, waitingMilliseconds, &countExceptions]() {
+            if (waitingMilliseconds > 0)
+                std::this_thread::sleep_for(std::chrono::milliseconds(waitingMilliseconds));
+            std::vector<IValue*> input(Thread::values.begin(), Thread::values.end());
+            // exception should not leave thread (std::terminate), it is saved as error message
+            try {
+                Thread::pManaged->execute(type, &input);
+            } catch (ModuleException& e) {
+                Thread::pManaged->fail(type, e.getMessageText());
+                countExceptions++;
+            } catch (std::exception& e) {
+                Thread::pManaged->fail(type, fromUtf8(e.what()));
+                countExceptions++;
+            } catch (...) {
+                Thread::pManaged->fail(type, L"unknown exception");
+                countExceptions++;
+            }
+            active = false;
+        });
+    }
+
+    void join() {
+        if (thread.joinable())
+            thread.join();
+    }
+
+    ~Thread() {
+        join();
+        delete pManaged;
+        for (auto value : values)
+            delete value;
+        values.clear();
+    }
+};
+
+SMCApi::MockFlowControlTool::MockFlowControlTool(SMCApi::MockConfiguration* pConfiguration)
+    : pConfiguration(pConfiguration), lastThreadId(0), tactMilliseconds(1), countExceptions(0) {
+}
+
+SMCApi::MockFlowControlTool::Thread* SMCApi::MockFlowControlTool::findThread(long long int threadId) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = threads.find(threadId);
+    return it != threads.end() ? it->second : nullptr;
+}
+
+long SMCApi::MockFlowControlTool::addManaged(const std::wstring& name, const SMCApi::MockManagedHandler& handler) {
+    managed.push_back(new Managed(pConfiguration, name, handler));
+    return (long)managed.size() - 1;
+}
+
+void SMCApi::MockFlowControlTool::clear() {
+    for (auto pManaged : managed)
+        pManaged->clear();
+}
+
+long SMCApi::MockFlowControlTool::countManagedExecutionContexts() {
+    return (long)managed.size();
+}
+
+void SMCApi::MockFlowControlTool::executeNow(SMCApi::CommandType type, long managedId, std::vector<IValue*>* values) {
+    if (managedId < 0 || (size_t)managedId >= managed.size()) {
+        throw ModuleException(L"wrong managed id");
+    }
+    managed[managedId]->execute(type, values);
+}
+
+long long int SMCApi::MockFlowControlTool::executeParallel(SMCApi::CommandType type, long managedId, std::vector<IValue*>* values, long waitingTacts,
+                                                           long) {
+    if (managedId < 0 || (size_t)managedId >= managed.size()) {
+        throw ModuleException(L"wrong managed id");
+    }
+    auto pThread = new Thread(managed[managedId], managedId, type, values, waitingTacts * tactMilliseconds, countExceptions);
+    std::lock_guard<std::mutex> lock(mutex);
+    long long int threadId = ++lastThreadId;
+    threads[threadId] = pThread;
+    return threadId;
+}
+
+bool SMCApi::MockFlowControlTool::isThreadActive(long long int threadId) {
+    Thread* pThread = findThread(threadId);
+    return pThread && pThread->active;
+}
+
+std::vector<SMCApi::IAction*>* SMCApi::MockFlowControlTool::getMessagesFromExecuted(long managedId) {
+    if (managedId < 0 || (size_t)managedId >= managed.size()) {
+        throw ModuleException(L"wrong managed id");
+    }
+    return &managed[managedId]->actions;
+}
+
+std::vector<SMCApi::IAction*>* SMCApi::MockFlowControlTool::getMessagesFromExecuted(long long int threadId, long managedId) {
+    Thread* pThread = findThread(threadId);
+    if (pThread == nullptr) {
+        throw ModuleException(L"wrong thread id");
+    }
+    if (pThread->active || pThread->managedId != managedId)
+        return &pThread->empty;
+    pThread->join();
+    return &pThread->pManaged->actions;
+}
+
+std::vector<SMCApi::ICommand*>* SMCApi::MockFlowControlTool::getCommandsFromExecuted(long managedId) {
+    if (managedId < 0 || (size_t)managedId >= managed.size()) {
+        throw ModuleException(L"wrong managed id");
+    }
+    return &managed[managedId]->commands;
+}
+
+std::vector<SMCApi::ICommand*>* SMCApi::MockFlowControlTool::getCommandsFromExecuted(long long int threadId, long managedId) {
+    Thread* pThread = findThread(threadId);
+    if (pThread == nullptr) {
+        throw ModuleException(L"wrong thread id");
+    }
+    if (pThread->active || pThread->managedId != managedId)
+        return &pThread->emptyCommands;
+    pThread->join();
+    return &pThread->pManaged->commands;
+}
+
+void SMCApi::MockFlowControlTool::releaseThread(long long int threadId) {
+    Thread* pThread;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = threads.find(threadId);
+        if (it == threads.end())
+            return;
+        pThread = it->second;
+        threads.erase(it);
+    }
+    delete pThread;
+}
+
+void SMCApi::MockFlowControlTool::releaseThreadCache(long long int threadId) {
+    releaseThread(threadId);
+}
+
+SMCApi::CFGIExecutionContext* SMCApi::MockFlowControlTool::getManagedExecutionContext(int id) {
+    return id >= 0 && (size_t)id < managed.size() ? &managed[id]->executionContext : nullptr;
+}
+
+SMCApi::MockFlowControlTool::~MockFlowControlTool() {
+    for (auto& thread : threads)
+        delete thread.second;
+    threads.clear();
+    for (auto pManaged : managed)
+        delete pManaged;
+    managed.clear();
+}
+
+SMCApi::MockExecutionContextTool::MockExecutionContextTool(SMCApi::MockExecutionContext* pExecutionContext,
+                                                           SMCApi::MockFlowControlTool* pFlowControlTool)
+    : pExecutionContext(pExecutionContext), pFlowControlTool(pFlowControlTool), keepOutput(false), needStop(false), countMessages(0),
+      countErrors(0), countLogs(0) {
+}
+
+void SMCApi::MockExecutionContextTool::clear() {
+    for (auto command : createdCommands) {
+        command->getActions()->clear();
+        delete command;
+    }
+    createdCommands.clear();
+}
+
+void SMCApi::MockExecutionContextTool::addMessage(SMCApi::IValue* value) {
+    countMessages++;
+    if (keepOutput) {
+        auto message = new MockMessage(currentDate(), MessageType::MESSAGE_DATA);
+        message->getValue().setValue(value);
+        output.push_back(message);
+    }
+}
+
+void SMCApi::MockExecutionContextTool::addError(SMCApi::IValue* value) {
+    countErrors++;
+    if (keepOutput) {
+        auto message = new MockMessage(currentDate(), MessageType::MESSAGE_ERROR);
+        message->getValue().setValue(value);
+        output.push_back(message);
+    }
+}
+
+void SMCApi::MockExecutionContextTool::addLog(const std::wstring& text) {
+    countLogs++;
+    if (keepOutput) {
+        auto message = new MockMessage(currentDate(), MessageType::MESSAGE_LOG);
+        message->getValue().setValue(text);
+        output.push_back(message);
+    }
+}
+
+long SMCApi::MockExecutionContextTool::countCommands(long sourceId) {
+    MockSource* pSource = sourceId >= 0 && (size_t)sourceId < pExecutionContext->sources.size() ? pExecutionContext->sources[sourceId] : nullptr;
+    return pSource && pSource->getAction() ? 1 : 0;
+}
+
+long SMCApi::MockExecutionContextTool::countCommands(SMCApi::CFGIExecutionContextManaged*) {
+    return 0;
+}
+
+std::vector<SMCApi::IAction*>* SMCApi::MockExecutionContextTool::getMessages(long sourceId) {
+    return getMessages(sourceId, 0, countCommands(sourceId));
+}
+
+std::vector<SMCApi::IAction*>* SMCApi::MockExecutionContextTool::getMessages(long sourceId, long fromIndex, long toIndex) {
+    actions.clear();
+    if (fromIndex <= 0 && toIndex >= 1 && countCommands(sourceId) > 0)
+        actions.push_back(pExecutionContext->sources[sourceId]->getAction());
+    return &actions;
+}
+
+std::vector<SMCApi::ICommand*>* SMCApi::MockExecutionContextTool::getCommands(long sourceId) {
+    return getCommands(sourceId, 0, countCommands(sourceId));
+}
+
+std::vector<SMCApi::ICommand*>* SMCApi::MockExecutionContextTool::getCommands(long sourceId, long fromIndex, long toIndex) {
+    commands.clear();
+    std::vector<IAction*>* pActions = getMessages(sourceId, fromIndex, toIndex);
+    if (!pActions->empty()) {
+        auto command = new MockCommand(CommandType::COMMAND_EXECUTE);
+        command->getActions()->assign(pActions->begin(), pActions->end());
+        createdCommands.push_back(command);
+        commands.push_back(command);
+    }
+    return &commands;
+}
+
+std::vector<SMCApi::ICommand*>* SMCApi::MockExecutionContextTool::getCommands(SMCApi::CFGIExecutionContextManaged*, long,
+                                                                             long) {
+    commands.clear();
+    return &commands;
+}
+
+bool SMCApi::MockExecutionContextTool::isError(SMCApi::IAction*) {
+    return false;
+}
+
+SMCApi::IConfigurationControlTool* SMCApi::MockExecutionContextTool::getConfigurationControlTool() {
+    return nullptr;
+}
+
+SMCApi::IFlowControlTool* SMCApi::MockExecutionContextTool::getFlowControlTool() {
+    return pFlowControlTool;
+}
+
+bool SMCApi::MockExecutionContextTool::isNeedStop() {
+    return needStop;
+}
+
+SMCApi::CFGIExecutionContext* SMCApi::MockExecutionContextTool::getExecutionContext() {
+    return pExecutionContext;
+}
+
+SMCApi::MockExecutionContextTool::~MockExecutionContextTool() {
+    clear();
+    for (auto message : output)
+        delete message;
+    output.clear();
+}
+
+std::string SMCApi::MockReport::toJson() const {
+    char buffer[1024];
+    snprintf(buffer, sizeof(buffer),
+             "{\"countProcess\":%lld,\"countMessagesIn\":%lld,\"countMessagesOut\":%lld,\"countErrors\":%lld,\"countExceptions\":%lld,"
+             "\"durationSeconds\":%.6f,\"processPerSecond\":%.3f,\"messagesInPerSecond\":%.3f,\"messagesOutPerSecond\":%.3f,"
+             "\"latencyMin\":%lld,\"latencyP50\":%lld,\"latencyP90\":%lld,\"latencyP99\":%lld,\"latencyP999\":%lld,\"latencyMax\":%lld}",
+             countProcess, countMessagesIn, countMessagesOut, countErrors, countExceptions, durationSeconds, processPerSecond,
+             messagesInPerSecond, messagesOutPerSecond, latencyMin, latencyP50, latencyP90, latencyP99, latencyP999, latencyMax);
+    return buffer;
+}
+
+SMCApi::MockHost::MockHost(const std::wstring& moduleName, const std::wstring& name, const std::wstring& homeFolder, const std::wstring& workDirectory)
+    : configuration(moduleName, name), executionContext(&configuration, name), flowControlTool(&configuration),
+      configurationTool(&configuration, &executionContext, homeFolder, workDirectory), executionContextTool(&executionContext, &flowControlTool),
+      pInstrumentation(nullptr) {
+}
+
+SMCApi::MockConfiguration* SMCApi::MockHost::getConfiguration() {
+    return &configuration;
+}
+
+SMCApi::MockExecutionContext* SMCApi::MockHost::getExecutionContext() {
+    return &executionContext;
+}
+
+SMCApi::MockConfigurationTool* SMCApi::MockHost::getConfigurationTool() {
+    return &configurationTool;
+}
+
+SMCApi::MockExecutionContextTool* SMCApi::MockHost::getExecutionContextTool() {
+    return &executionContextTool;
+}
+
+SMCApi::MockFlowControlTool* SMCApi::MockHost::getFlowControlTool() {
+    return &flowControlTool;
+}
+
+SMCApi::ValuePool* SMCApi::MockHost::getValueFactory() {
+    return &valuePool;
+}
+
+long SMCApi::MockHost::addSource(SMCApi::SourceGetType getType, long countLast, long messagesPerCall, const SMCApi::MockGenerator& generator) {
+    executionContext.sources.push_back(new MockSource(getType, countLast, messagesPerCall, generator));
+    return (long)executionContext.sources.size() - 1;
+}
+
+long SMCApi::MockHost::addManaged(const std::wstring& name, const SMCApi::MockManagedHandler& handler) {
+    return flowControlTool.addManaged(name, handler);
+}
+
+void SMCApi::MockHost::setInstrumentation(SMCApi::Instrumentation* instrumentation) {
+    pInstrumentation = instrumentation;
+    configurationTool.setInfo(L"instrumentation", [this](Value& value) {
+        if (pInstrumentation)
+            value.setValue(std::unique_ptr<ObjectArray>(pInstrumentation->snapshot()));
+        else
+            value.setValue(std::unique_ptr<ObjectArray>(new ObjectArray(ObjectType::OT_OBJECT_ELEMENT)));
+    });
+}
+
+SMCApi::MockReport SMCApi::MockHost::run(SMCApi::IMethod* method, const SMCApi::MockRunSettings& settings) {
+    typedef std::chrono::steady_clock Clock;
+    MockReport report;
+    LatencyHistogram latencies;
+    InstrumentedMethod instrumentedMethod(method, pInstrumentation);
+    if (pInstrumentation)
+        method = &instrumentedMethod;
+    executionContextTool.needStop = false;
+    long long int countMessagesStart = executionContextTool.countMessages;
+    long long int countErrorsStart = executionContextTool.countErrors;
+    long long int countExceptionsStart = flowControlTool.countExceptions;
+
+    configuration.active = true;
+    method->start(&configurationTool, &valuePool);
+    valuePool.reset();
+
+    Clock::time_point start = Clock::now();
+    Clock::time_point deadline = start + std::chrono::milliseconds(settings.durationMilliseconds);
+    Clock::duration period = settings.processPerSecond > 0
+                                 ? std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / settings.processPerSecond))
+                                 : Clock::duration::zero();
+    Clock::time_point next = start;
+    for (long long int i = 0; settings.iterations <= 0 || i < settings.iterations; i++) {
+        if (settings.durationMilliseconds > 0 && Clock::now() >= deadline)
+            break;
+        if (settings.iterations <= 0 && settings.durationMilliseconds <= 0)
+            break;
+        if (period != Clock::duration::zero()) {
+            std::this_thread::sleep_until(next);
+            next += period;
+        }
+        long long int date = currentDate();
+        for (auto source : executionContext.sources)
+            report.countMessagesIn += source->generate(date);
+
+        executionContext.active = true;
+        Clock::time_point processStart = Clock::now();
+        try {
+            method->process(&configurationTool, &executionContextTool, &valuePool);
+        } catch (ModuleException&) {
+            report.countExceptions++;
+        }
+        latencies.record(std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - processStart).count());
+        executionContext.active = false;
+        report.countProcess++;
+
+        executionContextTool.clear();
+        flowControlTool.clear();
+        valuePool.reset();
+        if (settings.updateEvery > 0 && (i + 1) % settings.updateEvery == 0) {
+            method->update(&configurationTool, &valuePool);
+            valuePool.reset();
+        }
+        if (executionContextTool.needStop)
+            break;
+    }
+    report.durationSeconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+    method->stop(&configurationTool, &valuePool);
+    valuePool.reset();
+    configuration.active = false;
+
+    report.countMessagesOut = executionContextTool.countMessages - countMessagesStart;
+    report.countErrors = executionContextTool.countErrors - countErrorsStart;
+    report.countExceptions += flowControlTool.countExceptions - countExceptionsStart;
+    if (report.durationSeconds > 0) {
+        report.processPerSecond = report.countProcess / report.durationSeconds;
+        report.messagesInPerSecond = report.countMessagesIn / report.durationSeconds;
+        report.messagesOutPerSecond = report.countMessagesOut / report.durationSeconds;
+    }
+    report.latencyMin = latencies.min();
+    report.latencyP50 = latencies.percentile(50);
+    report.latencyP90 = latencies.percentile(90);
+    report.latencyP99 = latencies.percentile(99);
+    report.latencyP999 = latencies.percentile(99.9);
+    report.latencyMax = latencies.max();
+    return report;
+}
@@ -0,0 +1,624 @@
+/*
+Library (provider c++), is a part of the platform Shelf MK (Shell for modular structures, SMC platform).
+The author and copyright holder of the software package (application) Shelf MK (Shell for modular structures, SMC platform) is Ulyanov Nikolay Vladimirovich (ulianownv@mail.ru).
+The following are prohibited: changing and distributing the program code, selling/reselling it, as well as other actions and rights not expressly permitted.
+*/
+
+#include "SMCApi.h"
+#include "SMCApiFile.h"
+#include "SMCApiMetrics.h"
+#include "SMCApiValue.h"
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <thread>
+
+#ifndef SMCMODULEDEFINITIONPROVIDER_SMCAPIMOCK_H
+#define SMCMODULEDEFINITIONPROVIDER_SMCAPIMOCK_H
+
+namespace SMCApi {
+    /**
+     * fill value of generated message
+     *
+     * @param index                 serial number of message in source
+     * @param value                 value for fill
+     */
+    typedef std::function<void(long long int, Value&)> MockGenerator;
+
+    /**
+     * work of managed execution context
+     *
+     * @param type                  command type
+     * @param values                input values or null
+     * @param factory               factory for output values
+     * @param result                output values
+     */
+    typedef std::function<void(CommandType, std::vector<IValue*>*, IValueFactory*, std::vector<IValue*>&)> MockManagedHandler;
+
+    /**
+     * message of mock host
+     *
+     * @version 1.0.0
+     */
+    class CLASS_DECLSPEC MockMessage : public IMessage {
+    private:
+        Value value;
+        long long int date;
+        MessageType messageType;
+
+    public:
+        MockMessage(long long int date, MessageType messageType);
+
+        Value& getValue();
+
+        ValueType getType() override;
+
+        std::wstring* getValueString() override;
+
+        Number* getValueNumber() override;
+
+        signed char* getValueBytes() override;
+
+        size_t getBytesCount() override;
+
+        bool getValueBoolean() override;
+
+        ObjectArray* getValueObjectArray() override;
+
+        long long int getDate() override;
+
+        MessageType getMessageType() override;
+
+        virtual ~MockMessage();
+    };
+
+    /**
+     * action of mock host
+     * not owns messages
+     *
+     * @version 1.0.0
+     */
+    class CLASS_DECLSPEC MockAction : public IAction {
+    private:
+        std::vector<IMessage*> messages;
+        ActionType type;
+
+    public:
+        explicit MockAction(ActionType type);
+
+        std::vector<IMessage*>* getMessages() override;
+
+        ActionType getType() override;
+
+        virtual ~MockAction();
+    };
+
+    /**
+     * command of mock host
+     * owns actions
+     *
+     * @version 1.0.0
+     */
+    class CLASS_DECLSPEC MockCommand : public ICommand {
+    private:
+        std::vector<IAction*> actions;
+        CommandType type;
+
+    public:
+        explicit MockCommand(CommandType type);
+
+        std::vector<IAction*>* getActions() override;
+
+        CommandType getType() override;
+
+        virtual ~MockCommand();
+    };
+
+    /**
+     * module of mock host
+     *
+     * @version 1.0.0
+     */
+    class CLASS_DECLSPEC MockModule : public CFGIModule {
+    private:
+        std::wstring name;
+
+    public:
+        explicit MockModule(const std::wstring& name);
+
+        std::wstring getName() override;
+
+        long countTypes() override;
+
+        std::wstring getTypeName(long typeId) override;
+
+        long getMinCountSources(long typeId) override;
+
+        long getMaxCountSources(long typeId) override;
+
+        long getMinCountExecutionContexts(long typeId) override;
+
+        long getMaxCountExecutionContexts(long typeId) override;
+
+        long getMinCountManagedConfigurations(long typeId) override;
+
+        long getMaxCountManagedConfigurations(long typeId) override;
+    };
+
+    /**
+     * configuration of mock host
+     *
+     * @version 1.0.0
+     */
+    class CLASS_DECLSPEC MockConfiguration : public CFGIConfiguration {
+    private:
+        MockModule module;
+        std::wstring name;
+
+    public:
+        std::wstring description;
+        long bufferSize;
+        long long int threadBufferSize;
+        bool enable;
+        std::atomic<bool> active;
+
+        MockConfiguration(const std::wstring& moduleName, const std::wstring& name);
+
+        CFGIModule* getModule() override;
+
+        std::wstring getName() override;
+
+        std::wstring getDescription() override;
+
+        long getBufferSize() override;
+
+        int long long getThreadBufferSize() override;
+
+        bool isEnable() override;
+
+        bool isActive() override;
+    };
+
+    /**
+     * synthetic source
+     * every process call generate messagesPerCall new messages, what messages are visible depends on getType:
+     * SGT_NEW, SGT_NEW_ALL - only new, SGT_LAST, SGT_LAST_ALL - last countLast, SGT_ALL - all generated
+     *
+     * @version 1.0.0
+     */
+    class CLASS_DECLSPEC MockSource : public CFGISource {
+    private:
+        SourceGetType sourceGetType;
+        long countLast;
+        bool eventDriven;
+        long messagesPerCall;
+        MockGenerator generator;
+        long long int counter;
+        std::deque<MockMessage*> messages;
+        MockAction* pAction;
+
+    public:
+        MockSource(SourceGetType getType, long countLast, long messagesPerCall, const MockGenerator& generator);
+
+        /**
+         * generate new messages and build action
+         *
+         * @param date                  date of new messages
+         * @return count of new messages
+         */
+        long generate(long long int date);
+
+        /**
+         * current action
+         *
+         * @return MockAction or null if no messages
+         */
+        MockAction* getAction();
+
+        SourceType getType() override;
+
+        long countParams() override;
+
+        void* getParam(long id) override;
+
+        long countFilters() override;
+
+        CFGISourceFilter* getFilter(long id) override;
+
+        virtual ~MockSource();
+    };
+
+    /**
+     * execution context of mock host
+     *
+     * @version 1.0.0
+     */
+    class CLASS_DECLSPEC MockExecutionContext : public CFGIExecutionContext {
+    private:
+        MockConfiguration* pConfiguration;
+        std::wstring name;
+
+    public:
+        std::vector<MockSource*> sources;
+        long maxWorkInterval;
+        bool enable;
+        std::atomic<bool> active;
+        std::wstring type;
+
+        MockExecutionContext(MockConfiguration* pConfiguration, const std::wstring& name);
+
+        long countSource() override;
+
+        CFGISource* getSource(long id) override;
+
+        CFGIConfiguration* getConfiguration() override;
+
+        std::wstring getName() override;
+
+        long getMaxWorkInterval() override;
+
+        bool isEnable() override;
+
+        bool isActive() override;
+
+        std::wstring getType() override;
+
+        virtual ~MockExecutionContext();
+    };
+
+    /**
+     * configuration tool of mock host
+     * settings and variables are stored in memory, log is written to stderr
+     *
+     * @version 1.0.0
+     */
+    class CLASS_DECLSPEC MockConfigurationTool : public IConfigurationTool {
+    private:
+        MockConfiguration* pConfiguration;
+        MockExecutionContext* pExecutionContext;
+        std::map<std::wstring, Value*> settings;
+        std::map<std::wstring, Value*> variables;
+        std::map<std::wstring, bool> changedVariables;
+        std::map<std::wstring, std::function<void(Value&)>> infoProviders;
+        Value info;
+        FileTool* pHomeFolder;
+        std::wstring workDirectory;
+        std::mutex mutex;
+
+    public:
+        /**
+         * minimum logged level: 0 - trace, 1 - debug, 2 - info, 3 - warn, 4 - error, 5 - nothing
+         */
+        int logLevel;
+
+        MockConfigurationTool(MockConfiguration* pConfiguration, MockExecutionContext* pExecutionContext, const std::wstring& homeFolder,
+                              const std::wstring& workDirectory);
+
+        /**
+         * set setting, value is copied
+         */
+        void setSetting(const std::wstring& key, IValue* value);
+
+        /**
+         * set variable as external change (user or other process)
+         */
+        void setVariableExternal(const std::wstring& key, IValue* value);
+
+        /**
+         * register info for getInfo
+         *
+         * @param key                   name
+         * @param provider              fill value on every getInfo call
+         */
+        void setInfo(const std::wstring& key, const std::function<void(Value&)>& provider);
+
+        std::vector<std::wstring> getAllSettingNames() override;
+
+        IValue* getSetting(const std::wstring& key) override;
+
+        std::vector<std::wstring> getAllVariableNames() override;
+
+        IValue* getVariable(const std::wstring& key) override;
+
+        void setVariable(const std::wstring& key, IValue* value) override;
+
+        bool isVariableChanged(const std::wstring& key) override;
+
+        void removeVariable(const std::wstring& key) override;
+
+        IFileTool* getHomeFolder() override;
+
+        std::wstring getWorkDirectory() override;
+
+        long countExecutionContexts() override;
+
+        CFGIExecutionContext* getExecutionContext(long id) override;
+
+        CFGIConfiguration* getConfiguration() override;
+
+        CFGIContainerManaged* getContainer() override;
+
+        void loggerTrace(const std::wstring& text) override;
+
+        void loggerDebug(const std::wstring& text) override;
+
+        void loggerInfo(const std::wstring& text) override;
+
+        void loggerWarn(const std::wstring& text) override;
+
+        void loggerError(const std::wstring& text) override;
+
+        IValue* getInfo(const std::wstring& key) override;
+
+        virtual ~MockConfigurationTool();
+    };
+
+    /**
+     * flow control tool of mock host
+     * managed execution contexts are simulated by handlers, executeParallel start real threads
+     * one tact is tactMilliseconds, maxWorkInterval of executeParallel is not controlled
+     *
+     * @version 1.0.0
+     */
+    class CLASS_DECLSPEC MockFlowControlTool : public IFlowControlTool {
+    private:
+        struct Managed;
+        struct Thread;
+
+        MockConfiguration* pConfiguration;
+        std::vector<Managed*> managed;
+        std::map<long long int, Thread*> threads;
+        long long int lastThreadId;
+        std::mutex mutex;
+
+        Thread* findThread(long long int threadId);
+
+    public:
+        long tactMilliseconds;
+        /**
+         * count of exceptions of handlers in threads of executeParallel, result of thread is action with error message
+         */
+        std::atomic<long long int> countExceptions;
+
+        explicit MockFlowControlTool(MockConfiguration* pConfiguration);
+
+        /**
+         * add managed execution context
+         *
+         * @param name                  name
+         * @param handler               work of context
+         * @return id of managed execution context
+         */
+        long addManaged(const std::wstring& name, const MockManagedHandler& handler);
+
+        /**
+         * delete results of executeNow
+         */
+        void clear();
+
+        long countManagedExecutionContexts() override;
+
+        void executeNow(CommandType type, long managedId, std::vector<IValue*>* values) override;
+
+        long long int executeParallel(CommandType type, long managedId, std::vector<IValue*>* values, long waitingTacts, long maxWorkInterval) override;
+
+        bool isThreadActive(long long int threadId) override;
+
+        std::vector<IAction*>* getMessagesFromExecuted(long managedId) override;
+
+        std::vector<IAction*>* getMessagesFromExecuted(long long int threadId, long managedId) override;
+
+        std::vector<ICommand*>* getCommandsFromExecuted(long managedId) override;
+
+        std::vector<ICommand*>* getCommandsFromExecuted(long long int threadId, long managedId) override;
+
+        void releaseThread(long long int threadId) override;
+
+        void releaseThreadCache(long long int threadId) override;
+
+        CFGIExecutionContext* getManagedExecutionContext(int id) override;
+
+        virtual ~MockFlowControlTool();
+    };
+
+    /**
+     * execution context tool of mock host
+     * emitted messages are counted and, if keepOutput, copied
+     *
+     * @version 1.0.0
+     */
+    class CLASS_DECLSPEC MockExecutionContextTool : public IExecutionContextTool {
+    private:
+        MockExecutionContext* pExecutionContext;
+        MockFlowControlTool* pFlowControlTool;
+        std::vector<IAction*> actions;
+        std::vector<ICommand*> commands;
+        std::vector<MockCommand*> createdCommands;
+
+    public:
+        bool keepOutput;
+        std::vector<MockMessage*> output;
+        std::atomic<bool> needStop;
+        long long int countMessages;
+        long long int countErrors;
+        long long int countLogs;
+
+        MockExecutionContextTool(MockExecutionContext* pExecutionContext, MockFlowControlTool* pFlowControlTool);
+
+        /**
+         * delete commands, created in last process call
+         */
+        void clear();
+
+        void addMessage(IValue* value) override;
+
+        void addError(IValue* value) override;
+
+        void addLog(const std::wstring& text) override;
+
+        long countCommands(long sourceId) override;
+
+        long countCommands(CFGIExecutionContextManaged* executionContext) override;
+
+        std::vector<IAction*>* getMessages(long sourceId) override;
+
+        std::vector<IAction*>* getMessages(long sourceId, long fromIndex, long toIndex) override;
+
+        std::vector<ICommand*>* getCommands(long sourceId) override;
+
+        std::vector<ICommand*>* getCommands(long sourceId, long fromIndex, long toIndex) override;
+
+        std::vector<ICommand*>* getCommands(CFGIExecutionContextManaged* executionContext, long fromIndex, long toIndex) override;
+
+        bool isError(IAction* action) override;
+
+        IConfigurationControlTool* getConfigurationControlTool() override;
+
+        IFlowControlTool* getFlowControlTool() override;
+
+        bool isNeedStop() override;
+
+        CFGIExecutionContext* getExecutionContext() override;
+
+        virtual ~MockExecutionContextTool();
+    };
+
+    /**
+     * settings of mock run
+     *
+     * @version 1.0.0
+     */
+    struct CLASS_DECLSPEC MockRunSettings {
+        /**
+         * count of process calls, if 0 - limited only by duration
+         */
+        long long int iterations = 1000;
+
+        /**
+         * max duration in milliseconds, if 0 - limited only by iterations
+         */
+        long long int durationMilliseconds = 0;
+
+        /**
+         * process calls per second, if 0 - without limit
+         */
+        double processPerSecond = 0;
+
+        /**
+         * call update after every updateEvery process calls, if 0 - never
+         */
+        long long int updateEvery = 0;
+    };
+
+    /**
+     * result of mock run
+     * latencies of process call in nanoseconds, percentiles are taken from LatencyHistogram
+     *
+     * @version 1.0.0
+     */
+    struct CLASS_DECLSPEC MockReport {
+        long long int countProcess = 0;
+        long long int countMessagesIn = 0;
+        long long int countMessagesOut = 0;
+        long long int countErrors = 0;
+        long long int countExceptions = 0;
+        double durationSeconds = 0;
+        double processPerSecond = 0;
+        double messagesInPerSecond = 0;
+        double messagesOutPerSecond = 0;
+        long long int latencyMin = 0;
+        long long int latencyP50 = 0;
+        long long int latencyP90 = 0;
+        long long int latencyP99 = 0;
+        long long int latencyP999 = 0;
+        long long int latencyMax = 0;
+
+        /**
+         * report as one line JSON
+         *
+         * @return string
+         */
+        std::string toJson() const;
+    };
+
+    /**
+     * in process stand-in of platform for run module without deploy
+     * drive IMethod start/process/update/stop with synthetic sources
+     *
+     * @version 1.0.0
+     */
+    class CLASS_DECLSPEC MockHost {
+    private:
+        MockConfiguration configuration;
+        MockExecutionContext executionContext;
+        MockFlowControlTool flowControlTool;
+        MockConfigurationTool configurationTool;
+        MockExecutionContextTool executionContextTool;
+        ValuePool valuePool;
+        Instrumentation* pInstrumentation;
+
+    public:
+        /**
+         * @param moduleName            module name
+         * @param name                  configuration name
+         * @param homeFolder            module home folder (getHomeFolder)
+         * @param workDirectory         work directory (getWorkDirectory)
+         */
+        MockHost(const std::wstring& moduleName, const std::wstring& name, const std::wstring& homeFolder = L".",
+                 const std::wstring& workDirectory = L".");
+
+        MockConfiguration* getConfiguration();
+
+        MockExecutionContext* getExecutionContext();
+
+        MockConfigurationTool* getConfigurationTool();
+
+        MockExecutionContextTool* getExecutionContextTool();
+
+        MockFlowControlTool* getFlowControlTool();
+
+        ValuePool* getValueFactory();
+
+        /**
+         * add synthetic source
+         *
+         * @param getType               type of get commands from source
+         * @param countLast             only for SGT_LAST, SGT_LAST_ALL
+         * @param messagesPerCall       count of new messages for every process call
+         * @param generator             fill new messages
+         * @return source id
+         */
+        long addSource(SourceGetType getType, long countLast, long messagesPerCall, const MockGenerator& generator);
+
+        /**
+         * add managed execution context
+         *
+         * @param name                  name
+         * @param handler               work of context
+         * @return id of managed execution context
+         */
+        long addManaged(const std::wstring& name, const MockManagedHandler& handler);
+
+        /**
+         * collect metrics of module in run
+         * snapshot is available by getInfo(L"instrumentation")
+         *
+         * @param instrumentation       metrics registry, not owned, null for disable
+         */
+        void setInstrumentation(Instrumentation* instrumentation);
+
+        /**
+         * run module
+         * exceptions from start, update, stop are passed to caller, from process - counted
+         *
+         * @param method                module
+         * @param settings              run settings
+         * @return MockReport
+         */
+        MockReport run(IMethod* method, const MockRunSettings& settings);
+    };
+}
+
+#endif //SMCMODULEDEFINITIONPROVIDER_SMCAPIMOCK_H